@@ -0,0 +1,182 @@
+#ifndef BT_BENCHMARK_UTILS_H
+#define BT_BENCHMARK_UTILS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "behaviortree_cpp/behavior_tree.h"
+#include "behaviortree_cpp/tick_monitor.h"
+
+/*
+ * Helpers shared by the benchmarks.
+ *
+ * This file replaces the global operator new, to count the allocations:
+ * include it in a single translation unit of each executable.
+ */
+
+static std::atomic<uint64_t> allocation_count(0);
+
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size != 0 ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+namespace BT
+{
+/// Number of allocations done by the process so far.
+inline uint64_t allocationCount()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+/// Average number of nodes ticked by executeTick() of the root, measured on a few ticks.
+inline double visitedNodesPerTick(TreeNode* root_node, int ticks = 64)
+{
+    struct VisitCounter : public TickMonitor
+    {
+        size_t visits = 0;
+        void onTick(const TreeNode&, size_t, MonitorTime, std::chrono::nanoseconds,
+                    NodeStatus) override
+        {
+            visits++;
+        }
+    } counter;
+
+    applyRecursiveVisitor(root_node, [&counter](TreeNode* node) { node->addTickMonitor(&counter); });
+    for (int i = 0; i < ticks; i++)
+    {
+        root_node->executeTick();
+    }
+    applyRecursiveVisitor(root_node,
+                          [&counter](TreeNode* node) { node->removeTickMonitor(&counter); });
+    haltAllActions(root_node);
+    return double(counter.visits) / ticks;
+}
+
+/// Numbers of threads listed in the environment variable BT_BENCH_THREADS (default "1,2,4,8").
+inline std::vector<int> benchmarkThreadCounts()
+{
+    std::vector<int> counts;
+    const char* env = std::getenv("BT_BENCH_THREADS");
+    std::string list = env ? env : "1,2,4,8";
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos)
+        {
+            comma = list.size();
+        }
+        const int count = std::atoi(list.substr(pos, comma - pos).c_str());
+        if (count > 0)
+        {
+            counts.push_back(count);
+        }
+        pos = comma + 1;
+    }
+    return counts;
+}
+
+/// Pin the calling thread to a CPU, chosen by index modulo the number of CPUs.
+inline void pinThisThread(unsigned index)
+{
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+ * Collects latency samples and reports their percentiles as counters:
+ * p50_us, p90_us, p99_us and max_us.
+ *
+ * Memory is reserved in advance: adding a sample doesn't allocate.
+ */
+class LatencyRecorder
+{
+  public:
+    explicit LatencyRecorder(size_t capacity = 1 << 20)
+    {
+        samples_.reserve(capacity);
+    }
+
+    void add(std::chrono::nanoseconds latency)
+    {
+        if (samples_.size() < samples_.capacity())
+        {
+            samples_.push_back(latency.count());
+        }
+    }
+
+    /// Percentile in microseconds, 0 <= fraction <= 1. Sorts the samples.
+    double percentile(double fraction)
+    {
+        if (samples_.empty())
+        {
+            return 0;
+        }
+        const size_t index = std::min(samples_.size() - 1,
+                                      static_cast<size_t>(fraction * samples_.size()));
+        std::nth_element(samples_.begin(), samples_.begin() + index, samples_.end());
+        return samples_[index] * 1e-3;
+    }
+
+    /// With many threads, the percentiles of each thread are averaged.
+    void report(benchmark::State& state)
+    {
+        const auto flags = benchmark::Counter::kAvgThreads;
+        state.counters["p50_us"] = benchmark::Counter(percentile(0.50), flags);
+        state.counters["p90_us"] = benchmark::Counter(percentile(0.90), flags);
+        state.counters["p99_us"] = benchmark::Counter(percentile(0.99), flags);
+        state.counters["max_us"] = benchmark::Counter(percentile(1.0), flags);
+    }
+
+  private:
+    std::vector<int64_t> samples_;
+};
+
+/**
+ * Tick the root node in the benchmark loop and report:
+ *  - ticks_per_second;
+ *  - ns_per_node: time of a tick divided by the number of nodes it visits;
+ *  - allocs_per_tick.
+ */
+inline void runTickLoop(benchmark::State& state, TreeNode* root_node)
+{
+    const double visited = visitedNodesPerTick(root_node);
+
+    const uint64_t allocations_before = allocationCount();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(root_node->executeTick());
+    }
+    const uint64_t allocations = allocationCount() - allocations_before;
+
+    state.counters["visited_nodes"] = visited;
+    state.counters["ticks_per_second"] =
+        benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["ns_per_node"] = benchmark::Counter(
+        visited, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["allocs_per_tick"] =
+        benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+}
+
+#endif   // BT_BENCHMARK_UTILS_H
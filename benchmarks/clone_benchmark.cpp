@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
+
+using namespace BT;
+
+// Tree with (1 + 10 * branches) nodes, including SubTrees and NodeParameters
+static std::string createTreeXML(int branches)
+{
+    std::string xml;
+    xml += "<root main_tree_to_execute=\"MainTree\">\n";
+    xml += "  <BehaviorTree ID=\"Branch\">\n"
+           "    <Fallback>\n"
+           "      <RetryUntilSuccesful num_attempts=\"3\">\n"
+           "        <AlwaysFailure/>\n"
+           "      </RetryUntilSuccesful>\n"
+           "      <SetBlackboard key=\"value\" value=\"42\"/>\n"
+           "      <AlwaysSuccess/>\n"
+           "    </Fallback>\n"
+           "  </BehaviorTree>\n";
+
+    xml += "  <BehaviorTree ID=\"MainTree\">\n    <Sequence>\n";
+    for (int i = 0; i < branches; i++)
+    {
+        xml += "      <Sequence>\n"
+               "        <SubTree ID=\"Branch\"/>\n"
+               "        <Inverter><AlwaysFailure/></Inverter>\n"
+               "        <AlwaysSuccess/>\n"
+               "      </Sequence>\n";
+    }
+    xml += "    </Sequence>\n  </BehaviorTree>\n</root>\n";
+    return xml;
+}
+
+static void BM_BuildTreeFromText(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    const std::string xml = createTreeXML(state.range(0));
+
+    size_t nodes = 0;
+    for (auto _ : state)
+    {
+        auto blackboard = Blackboard::create<BlackboardLocal>();
+        Tree tree = buildTreeFromText(factory, xml, blackboard);
+        nodes = tree.nodes.size();
+    }
+    state.counters["nodes"] = nodes;
+}
+
+static void BM_CloneTree(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    const std::string xml = createTreeXML(state.range(0));
+    Tree tree = buildTreeFromText(factory, xml, Blackboard::create<BlackboardLocal>());
+
+    for (auto _ : state)
+    {
+        auto blackboard = Blackboard::create<BlackboardLocal>();
+        Tree copy = tree.clone(blackboard);
+        benchmark::DoNotOptimize(copy.root_node);
+    }
+    state.counters["nodes"] = tree.nodes.size();
+}
+
+BENCHMARK(BM_BuildTreeFromText)->Arg(10)->Arg(100)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CloneTree)->Arg(10)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,366 @@
+#include <memory>
+#include <mutex>
+#include "benchmark_utils.h"
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/decorators/timeout_node.h"
+#include "behaviortree_cpp/controls/parallel_node.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
+
+using namespace BT;
+
+/*
+ * Latency of the nodes that involve more than one thread:
+ *
+ *   AsyncActionStart    from executeTick() of an AsyncActionNode to the
+ *                       beginning of its tick() in the thread of the node
+ *   CoroResume          executeTick() of a CoroActionNode that yields
+ *   TimeoutExpiry       delay of the halt() of the child of a TimeoutNode
+ *                       after the expiration of the timeout
+ *   BlackboardContention  get() and set() of a BlackboardLocal shared by
+ *                       many threads
+ *   ParallelTick        executeTick() of a ParallelNode with (threads)
+ *                       children busy for 100 us each, ticked one after the
+ *                       other or concurrently
+ *
+ * Each benchmark runs with the number of threads listed in the environment
+ * variable BT_BENCH_THREADS (default "1,2,4,8") and reports the percentiles
+ * of the latency. Thread i is pinned to the CPU (i % number of CPUs), the
+ * thread that ticks the tree to the CPU 0: with more threads than CPUs,
+ * the latency includes the time spent waiting for a CPU.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static void spinFor(std::chrono::nanoseconds duration)
+{
+    const auto deadline = Clock::now() + duration;
+    while (Clock::now() < deadline)
+    {
+    }
+}
+
+// Its tick() takes (work) nanoseconds, to keep its thread busy.
+class AsyncProbe : public AsyncActionNode
+{
+  public:
+    AsyncProbe(const std::string& name, unsigned cpu, std::chrono::nanoseconds work)
+      : AsyncActionNode(name), cpu_(cpu), work_(work), pinned_(false)
+    {
+    }
+
+    ~AsyncProbe() override
+    {
+        stopAndJoinThread();
+    }
+
+    NodeStatus tick() override
+    {
+        if (!pinned_)
+        {
+            pinThisThread(cpu_);
+            pinned_ = true;
+        }
+        // read by the other thread after the change of status
+        started_at = Clock::now();
+        spinFor(work_);
+        return NodeStatus::SUCCESS;
+    }
+
+    void halt() override
+    {
+        setStatus(NodeStatus::IDLE);
+    }
+
+    Clock::time_point started_at;
+
+  private:
+    unsigned cpu_;
+    std::chrono::nanoseconds work_;
+    bool pinned_;
+};
+
+// Arg: number of AsyncActionNodes, started one after the other at each
+// iteration, like the children of a Sequence of ParallelNode.
+static void BM_AsyncActionStart(benchmark::State& state, int actions)
+{
+    pinThisThread(0);
+    std::vector<std::unique_ptr<AsyncProbe>> probes;
+    for (int i = 0; i < actions; i++)
+    {
+        probes.emplace_back(new AsyncProbe("probe_" + std::to_string(i), i + 1,
+                                           std::chrono::microseconds(5)));
+    }
+
+    LatencyRecorder latency;
+    std::vector<Clock::time_point> notified_at(probes.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < probes.size(); i++)
+        {
+            notified_at[i] = Clock::now();
+            probes[i]->executeTick();
+        }
+        for (size_t i = 0; i < probes.size(); i++)
+        {
+            while (probes[i]->status() != NodeStatus::SUCCESS)
+            {
+                std::this_thread::yield();
+            }
+            latency.add(probes[i]->started_at - notified_at[i]);
+            probes[i]->setStatus(NodeStatus::IDLE);
+        }
+    }
+    latency.report(state);
+    state.counters["starts_per_second"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * probes.size()), benchmark::Counter::kIsRate);
+}
+
+// An action that never completes.
+class EndlessCoro : public CoroActionNode
+{
+  public:
+    EndlessCoro(const std::string& name) : CoroActionNode(name)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        while (true)
+        {
+            setStatusRunningAndYield();
+        }
+    }
+};
+
+// Each thread ticks its own CoroActionNode.
+static void BM_CoroResume(benchmark::State& state)
+{
+    pinThisThread(state.thread_index());
+    EndlessCoro action("coro");
+    action.executeTick();   // creates the coroutine
+
+    LatencyRecorder latency;
+    for (auto _ : state)
+    {
+        const auto start = Clock::now();
+        benchmark::DoNotOptimize(action.executeTick());
+        latency.add(Clock::now() - start);
+    }
+    action.halt();
+    latency.report(state);
+}
+
+// A child of TimeoutNode that stays RUNNING until halted.
+class HaltProbe : public ActionNodeBase
+{
+  public:
+    HaltProbe(const std::string& name) : ActionNodeBase(name, {}), halted(false)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        if (status() == NodeStatus::IDLE)
+        {
+            ticked_at = Clock::now();
+        }
+        return NodeStatus::RUNNING;
+    }
+
+    void halt() override
+    {
+        halted_at = Clock::now();
+        setStatus(NodeStatus::IDLE);
+        halted = true;
+    }
+
+    Clock::time_point ticked_at;
+    Clock::time_point halted_at;
+    std::atomic<bool> halted;
+};
+
+// Arg: number of TimeoutNodes (1 millisecond) started at each iteration.
+// The timers are shared by all the TimeoutNodes: a single thread halts the children.
+static void BM_TimeoutExpiry(benchmark::State& state, int timeouts)
+{
+    const unsigned msec = 1;
+    pinThisThread(0);
+    std::vector<std::unique_ptr<HaltProbe>> actions;
+    std::vector<std::unique_ptr<TimeoutNode>> timeout_nodes;
+    for (int i = 0; i < timeouts; i++)
+    {
+        actions.emplace_back(new HaltProbe("action_" + std::to_string(i)));
+        timeout_nodes.emplace_back(new TimeoutNode("timeout_" + std::to_string(i), msec));
+        timeout_nodes.back()->setChild(actions.back().get());
+    }
+
+    LatencyRecorder jitter;
+    for (auto _ : state)
+    {
+        for (auto& timeout : timeout_nodes)
+        {
+            timeout->executeTick();
+        }
+        for (auto& action : actions)
+        {
+            while (!action->halted)
+            {
+                std::this_thread::yield();
+            }
+            jitter.add(action->halted_at -
+                       (action->ticked_at + std::chrono::milliseconds(msec)));
+        }
+
+        state.PauseTiming();
+        for (size_t i = 0; i < timeout_nodes.size(); i++)
+        {
+            // The flag of the TimeoutNode is set after halt() of the child
+            while (timeout_nodes[i]->executeTick() != NodeStatus::FAILURE)
+            {
+                std::this_thread::yield();
+            }
+            actions[i]->setStatus(NodeStatus::IDLE);
+            actions[i]->halted = false;
+            timeout_nodes[i]->setStatus(NodeStatus::IDLE);
+        }
+        state.ResumeTiming();
+    }
+    jitter.report(state);
+}
+
+// BlackboardLocal has no lock: with writers, every access takes this mutex.
+static Blackboard::Ptr shared_blackboard;
+static std::mutex shared_blackboard_mutex;
+static const int NUM_KEYS = 64;
+
+// Arg: percentage of writes. Each thread accesses random keys.
+static void BM_BlackboardContention(benchmark::State& state)
+{
+    pinThisThread(state.thread_index());
+    const int64_t write_percent = state.range(0);
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        keys.push_back("key_" + std::to_string(i));
+    }
+    if (state.thread_index() == 0)
+    {
+        shared_blackboard = Blackboard::create<BlackboardLocal>();
+        for (int i = 0; i < NUM_KEYS; i++)
+        {
+            shared_blackboard->set(keys[i], i);
+        }
+    }
+
+    // xorshift: the choice of the key must be cheaper than the access
+    uint32_t random = 2463534242u + static_cast<uint32_t>(state.thread_index());
+    LatencyRecorder latency;
+    int value = 0;
+    for (auto _ : state)
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        const std::string& key = keys[random % NUM_KEYS];
+        const bool write = static_cast<int64_t>(random % 100) < write_percent;
+
+        const auto start = Clock::now();
+        if (write_percent == 0)
+        {
+            shared_blackboard->get(key, value);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(shared_blackboard_mutex);
+            if (write)
+            {
+                shared_blackboard->set(key, value + 1);
+            }
+            else
+            {
+                shared_blackboard->get(key, value);
+            }
+        }
+        latency.add(Clock::now() - start);
+        benchmark::DoNotOptimize(value);
+    }
+    latency.report(state);
+
+    if (state.thread_index() == 0)
+    {
+        shared_blackboard.reset();
+    }
+}
+
+// Arg: 1 for a concurrent ParallelNode.
+static void BM_ParallelTick(benchmark::State& state, int children)
+{
+    const std::chrono::microseconds work(100);
+    ParallelNode root("root", children);
+    root.setConcurrent(state.range(0) != 0);
+    std::vector<std::unique_ptr<SimpleActionNode>> actions;
+    for (int i = 0; i < children; i++)
+    {
+        actions.emplace_back(new SimpleActionNode("action", [work](TreeNode&) {
+            spinFor(work);
+            return NodeStatus::SUCCESS;
+        }));
+        root.addChild(actions.back().get());
+    }
+
+    LatencyRecorder latency;
+    for (auto _ : state)
+    {
+        const auto start = Clock::now();
+        root.executeTick();
+        latency.add(Clock::now() - start);
+    }
+    latency.report(state);
+}
+
+int main(int argc, char** argv)
+{
+    const std::vector<int> thread_counts = benchmarkThreadCounts();
+    for (int threads : thread_counts)
+    {
+        const std::string suffix = "/threads:" + std::to_string(threads);
+        benchmark::RegisterBenchmark(("BM_AsyncActionStart" + suffix).c_str(),
+                                     BM_AsyncActionStart, threads)
+            ->UseRealTime()
+            ->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("BM_TimeoutExpiry" + suffix).c_str(), BM_TimeoutExpiry,
+                                     threads)
+            ->UseRealTime()
+            ->Unit(benchmark::kMillisecond);
+    }
+    for (int threads : thread_counts)
+    {
+        benchmark::RegisterBenchmark("BM_CoroResume", BM_CoroResume)->Threads(threads);
+    }
+    for (int threads : thread_counts)
+    {
+        benchmark::RegisterBenchmark("BM_BlackboardContention", BM_BlackboardContention)
+            ->Arg(0)
+            ->Arg(10)
+            ->Threads(threads)
+            ->UseRealTime();
+    }
+    for (int threads : thread_counts)
+    {
+        benchmark::RegisterBenchmark(("BM_ParallelTick/threads:" + std::to_string(threads)).c_str(),
+                                     BM_ParallelTick, threads)
+            ->Arg(0)
+            ->Arg(1)
+            ->UseRealTime()
+            ->Unit(benchmark::kMicrosecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <thread>
+#include "benchmark_utils.h"
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/tree_executor.h"
+
+using namespace BT;
+
+/*
+ * Throughput of TreeExecutor: (trees) copies of a small tree that is always
+ * RUNNING are ticked by (threads) workers, each worker pinned to a CPU.
+ *
+ *   period 0      the trees are ticked as fast as possible
+ *   period 10 ms  the demand is 100 * (trees) ticks per second; "load" is the
+ *                 fraction actually ticked (1 when the executor keeps up)
+ *
+ * trees_per_s counts the trees ticked per second, trees_per_s_per_thread the
+ * same divided by the number of workers. The numbers of threads are set with
+ * BT_BENCH_THREADS (default "1,2,4,8").
+ */
+
+// clang-format off
+static const char* xml_text = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <Inverter><AlwaysFailure/></Inverter>
+            <Fallback>
+                <AlwaysFailure/>
+                <AlwaysSuccess/>
+            </Fallback>
+            <Step/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+static void BM_TreeExecutor(benchmark::State& state, int threads, int tree_count,
+                            std::chrono::microseconds period)
+{
+    BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Step", [](TreeNode&) { return NodeStatus::RUNNING; });
+    const Tree prototype = buildTreeFromText(factory, xml_text);
+    std::vector<Tree> trees;
+    trees.reserve(tree_count);
+    for (int i = 0; i < tree_count; i++)
+    {
+        trees.push_back(prototype.clone(Blackboard::Ptr()));
+    }
+
+    TreeExecutorOptions options(threads);
+    for (int i = 0; i < threads; i++)
+    {
+        options.worker_cpus.push_back(i % std::max(1u, std::thread::hardware_concurrency()));
+    }
+    TreeExecutor executor(options);
+    for (const auto& tree : trees)
+    {
+        executor.add(tree.root_node, TreeScheduleHints(period));
+    }
+    // warm up: every tree ticked at least once
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    const uint64_t ticks_before = executor.ticks();
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : state)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    const double elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double ticks = double(executor.ticks() - ticks_before);
+
+    state.counters["trees_per_s"] = benchmark::Counter(ticks, benchmark::Counter::kIsRate);
+    state.counters["trees_per_s_per_thread"] =
+        benchmark::Counter(ticks / threads, benchmark::Counter::kIsRate);
+    if (period.count() > 0)
+    {
+        const double demand = elapsed * tree_count * 1e6 / period.count();
+        state.counters["load"] = ticks / demand;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    for (int threads : benchmarkThreadCounts())
+    {
+        for (int trees : {100, 10000})
+        {
+            for (int period_ms : {0, 10})
+            {
+                const std::string name = "BM_TreeExecutor/threads:" + std::to_string(threads) +
+                                         "/trees:" + std::to_string(trees) +
+                                         "/period_ms:" + std::to_string(period_ms);
+                benchmark::RegisterBenchmark(name.c_str(), BM_TreeExecutor, threads, trees,
+                                             std::chrono::milliseconds(period_ms))
+                    ->UseRealTime()
+                    ->Unit(benchmark::kMillisecond);
+            }
+        }
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
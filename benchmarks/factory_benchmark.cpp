@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include "behaviortree_cpp/bt_factory.h"
+
+using namespace BT;
+
+static const int NUM_TYPES = 2000;
+static const int NUM_NODES = 100000;
+
+static NodeStatus dummyTick(TreeNode&)
+{
+    return NodeStatus::SUCCESS;
+}
+
+static std::vector<std::string> registerTypes(BehaviorTreeFactory& factory)
+{
+    std::vector<std::string> IDs;
+    IDs.reserve(NUM_TYPES);
+    for (int i = 0; i < NUM_TYPES; i++)
+    {
+        IDs.push_back("Action_" + std::to_string(i));
+        factory.registerSimpleAction(IDs.back(), dummyTick);
+    }
+    return IDs;
+}
+
+static void BM_RegisterTypes(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        BehaviorTreeFactory factory;
+        registerTypes(factory);
+        benchmark::DoNotOptimize(factory.manifests().data());
+    }
+    state.counters["types"] = NUM_TYPES;
+}
+
+static void BM_InstantiateSimpleNodes(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    const std::vector<std::string> IDs = registerTypes(factory);
+    const NodeParameters params;
+    const Blackboard::Ptr blackboard;
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < NUM_NODES; i++)
+        {
+            const std::string& ID = IDs[i % NUM_TYPES];
+            auto node = factory.instantiateTreeNode(ID, ID, params, blackboard);
+            benchmark::DoNotOptimize(node.get());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_NODES);
+}
+
+// SetBlackboard has requiredNodeParameters()
+static void BM_InstantiateNodesWithParameters(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    const NodeParameters params = {{"key", "A"}, {"value", "42"}};
+    const NodeParameters empty_params;
+    const Blackboard::Ptr blackboard;
+    const std::string ID = "SetBlackboard";
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < NUM_NODES; i++)
+        {
+            auto node = factory.instantiateTreeNode(ID, ID, (i % 2) ? params : empty_params,
+                                                    blackboard);
+            benchmark::DoNotOptimize(node.get());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_NODES);
+}
+
+BENCHMARK(BM_RegisterTypes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_InstantiateSimpleNodes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_InstantiateNodesWithParameters)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
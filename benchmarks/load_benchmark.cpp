@@ -0,0 +1,276 @@
+#include <fstream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "benchmark_utils.h"
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/loggers/bt_flatbuffer_helper.h"
+#include "tinyXML2/tinyxml2.h"
+
+using namespace BT;
+
+/*
+ * The stages of the creation of a tree, measured separately:
+ *
+ *   Parse         tinyxml2 only, main file and included files
+ *   VerifyXML     XMLParser::loadFromText() minus the time of Parse
+ *   Instantiate   XMLParser::instantiateTree()
+ *   Flatbuffers   CreateFlatbuffersBehaviorTree(), done by the loggers
+ *   Destroy       destructor of Tree: haltAllActions() and deletion of the nodes
+ *
+ * The argument is the approximate number of nodes.
+ */
+
+static const int NUM_ACTION_TYPES = 100;
+static const int NUM_INCLUDED_FILES = 10;
+// nodes of each subtree
+static const int SUBTREE_SIZE = 100;
+
+struct SyntheticTree
+{
+    std::string main_xml;
+    std::vector<std::string> included_xml;
+};
+
+static NodeStatus dummyTick(TreeNode&)
+{
+    return NodeStatus::SUCCESS;
+}
+
+static void registerActions(BehaviorTreeFactory& factory)
+{
+    for (int i = 0; i < NUM_ACTION_TYPES; i++)
+    {
+        factory.registerSimpleAction("Action_" + std::to_string(i), dummyTick);
+    }
+}
+
+static std::string subtreeXML(int index)
+{
+    std::string xml = "  <BehaviorTree ID=\"Sub_" + std::to_string(index) + "\">\n    <Sequence>\n";
+    // 3 nodes for each step: Inverter, Action, AlwaysSuccess
+    for (int i = 0; i < (SUBTREE_SIZE - 1) / 3; i++)
+    {
+        xml += "      <Inverter><Action_" + std::to_string((index * 7 + i) % NUM_ACTION_TYPES) +
+               " name=\"action_" + std::to_string(i) + "\"/></Inverter>\n";
+        xml += "      <AlwaysSuccess/>\n";
+    }
+    xml += "    </Sequence>\n  </BehaviorTree>\n";
+    return xml;
+}
+
+// The included files are removed at exit
+static struct IncludedFiles
+{
+    std::string directory;
+    std::vector<std::string> filenames;
+
+    IncludedFiles() : directory("/tmp/bt_load_benchmark_" + std::to_string(getpid()))
+    {
+    }
+
+    ~IncludedFiles()
+    {
+        for (const auto& filename : filenames)
+        {
+            std::remove(filename.c_str());
+        }
+        rmdir(directory.c_str());
+    }
+} included_files;
+
+// The main tree is a Sequence of SubTrees; each of them is defined once,
+// in one of the included files.
+static SyntheticTree createSyntheticTree(int nodes)
+{
+    mkdir(included_files.directory.c_str(), 0755);
+
+    const int subtrees = std::max(1, nodes / SUBTREE_SIZE);
+    SyntheticTree tree;
+    for (int i = 0; i < NUM_INCLUDED_FILES; i++)
+    {
+        // required by the parser if a file contains more than one tree
+        tree.included_xml.push_back("<root main_tree_to_execute=\"Sub_" +
+                                    std::to_string(i % subtrees) + "\">\n");
+    }
+    for (int i = 0; i < subtrees; i++)
+    {
+        tree.included_xml[i % NUM_INCLUDED_FILES] += subtreeXML(i);
+    }
+
+    tree.main_xml = "<root main_tree_to_execute=\"MainTree\">\n";
+    for (int i = 0; i < NUM_INCLUDED_FILES; i++)
+    {
+        const std::string filename = included_files.directory + "/subtrees_" +
+                                     std::to_string(nodes) + "_" + std::to_string(i) + ".xml";
+        tree.included_xml[i] += "</root>\n";
+        std::ofstream(filename) << tree.included_xml[i];
+        included_files.filenames.push_back(filename);
+        tree.main_xml += "  <include path=\"" + filename + "\"/>\n";
+    }
+
+    tree.main_xml += "  <BehaviorTree ID=\"MainTree\">\n    <Sequence>\n";
+    for (int i = 0; i < subtrees; i++)
+    {
+        tree.main_xml += "      <SubTree ID=\"Sub_" + std::to_string(i) + "\"/>\n";
+    }
+    tree.main_xml += "    </Sequence>\n  </BehaviorTree>\n</root>\n";
+    return tree;
+}
+
+static double peakRSSMegabytes()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;   // kilobytes on Linux
+}
+
+static void setCounters(benchmark::State& state, size_t nodes)
+{
+    state.counters["nodes"] = static_cast<double>(nodes);
+    state.counters["ns_per_node"] = benchmark::Counter(
+        static_cast<double>(nodes),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    // of the whole process so far: the benchmarks run in order of size
+    state.counters["peak_rss_MB"] = peakRSSMegabytes();
+}
+
+static size_t countNodes(const BehaviorTreeFactory& factory, const SyntheticTree& synthetic)
+{
+    return buildTreeFromText(factory, synthetic.main_xml).nodes.size();
+}
+
+static void BM_Parse(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    registerActions(factory);
+    const SyntheticTree synthetic = createSyntheticTree(static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        tinyxml2::XMLDocument main_doc;
+        main_doc.Parse(synthetic.main_xml.c_str(), synthetic.main_xml.size());
+        for (const auto& xml : synthetic.included_xml)
+        {
+            tinyxml2::XMLDocument doc;
+            doc.Parse(xml.c_str(), xml.size());
+            benchmark::DoNotOptimize(doc.RootElement());
+        }
+        benchmark::DoNotOptimize(main_doc.RootElement());
+    }
+    setCounters(state, countNodes(factory, synthetic));
+}
+
+static void BM_VerifyXML(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    registerActions(factory);
+    const SyntheticTree synthetic = createSyntheticTree(static_cast<int>(state.range(0)));
+    typedef std::chrono::high_resolution_clock Clock;
+
+    for (auto _ : state)
+    {
+        const auto start = Clock::now();
+        {
+            tinyxml2::XMLDocument main_doc;
+            main_doc.Parse(synthetic.main_xml.c_str(), synthetic.main_xml.size());
+            for (const auto& xml : synthetic.included_xml)
+            {
+                tinyxml2::XMLDocument doc;
+                doc.Parse(xml.c_str(), xml.size());
+                benchmark::DoNotOptimize(doc.RootElement());
+            }
+        }
+        const auto parsed = Clock::now();
+        {
+            XMLParser parser(factory);
+            parser.loadFromText(synthetic.main_xml);
+        }
+        const auto loaded = Clock::now();
+
+        // the included files are read from the disk cache: it is counted here
+        const auto parse_time = parsed - start;
+        const auto load_time = loaded - parsed;
+        state.SetIterationTime(
+            std::chrono::duration<double>(std::max(load_time - parse_time, Clock::duration(0)))
+                .count());
+    }
+    setCounters(state, countNodes(factory, synthetic));
+}
+
+static void BM_Instantiate(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    registerActions(factory);
+    const SyntheticTree synthetic = createSyntheticTree(static_cast<int>(state.range(0)));
+    XMLParser parser(factory);
+    parser.loadFromText(synthetic.main_xml);
+
+    size_t nodes_count = 0;
+    uint64_t allocations = 0;
+    for (auto _ : state)
+    {
+        const uint64_t allocations_before = allocationCount();
+        std::vector<TreeNode::Ptr> nodes;
+        auto root = parser.instantiateTree(nodes, Blackboard::Ptr());
+
+        state.PauseTiming();
+        allocations += allocationCount() - allocations_before;
+        nodes_count = nodes.size();
+        Tree tree(root.get(), std::move(nodes));
+        root.reset();
+        tree = Tree();
+        state.ResumeTiming();
+    }
+    setCounters(state, nodes_count);
+    state.counters["allocs_per_node"] =
+        double(allocations) / double(state.iterations() * nodes_count);
+}
+
+static void BM_Flatbuffers(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    registerActions(factory);
+    const SyntheticTree synthetic = createSyntheticTree(static_cast<int>(state.range(0)));
+    Tree tree = buildTreeFromText(factory, synthetic.main_xml);
+
+    for (auto _ : state)
+    {
+        flatbuffers::FlatBufferBuilder builder(1024);
+        CreateFlatbuffersBehaviorTree(builder, tree.root_node);
+        benchmark::DoNotOptimize(builder.GetBufferPointer());
+    }
+    setCounters(state, tree.nodes.size());
+}
+
+static void BM_Destroy(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    registerActions(factory);
+    const SyntheticTree synthetic = createSyntheticTree(static_cast<int>(state.range(0)));
+
+    size_t nodes_count = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Tree tree = buildTreeFromText(factory, synthetic.main_xml);
+        nodes_count = tree.nodes.size();
+        state.ResumeTiming();
+
+        tree = Tree();
+    }
+    setCounters(state, nodes_count);
+}
+
+BENCHMARK(BM_Parse)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_VerifyXML)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Instantiate)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Flatbuffers)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Destroy)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,202 @@
+#include "benchmark_utils.h"
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
+
+using namespace BT;
+
+static std::string wrapTreeXML(const std::string& body)
+{
+    return "<root main_tree_to_execute=\"MainTree\">\n"
+           "  <BehaviorTree ID=\"MainTree\">\n" +
+           body + "  </BehaviorTree>\n</root>\n";
+}
+
+// Sequences nested (depth) times; the innermost has an AlwaysSuccess child.
+// The depth is limited by the XML parser to less than 100.
+static void BM_DeepChain(benchmark::State& state)
+{
+    const int depth = static_cast<int>(state.range(0));
+    std::string body;
+    for (int i = 0; i < depth; i++)
+    {
+        body += "<Sequence>";
+    }
+    body += "<AlwaysSuccess/>";
+    for (int i = 0; i < depth; i++)
+    {
+        body += "</Sequence>";
+    }
+
+    BehaviorTreeFactory factory;
+    Tree tree = buildTreeFromText(factory, wrapTreeXML(body));
+    runTickLoop(state, tree.root_node);
+}
+
+// Arg 0: 0 = Sequence of AlwaysSuccess, 1 = Fallback of AlwaysFailure,
+//        2 = ParallelNode of AlwaysSuccess. All the children are ticked.
+// Arg 1: number of children.
+static void BM_WideFanout(benchmark::State& state)
+{
+    const int width = static_cast<int>(state.range(1));
+    std::string open, child, close;
+    switch (state.range(0))
+    {
+        case 0:
+            open = "<Sequence>";
+            child = "<AlwaysSuccess/>";
+            close = "</Sequence>";
+            break;
+        case 1:
+            open = "<Fallback>";
+            child = "<AlwaysFailure/>";
+            close = "</Fallback>";
+            break;
+        default:
+            open = "<ParallelNode threshold=\"" + std::to_string(width) + "\">";
+            child = "<AlwaysSuccess/>";
+            close = "</ParallelNode>";
+            break;
+    }
+
+    std::string body = open;
+    for (int i = 0; i < width; i++)
+    {
+        body += child;
+    }
+    body += close;
+
+    BehaviorTreeFactory factory;
+    Tree tree = buildTreeFromText(factory, wrapTreeXML(body));
+    runTickLoop(state, tree.root_node);
+}
+
+// A parallel that waits for its slowest child: (width - 1) AlwaysSuccess and
+// an action that is always RUNNING.
+// Arg 0: 0 = ParallelNode, that ticks again the completed children,
+//        1 = PolicyParallel, that ticks only the RUNNING one.
+// Arg 1: number of children.
+static void BM_LongParallel(benchmark::State& state)
+{
+    const int width = static_cast<int>(state.range(1));
+    std::string body = state.range(0) == 0 ?
+                           "<ParallelNode threshold=\"" + std::to_string(width) + "\">" :
+                           "<PolicyParallel success_policy=\"SUCCEED_ON_ALL\">";
+    for (int i = 1; i < width; i++)
+    {
+        body += "<AlwaysSuccess/>";
+    }
+    body += "<Wait/>";
+    body += state.range(0) == 0 ? "</ParallelNode>" : "</PolicyParallel>";
+
+    BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Wait", [](TreeNode&) { return NodeStatus::RUNNING; });
+    Tree tree = buildTreeFromText(factory, wrapTreeXML(body));
+    runTickLoop(state, tree.root_node);
+}
+
+// Sequence of (groups) groups of decorators; Repeat and RetryUntilSuccesful
+// return RUNNING between their cycles.
+static void BM_MixedDecorators(benchmark::State& state)
+{
+    std::string body = "<Sequence>";
+    for (int64_t i = 0; i < state.range(0); i++)
+    {
+        body += "<Inverter><ForceFailure><AlwaysSuccess/></ForceFailure></Inverter>"
+                "<Repeat num_cycles=\"3\"><AlwaysSuccess/></Repeat>"
+                "<ForceSuccess><RetryUntilSuccesful num_attempts=\"2\">"
+                "<AlwaysFailure/></RetryUntilSuccesful></ForceSuccess>";
+    }
+    body += "</Sequence>";
+
+    BehaviorTreeFactory factory;
+    Tree tree = buildTreeFromText(factory, wrapTreeXML(body));
+    runTickLoop(state, tree.root_node);
+}
+
+// Nodes that read the blackboard at each tick: a precondition on an entry and
+// a Repeat whose number of cycles is a blackboard pattern.
+static void BM_BlackboardParams(benchmark::State& state)
+{
+    std::string body = "<Sequence>";
+    for (int64_t i = 0; i < state.range(0); i++)
+    {
+        body += "<BlackboardCheckInt key=\"value\" expected=\"42\">"
+                "<Repeat num_cycles=\"${cycles}\"><AlwaysSuccess/></Repeat>"
+                "</BlackboardCheckInt>";
+    }
+    body += "</Sequence>";
+
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    blackboard->set("value", 42);
+    blackboard->set("cycles", 1);
+
+    BehaviorTreeFactory factory;
+    Tree tree = buildTreeFromText(factory, wrapTreeXML(body), blackboard);
+    runTickLoop(state, tree.root_node);
+}
+
+// The tree of the CrossDoor sample (examples/t05_crossdoor.cpp). The nodes of
+// sample_nodes sleep to simulate the robot; here they only read the blackboard.
+static void BM_CrossDoor(benchmark::State& state)
+{
+    static const char* xml_text = R"(
+<root main_tree_to_execute = "MainTree">
+    <BehaviorTree ID="DoorClosed">
+        <Sequence name="door_closed_sequence">
+            <Inverter>
+                <Condition ID="IsDoorOpen"/>
+            </Inverter>
+            <RetryUntilSuccesful num_attempts="4">
+                <OpenDoor/>
+            </RetryUntilSuccesful>
+            <PassThroughDoor/>
+        </Sequence>
+    </BehaviorTree>
+    <BehaviorTree ID="MainTree">
+        <Fallback name="root_Fallback">
+            <Sequence name="door_open_sequence">
+                <IsDoorOpen/>
+                <PassThroughDoor/>
+            </Sequence>
+            <SubTree ID="DoorClosed"/>
+            <PassThroughWindow/>
+        </Fallback>
+    </BehaviorTree>
+</root>
+)";
+
+    auto readFlag = [](TreeNode& self, const char* key, bool expected) {
+        return self.blackboard()->get<bool>(key) == expected ? NodeStatus::SUCCESS :
+                                                              NodeStatus::FAILURE;
+    };
+
+    BehaviorTreeFactory factory;
+    factory.registerSimpleCondition("IsDoorOpen", [&](TreeNode& self) {
+        return readFlag(self, "door_open", true);
+    });
+    factory.registerSimpleAction("PassThroughDoor", [&](TreeNode& self) {
+        return readFlag(self, "door_open", true);
+    });
+    factory.registerSimpleAction("OpenDoor", [&](TreeNode& self) {
+        return readFlag(self, "door_locked", false);
+    });
+    factory.registerSimpleAction("PassThroughWindow",
+                                 [](TreeNode&) { return NodeStatus::SUCCESS; });
+
+    // the door is locked: every branch of the Fallback is visited
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    blackboard->set("door_open", false);
+    blackboard->set("door_locked", true);
+
+    Tree tree = buildTreeFromText(factory, xml_text, blackboard);
+    runTickLoop(state, tree.root_node);
+}
+
+BENCHMARK(BM_DeepChain)->Arg(8)->Arg(32)->Arg(64);
+BENCHMARK(BM_WideFanout)->ArgsProduct({{0, 1, 2}, {16, 256}});
+BENCHMARK(BM_LongParallel)->ArgsProduct({{0, 1}, {16, 256}});
+BENCHMARK(BM_MixedDecorators)->Arg(1)->Arg(32);
+BENCHMARK(BM_BlackboardParams)->Arg(1)->Arg(32);
+BENCHMARK(BM_CrossDoor);
+
+BENCHMARK_MAIN();
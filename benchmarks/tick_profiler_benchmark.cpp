@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/tick_profiler.h"
+
+using namespace BT;
+
+// Sequence of (children) Inverters, each with an AlwaysFailure child
+static std::string createTreeXML(int children)
+{
+    std::string xml;
+    xml += "<root main_tree_to_execute=\"MainTree\">\n";
+    xml += "  <BehaviorTree ID=\"MainTree\">\n    <Sequence>\n";
+    for (int i = 0; i < children; i++)
+    {
+        xml += "      <Inverter><AlwaysFailure/></Inverter>\n";
+    }
+    xml += "    </Sequence>\n  </BehaviorTree>\n</root>\n";
+    return xml;
+}
+
+// Arg 1: with TickProfiler attached
+static void BM_TickTree(benchmark::State& state)
+{
+    BehaviorTreeFactory factory;
+    Tree tree = buildTreeFromText(factory, createTreeXML(500));
+
+    std::unique_ptr<TickProfiler> profiler;
+    if (state.range(0))
+    {
+        profiler.reset(new TickProfiler(tree.root_node));
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tree.root_node->executeTick());
+    }
+    state.counters["nodes"] = tree.nodes.size();
+    state.counters["ns_per_node"] = benchmark::Counter(
+        tree.nodes.size(), benchmark::Counter::kIsIterationInvariantRate |
+                               benchmark::Counter::kInvert);
+}
+
+BENCHMARK(BM_TickTree)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
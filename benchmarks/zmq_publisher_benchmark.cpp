@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+#include <ctime>
+#include <zmq.hpp>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/loggers/bt_zmq_publisher.h"
+
+using namespace BT;
+
+// Parallel node with (branches) branches of 10 nodes that remain RUNNING, plus a small
+// Sequence that changes status at every tick: only a few nodes change status.
+static std::string createTreeXML(int branches)
+{
+    std::string xml;
+    xml += "<root main_tree_to_execute=\"MainTree\">\n";
+    xml += "  <BehaviorTree ID=\"MainTree\">\n";
+    xml += "    <ParallelNode threshold=\"" + std::to_string(branches + 1) + "\">\n";
+    xml += "      <Sequence><AlwaysSuccess/><AlwaysSuccess/></Sequence>\n";
+    for (int i = 0; i < branches; i++)
+    {
+        xml += "      <SequenceStar>\n"
+               "        <Inverter><AlwaysFailure/></Inverter>\n"
+               "        <Inverter><AlwaysFailure/></Inverter>\n"
+               "        <Inverter><AlwaysFailure/></Inverter>\n"
+               "        <Inverter><AlwaysFailure/></Inverter>\n"
+               "        <Wait/>\n"
+               "      </SequenceStar>\n";
+    }
+    xml += "    </ParallelNode>\n  </BehaviorTree>\n</root>\n";
+    return xml;
+}
+
+class WaitNode : public ActionNodeBase
+{
+  public:
+    WaitNode(const std::string& name) : ActionNodeBase(name, {})
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        return NodeStatus::RUNNING;
+    }
+
+    void halt() override
+    {
+        setStatus(NodeStatus::IDLE);
+    }
+};
+
+// the sockets are bound once for all the runs
+struct Fixture
+{
+    Fixture()
+      : tree(createTree()), publisher(tree.root_node, 25), subscriber(context, ZMQ_SUB)
+    {
+        subscriber.connect("tcp://localhost:1666");
+        subscriber.setsockopt(ZMQ_SUBSCRIBE, "", 0);
+    }
+
+    static Tree createTree()
+    {
+        BehaviorTreeFactory factory;
+        factory.registerNodeType<WaitNode>("Wait");
+        return buildTreeFromText(factory, createTreeXML(100));
+    }
+
+    Tree tree;
+    PublisherZMQ publisher;
+    zmq::context_t context{1};
+    zmq::socket_t subscriber;
+};
+
+static void BM_PublishTicks(benchmark::State& state)
+{
+    static Fixture fixture;
+    const auto period = std::chrono::microseconds(state.range(0));
+
+    size_t bytes = 0;
+    size_t messages = 0;
+    const std::clock_t cpu_start = std::clock();
+
+    for (auto _ : state)
+    {
+        fixture.tree.root_node->executeTick();
+        std::this_thread::sleep_for(period);
+
+        // each message has two frames: tree ID and payload
+        zmq::message_t message;
+        while (fixture.subscriber.recv(&message, ZMQ_DONTWAIT))
+        {
+            bytes += message.size();
+            if (!fixture.subscriber.getsockopt<int>(ZMQ_RCVMORE))
+            {
+                messages++;
+            }
+        }
+    }
+
+    // process time includes the sender thread
+    const double cpu_sec = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    state.counters["bytes_per_tick"] = double(bytes) / state.iterations();
+    state.counters["bytes_per_msg"] = messages ? double(bytes) / messages : 0;
+    state.counters["cpu_usec_per_tick"] = cpu_sec * 1e6 / state.iterations();
+}
+
+BENCHMARK(BM_PublishTicks)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -4,6 +4,7 @@
 #include "behaviortree_cpp/loggers/bt_minitrace_logger.h"
 #include "behaviortree_cpp/loggers/bt_file_logger.h"
 #include "behaviortree_cpp/blackboard/blackboard_local.h"
+#include "behaviortree_cpp/tick_driver.h"
 
 #ifdef ZMQ_FOUND
 #include "behaviortree_cpp/loggers/bt_zmq_publisher.h"
@@ -71,13 +72,9 @@ int main()
 
     //while (1)
     {
-        NodeStatus status = NodeStatus::RUNNING;
-        // Keep on ticking until you get either a SUCCESS or FAILURE state
-        while( status == NodeStatus::RUNNING)
-        {
-            status = tree.root_node->executeTick();
-            CrossDoor::SleepMS(1);   // optional sleep to avoid "busy loops"
-        }
+        // Keep on ticking every millisecond until you get either a SUCCESS or FAILURE state
+        TickDriver driver(tree.root_node, TickDriverOptions(std::chrono::milliseconds(1)));
+        driver.run();
         CrossDoor::SleepMS(2000);
     }
     return 0;
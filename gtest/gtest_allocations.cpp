@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/allocation_checker.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
+
+BT_ALLOCATION_CHECKER_HOOK
+
+using namespace BT;
+
+// clang-format off
+// Keys and strings are longer than the small string optimization.
+static const char* xml_text_builtin = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <Fallback>
+                <ForceFailure><AlwaysSuccess/></ForceFailure>
+                <Inverter><AlwaysFailure/></Inverter>
+            </Fallback>
+            <SequenceStar reset_on_failure="${reset_sequence_star_on_failure}">
+                <Repeat num_cycles="${number_of_cycles_of_the_repeat}">
+                    <AlwaysSuccess/>
+                </Repeat>
+            </SequenceStar>
+            <FallbackStar>
+                <ForceSuccess>
+                    <RetryUntilSuccesful num_attempts="2"><AlwaysFailure/></RetryUntilSuccesful>
+                </ForceSuccess>
+            </FallbackStar>
+            <ParallelNode threshold="${threshold_of_the_parallel_node}">
+                <BlackboardCheckInt key="integer_value_in_the_blackboard" expected="42">
+                    <AlwaysSuccess/>
+                </BlackboardCheckInt>
+                <BlackboardCheckDouble key="real_value_in_the_blackboard" expected="3.14159265358979">
+                    <AlwaysSuccess/>
+                </BlackboardCheckDouble>
+                <BlackboardCheckString key="string_value_in_the_blackboard"
+                                       expected="a string longer than the small string buffer">
+                    <AlwaysSuccess/>
+                </BlackboardCheckString>
+            </ParallelNode>
+            <Timeout msec="${timeout_in_milliseconds_from_bb}">
+                <SubTree ID="Child"/>
+            </Timeout>
+        </Sequence>
+    </BehaviorTree>
+
+    <BehaviorTree ID="Child">
+        <Sequence>
+            <AlwaysSuccess/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+TEST(AllocationCheckerTest, BuiltinNodes)
+{
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    blackboard->set("reset_sequence_star_on_failure", std::string("true"));
+    blackboard->set("number_of_cycles_of_the_repeat", 1);
+    blackboard->set("threshold_of_the_parallel_node", std::string("3"));
+    blackboard->set("integer_value_in_the_blackboard", 42);
+    blackboard->set("real_value_in_the_blackboard", 3.14159265358979);
+    blackboard->set("string_value_in_the_blackboard",
+                    std::string("a string longer than the small string buffer"));
+    blackboard->set("timeout_in_milliseconds_from_bb", 1000);
+
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_builtin, blackboard);
+
+    AllocationChecker checker(tree.root_node);
+    // Repeat and RetryUntilSuccesful return RUNNING between their cycles
+    while (tree.root_node->executeTick() == NodeStatus::RUNNING)
+    {
+    }
+    checker.reset();
+
+    int successes = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        successes += tree.root_node->executeTick() == NodeStatus::SUCCESS ? 1 : 0;
+    }
+    ASSERT_GT(successes, 10);
+
+    std::stringstream report;
+    checker.dumpReport(report);
+    EXPECT_EQ(0u, checker.count()) << report.str();
+}
+
+TEST(AllocationCheckerTest, Report)
+{
+    static const char* xml_text = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <AlwaysSuccess/>
+            <Allocate name="allocating_action"/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+
+    BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Allocate", [](TreeNode&) {
+        std::unique_ptr<std::vector<int>> vect(new std::vector<int>(100));
+        return vect->size() == 100 ? NodeStatus::SUCCESS : NodeStatus::FAILURE;
+    });
+    auto tree = buildTreeFromText(factory, xml_text);
+
+    AllocationChecker checker(tree.root_node);
+    tree.root_node->executeTick();
+    checker.reset();
+    tree.root_node->executeTick();
+
+    // the vector and its buffer
+    EXPECT_EQ(2u, checker.count());
+    const auto allocations = checker.allocations();
+    ASSERT_EQ(2u, allocations.size());
+    EXPECT_EQ("allocating_action", allocations[0].node->name());
+    EXPECT_EQ(100 * sizeof(int), allocations[1].size);
+
+    std::stringstream report;
+    checker.dumpReport(report);
+    EXPECT_NE(report.str().find("[allocating_action] (Allocate)"), std::string::npos);
+
+    // nothing is recorded outside executeTick()
+    std::unique_ptr<std::string> str(new std::string(100, 'a'));
+    EXPECT_EQ(2u, checker.count());
+}
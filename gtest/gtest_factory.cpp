@@ -1,7 +1,11 @@
 #include <gtest/gtest.h>
+#include <fstream>
+#include <set>
+#include <thread>
 #include "action_test_node.h"
 #include "condition_test_node.h"
 #include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
 #include "../sample_nodes/crossdoor_nodes.h"
 
 // clang-format off
@@ -175,3 +179,259 @@ const std::string xml_text_issue = R"(
 
     EXPECT_THROW( parser.loadFromText(xml_text_issue), std::runtime_error );
 }
+
+TEST(BehaviorTreeFactory, CloneTree)
+{
+    BT::BehaviorTreeFactory factory;
+    CrossDoor::RegisterNodes(factory);
+
+    auto blackboard = BT::Blackboard::create<BT::BlackboardLocal>();
+    BT::Tree tree = BT::buildTreeFromText(factory, xml_text_subtree, blackboard);
+
+    auto other_blackboard = BT::Blackboard::create<BT::BlackboardLocal>();
+    BT::Tree copy = tree.clone(other_blackboard);
+    BT::Tree copy_2 = tree.clone(other_blackboard);
+
+    ASSERT_EQ(copy.nodes.size(), tree.nodes.size());
+    ASSERT_EQ(BT::writeXML(factory, copy.root_node), BT::writeXML(factory, tree.root_node));
+
+    // the UIDs are unique in each tree, numbered from 1
+    std::set<uint16_t> uids;
+    for (const auto& node : tree.nodes)
+    {
+        ASSERT_TRUE(uids.insert(node->UID()).second);
+    }
+    ASSERT_EQ(*uids.begin(), 1);
+    ASSERT_EQ(*uids.rbegin(), tree.nodes.size());
+    ASSERT_EQ(copy.nodes[0]->UID(), copy_2.nodes[0]->UID());
+
+    for (size_t i = 0; i < tree.nodes.size(); i++)
+    {
+        const auto& node = tree.nodes[i];
+        const auto& new_node = copy.nodes[i];
+        ASSERT_NE(node.get(), new_node.get());
+        ASSERT_EQ(node->name(), new_node->name());
+        ASSERT_EQ(node->registrationName(), new_node->registrationName());
+        ASSERT_EQ(node->initializationParameters(), new_node->initializationParameters());
+        ASSERT_EQ(new_node->UID(), node->UID());
+        ASSERT_EQ(new_node->blackboard(), other_blackboard);
+    }
+
+    ASSERT_EQ(copy.root_node, copy.nodes.front().get());
+    auto root_selector = dynamic_cast<const BT::FallbackNode*>(copy.root_node);
+    ASSERT_TRUE(root_selector != nullptr);
+    auto subtree = dynamic_cast<const BT::DecoratorSubtreeNode*>(root_selector->child(0));
+    ASSERT_TRUE(subtree != nullptr);
+    ASSERT_EQ(subtree->child(), copy.nodes[2].get());
+}
+
+TEST(BehaviorTreeFactory, UIDsAreReleased)
+{
+    BT::BehaviorTreeFactory factory;
+    CrossDoor::RegisterNodes(factory);
+    auto blackboard = BT::Blackboard::create<BT::BlackboardLocal>();
+    BT::Tree tree = BT::buildTreeFromText(factory, xml_text_subtree, blackboard);
+
+    // more nodes than 16 bits UIDs, alive at the same time
+    std::vector<BT::Tree> copies;
+    size_t count = 0;
+    while (count <= 70000)
+    {
+        copies.push_back(tree.clone(blackboard));
+        count += copies.back().nodes.size();
+    }
+    copies.clear();
+
+    // the nodes that don't belong to a tree have unique UIDs, while they exist
+    std::vector<std::unique_ptr<BT::TreeNode>> nodes;
+    std::set<uint16_t> uids;
+    auto create = [&nodes]() {
+        nodes.emplace_back(new BT::SimpleActionNode("action", [](BT::TreeNode&) {
+            return BT::NodeStatus::SUCCESS;
+        }));
+        return nodes.back()->UID();
+    };
+    try
+    {
+        while (true)
+        {
+            ASSERT_TRUE(uids.insert(create()).second);
+        }
+    }
+    catch (const BT::BehaviorTreeException&)
+    {
+    }
+    ASSERT_GT(nodes.size(), 60000);
+    const uint16_t released = nodes[100]->UID();
+    nodes[100].reset();
+    ASSERT_EQ(create(), released);
+}
+
+TEST(BehaviorTreeFactory, NodeParameters)
+{
+    BT::NodeParameters params = {{"num_cycles", "3"}, {"key", "value"}};
+    ASSERT_EQ(params.size(), 2);
+    ASSERT_EQ(params.begin()->first, "key");   // sorted by key
+    ASSERT_EQ(params.at("num_cycles"), "3");
+    ASSERT_EQ(params.count("msec"), 0);
+    ASSERT_TRUE(params.find("msec") == params.end());
+    ASSERT_THROW(params.at("msec"), std::out_of_range);
+
+    params.set("num_cycles", "4");
+    params.set("msec", "100");
+    ASSERT_EQ(params.size(), 3);
+    ASSERT_EQ(params.find("num_cycles")->second, "4");
+
+    // identical entries are shared
+    BT::NodeParameters other;
+    other.set("msec", "100");
+    ASSERT_EQ(&params.at("msec"), &other.at("msec"));
+
+    other.set("key", "value");
+    other.set("num_cycles", "4");
+    ASSERT_EQ(params, other);
+    ASSERT_TRUE(other.erase("key"));
+    ASSERT_NE(params, other);
+
+    // the entries are released with the last instance that uses them
+    const size_t interned = BT::NodeParameters::internedCount();
+    {
+        BT::NodeParameters unique = {{"unique_key", "unique_value"}};
+        BT::NodeParameters copy = unique;
+        ASSERT_EQ(BT::NodeParameters::internedCount(), interned + 1);
+        unique.clear();
+        ASSERT_EQ(BT::NodeParameters::internedCount(), interned + 1);
+        copy.set("unique_key", "another_value");
+        ASSERT_EQ(BT::NodeParameters::internedCount(), interned + 1);
+    }
+    ASSERT_EQ(BT::NodeParameters::internedCount(), interned);
+
+    const char* xml_text_params = R"(
+<root main_tree_to_execute = "MainTree" >
+  <BehaviorTree ID="MainTree">
+    <Sequence>
+      <Repeat num_cycles="3">
+        <SetBlackboard key="A" value="1"/>
+      </Repeat>
+      <Repeat num_cycles="3">
+        <SetBlackboard key="B" value="1"/>
+      </Repeat>
+    </Sequence>
+  </BehaviorTree>
+</root> )";
+
+    BT::BehaviorTreeFactory factory;
+    auto tree = BT::buildTreeFromText(factory, xml_text_params);
+    ASSERT_EQ(tree.nodes.size(), 5);
+
+    const auto& params_A = tree.nodes[2]->initializationParameters();
+    const auto& params_B = tree.nodes[4]->initializationParameters();
+    ASSERT_EQ(tree.nodes[1]->initializationParameters(), tree.nodes[3]->initializationParameters());
+    ASSERT_EQ(params_A.at("key"), "A");
+    ASSERT_EQ(params_B.at("key"), "B");
+    ASSERT_EQ(&params_A.at("value"), &params_B.at("value"));
+    int num_cycles = 0;
+    ASSERT_TRUE(tree.nodes[1]->getParam("num_cycles", num_cycles));
+    ASSERT_EQ(num_cycles, 3);
+}
+
+TEST(BehaviorTreeFactory, DeferredPluginFromCache)
+{
+    using namespace BT;
+    PluginManifest plugin;
+    // already loaded by this executable: dlopen will find it by name
+    plugin.path = "libcrossdoor_nodes.so";
+    plugin.manifests = { {NodeType::CONDITION, "IsDoorOpen", NodeParameters()},
+                         {NodeType::ACTION, "IsDoorLocked", NodeParameters()},
+                         {NodeType::ACTION, "OpenDoor", NodeParameters()},
+                         {NodeType::ACTION, "PassThroughDoor", NodeParameters()},
+                         {NodeType::ACTION, "CloseDoor", NodeParameters()},
+                         {NodeType::ACTION, "PassThroughWindow", {{"speed", "1"}}} };
+
+    const char* cache_file = "plugin_manifest_cache.xml";
+    {
+        std::ofstream file_os(cache_file);
+        file_os << writePluginManifestCache({plugin});
+    }
+
+    BehaviorTreeFactory factory;
+    registerFromManifestCache(factory, cache_file);
+    std::remove(cache_file);
+
+    ASSERT_TRUE(factory.hasDeferredPlugins());
+    ASSERT_EQ(factory.builders().count("OpenDoor"), 0);
+
+    bool found = false;
+    for (const auto& manifest : factory.manifests())
+    {
+        if (manifest.registration_ID == "PassThroughWindow")
+        {
+            found = true;
+            ASSERT_EQ(manifest.type, NodeType::ACTION);
+            ASSERT_EQ(manifest.required_parameters.at("speed"), "1");
+        }
+    }
+    ASSERT_TRUE(found);
+
+    // the library is loaded only when the tree is instantiated
+    XMLParser parser(factory);
+    parser.loadFromText(xml_text_subtree);
+    ASSERT_EQ(factory.builders().count("OpenDoor"), 0);
+
+    std::vector<TreeNode::Ptr> nodes;
+    TreeNode::Ptr root_node = parser.instantiateTree(nodes, Blackboard::Ptr());
+
+    ASSERT_FALSE(factory.hasDeferredPlugins());
+    ASSERT_EQ(factory.builders().count("OpenDoor"), 1);
+    ASSERT_EQ(root_node->name(), "root_selector");
+
+    size_t count = 0;
+    for (const auto& manifest : factory.manifests())
+    {
+        count += (manifest.registration_ID == "OpenDoor") ? 1 : 0;
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(BehaviorTreeFactory, DeferredPluginConcurrentBuild)
+{
+    using namespace BT;
+    PluginManifest plugin;
+    plugin.path = "libcrossdoor_nodes.so";
+    plugin.manifests = { {NodeType::CONDITION, "IsDoorOpen", NodeParameters()},
+                         {NodeType::ACTION, "IsDoorLocked", NodeParameters()},
+                         {NodeType::ACTION, "OpenDoor", NodeParameters()},
+                         {NodeType::ACTION, "PassThroughDoor", NodeParameters()},
+                         {NodeType::ACTION, "CloseDoor", NodeParameters()},
+                         {NodeType::ACTION, "PassThroughWindow", {{"speed", "1"}}} };
+
+    BehaviorTreeFactory factory;
+    factory.registerDeferredPlugin(plugin);
+
+    // the first tree that is built loads the plugin, while the other threads
+    // instantiate nodes from the same const factory
+    const BehaviorTreeFactory& shared_factory = factory;
+    std::vector<std::thread> threads;
+    std::vector<size_t> sizes(4, 0);
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        threads.emplace_back([&shared_factory, &sizes, i]() {
+            for (int n = 0; n < 20; n++)
+            {
+                auto tree = buildTreeFromText(shared_factory, xml_text_subtree);
+                sizes[i] = tree.nodes.size();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_FALSE(factory.hasDeferredPlugins());
+    for (size_t size : sizes)
+    {
+        ASSERT_EQ(size, sizes.front());
+        ASSERT_GT(size, 0);
+    }
+}
@@ -0,0 +1,804 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <cstring>
+#include <sys/wait.h>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/loggers/bt_file_logger.h"
+#include "behaviortree_cpp/loggers/bt_flight_recorder.h"
+#include "behaviortree_cpp/loggers/bt_flatbuffer_helper.h"
+#include "behaviortree_cpp/loggers/bt_log_codec.h"
+#include "behaviortree_cpp/loggers/bt_log_reader.h"
+#include "behaviortree_cpp/loggers/bt_log_replay.h"
+#include "behaviortree_cpp/loggers/bt_cout_logger.h"
+#include "behaviortree_cpp/loggers/bt_minitrace_logger.h"
+#include "behaviortree_cpp/loggers/bt_trace_logger.h"
+#include "behaviortree_cpp/controls/sequence_node.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
+#include "action_test_node.h"
+
+using namespace BT;
+
+// clang-format off
+static const char* xml_text_logger = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <AlwaysSuccess/>
+            <AlwaysSuccess/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+static std::vector<char> readFile(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+}
+
+// return the number of transitions, or -1 if the file is not valid
+static int countTransitions(const std::string& filename)
+{
+    std::vector<char> buffer = readFile(filename);
+    if (buffer.size() < 4)
+    {
+        return -1;
+    }
+    const size_t header_size = 4 + flatbuffers::ReadScalar<uint32_t>(buffer.data());
+    if (buffer.size() < header_size || (buffer.size() - header_size) % 12 != 0)
+    {
+        return -1;
+    }
+    return (buffer.size() - header_size) / 12;
+}
+
+// return the number of transitions of a V2 file, or -1 if the file is not valid
+static int countTransitionsV2(const std::string& filename)
+{
+    std::vector<char> buffer = readFile(filename);
+    if (buffer.size() < 8 || memcmp(buffer.data(), LOG_V2_MAGIC, 4) != 0)
+    {
+        return -1;
+    }
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+    size_t index = 8 + flatbuffers::ReadScalar<uint32_t>(&data[4]);
+
+    std::vector<LogTransition> transitions;
+    std::vector<uint8_t> scratch;
+    LogBlockHeader header;
+    while (index < buffer.size())
+    {
+        if (!ReadLogBlockHeader(&data[index], buffer.size() - index, header) ||
+            header.payload_size > buffer.size() - index - LogBlockHeader::SIZE)
+        {
+            return -1;
+        }
+        index += LogBlockHeader::SIZE;
+        DecodeLogBlock(header, &data[index], transitions, scratch);
+        index += header.payload_size;
+    }
+    return transitions.size();
+}
+
+static bool fileExists(const std::string& filename)
+{
+    return std::ifstream(filename).good();
+}
+
+TEST(FileLoggerTest, Synchronous)
+{
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_logger);
+    {
+        FileLogger logger(tree.root_node, "test_sync.fbl", 1000);
+        for (int i = 0; i < 10; i++)
+        {
+            tree.root_node->executeTick();
+        }
+    }
+    // each tick: Sequence IDLE->RUNNING, 2x (IDLE->SUCCESS, SUCCESS->IDLE), RUNNING->SUCCESS
+    // and from the second tick, SUCCESS->RUNNING instead of IDLE->RUNNING
+    EXPECT_EQ(countTransitions("test_sync.fbl"), 60);
+    std::remove("test_sync.fbl");
+}
+
+TEST(FileLoggerTest, AsyncRotation)
+{
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_logger);
+
+    FileLoggerOptions options;
+    options.async = true;
+    options.buffer_size = 6;
+    options.max_file_size = 1024;
+    options.max_files = 2;
+
+    const char* files[] = {"test_async.fbl", "test_async.1.fbl", "test_async.2.fbl",
+                           "test_async.3.fbl"};
+    {
+        FileLogger logger(tree.root_node, files[0], options);
+        for (int i = 0; i < 200; i++)
+        {
+            tree.root_node->executeTick();
+            if (i % 20 == 0)
+            {
+                logger.flush();
+            }
+        }
+        logger.flush();
+        EXPECT_GT(countTransitions(files[0]), 0);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_TRUE(fileExists(files[i])) << files[i];
+        EXPECT_GT(countTransitions(files[i]), 0) << files[i];
+        EXPECT_LE(readFile(files[i]).size(), options.max_file_size) << files[i];
+    }
+    EXPECT_FALSE(fileExists(files[3]));
+
+    for (const char* file : files)
+    {
+        std::remove(file);
+    }
+
+    // rotating without keeping any file would discard the log
+    options.max_files = 0;
+    EXPECT_THROW(FileLogger(tree.root_node, files[0], options), std::invalid_argument);
+    options.max_file_size = 0;
+    options.max_file_age = std::chrono::seconds(60);
+    EXPECT_THROW(FileLogger(tree.root_node, files[0], options), std::invalid_argument);
+    EXPECT_FALSE(fileExists(files[0]));
+}
+
+TEST(FileLoggerTest, AsyncOverflow)
+{
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_logger);
+
+    FileLoggerOptions options;
+    options.async = true;
+    options.async_capacity = 4;
+    const int ticks = 1000;
+    size_t dropped = 0;
+    {
+        FileLogger logger(tree.root_node, "test_overflow.fbl", options);
+        for (int i = 0; i < ticks; i++)
+        {
+            tree.root_node->executeTick();
+        }
+        logger.flush();
+        dropped = logger.droppedTransitions();
+    }
+    // the writer can't keep up with 6 transitions per tick, 4 at a time
+    EXPECT_GT(dropped, 0u);
+    EXPECT_EQ(countTransitions("test_overflow.fbl") + dropped, 6u * ticks);
+    std::remove("test_overflow.fbl");
+}
+
+TEST(FileLoggerTest, CodecRoundTrip)
+{
+    std::vector<LogTransition> input;
+    uint64_t timestamp = 1500000000ull * 1000000;
+    for (int i = 0; i < 1000; i++)
+    {
+        // the same nodes change status at every tick; timestamps are not always monotonic
+        timestamp = (i % 97 == 0) ? timestamp - 3 : timestamp + ((i % 12 == 0) ? 10000 : 5);
+        LogTransition transition;
+        transition.timestamp_usec = timestamp;
+        transition.uid = static_cast<uint16_t>(200 + i % 12);
+        transition.prev_status = static_cast<NodeStatus>(i % 4);
+        transition.status = static_cast<NodeStatus>((i + 1) % 4);
+        input.push_back(transition);
+    }
+
+    for (bool compress : {false, true})
+    {
+        LogBlockEncoder encoder(compress);
+        std::vector<uint8_t> data;
+        for (const auto& transition : input)
+        {
+            encoder.push(transition);
+            if (encoder.count() == 300)
+            {
+                encoder.finish(data);
+            }
+        }
+        encoder.finish(data);
+
+        std::vector<LogTransition> output;
+        std::vector<uint8_t> scratch;
+        LogBlockHeader header;
+        size_t index = 0;
+        while (ReadLogBlockHeader(&data[index], data.size() - index, header))
+        {
+            EXPECT_EQ(compress, (header.flags & LogBlockHeader::COMPRESSED) != 0);
+            index += LogBlockHeader::SIZE;
+            DecodeLogBlock(header, &data[index], output, scratch);
+            index += header.payload_size;
+        }
+        EXPECT_EQ(index, data.size());
+        ASSERT_EQ(output.size(), input.size());
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            EXPECT_EQ(output[i].timestamp_usec, input[i].timestamp_usec);
+            EXPECT_EQ(output[i].uid, input[i].uid);
+            EXPECT_EQ(output[i].prev_status, input[i].prev_status);
+            EXPECT_EQ(output[i].status, input[i].status);
+        }
+        // much smaller than the 12 bytes per transition of V1
+        EXPECT_LT(data.size(), input.size() * 6);
+    }
+
+    // corrupted data must not crash
+    std::vector<uint8_t> compressed;
+    std::vector<int32_t> hash_table;
+    std::vector<uint8_t> raw(500, 42);
+    CompressLZ(raw.data(), raw.size(), compressed, hash_table);
+    EXPECT_TRUE(DecompressLZ(compressed.data(), compressed.size(), raw.data(), raw.size()));
+    EXPECT_FALSE(DecompressLZ(compressed.data(), compressed.size() - 1, raw.data(), raw.size()));
+    EXPECT_FALSE(DecompressLZ(compressed.data(), compressed.size(), raw.data(), raw.size() - 1));
+}
+
+TEST(FileLoggerTest, FormatV2)
+{
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_logger);
+
+    FileLoggerOptions options;
+    options.format = FileLogFormat::V2;
+    options.block_size = 20;
+    {
+        FileLogger logger(tree.root_node, "test_v2.fbl", options);
+        for (int i = 0; i < 10; i++)
+        {
+            tree.root_node->executeTick();
+        }
+    }
+    EXPECT_EQ(countTransitionsV2("test_v2.fbl"), 60);
+    std::remove("test_v2.fbl");
+
+    // blocks are never split between files
+    options.async = true;
+    options.max_file_size = 1024;
+    options.max_files = 3;
+    const char* files[] = {"test_v2.fbl", "test_v2.1.fbl", "test_v2.2.fbl", "test_v2.3.fbl"};
+    {
+        FileLogger logger(tree.root_node, files[0], options);
+        for (int i = 0; i < 300; i++)
+        {
+            tree.root_node->executeTick();
+        }
+    }
+    for (const char* file : files)
+    {
+        EXPECT_GT(countTransitionsV2(file), 0) << file;
+        EXPECT_LE(readFile(file).size(), options.max_file_size) << file;
+        std::remove(file);
+    }
+}
+
+TEST(FileLoggerTest, LogReader)
+{
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_logger);
+
+    FileLoggerOptions options_v2;
+    options_v2.format = FileLogFormat::V2;
+    options_v2.block_size = 50;
+    {
+        FileLogger logger_v1(tree.root_node, "test_reader_v1.fbl", 100);
+        FileLogger logger_v2(tree.root_node, "test_reader_v2.fbl", options_v2);
+        for (int i = 0; i < 2000; i++)
+        {
+            tree.root_node->executeTick();
+        }
+    }
+
+    for (const char* filename : {"test_reader_v1.fbl", "test_reader_v2.fbl"})
+    {
+        LogReader reader(filename);
+        EXPECT_EQ(reader.formatVersion(), filename[13] == '1' ? 1 : 2);
+        ASSERT_EQ(reader.nodes().size(), 3);
+        EXPECT_EQ(reader.node(reader.rootUID()).registration_name, "Sequence");
+        EXPECT_EQ(reader.findUIDs("AlwaysSuccess").size(), 2);
+        ASSERT_EQ(reader.size(), 12000);
+
+        std::vector<LogTransition> all;
+        EXPECT_EQ(reader.forEach([&](const LogTransition& transition) {
+            all.push_back(transition);
+            return true;
+        }),
+                  12000);
+
+        // time range in the middle of the file
+        LogFilter filter;
+        filter.from_usec = all[5000].timestamp_usec;
+        filter.to_usec = all[7000].timestamp_usec;
+        filter.uids.push_back(reader.rootUID());
+        filter.onlyStatus(NodeStatus::SUCCESS);
+
+        size_t expected = 0;
+        for (const auto& transition : all)
+        {
+            expected += (transition.timestamp_usec >= filter.from_usec &&
+                         transition.timestamp_usec <= filter.to_usec &&
+                         transition.uid == reader.rootUID() &&
+                         transition.status == NodeStatus::SUCCESS);
+        }
+        EXPECT_GT(expected, 0);
+        EXPECT_EQ(reader.forEach(filter,
+                                 [&](const LogTransition& transition) {
+                                     EXPECT_EQ(transition.uid, reader.rootUID());
+                                     return true;
+                                 }),
+                  expected);
+
+        // stop the iteration
+        EXPECT_EQ(reader.forEach([](const LogTransition&) { return false; }), 1);
+        std::remove(filename);
+    }
+
+    EXPECT_THROW(LogReader("does_not_exist.fbl"), BehaviorTreeException);
+}
+
+TEST(FileLoggerTest, MultipleInstances)
+{
+    BehaviorTreeFactory factory;
+    auto tree_A = buildTreeFromText(factory, xml_text_logger);
+    auto tree_B = buildTreeFromText(factory, xml_text_logger);
+
+    for (int i = 0; i < 2; i++)
+    {
+        StdCoutLogger cout_A(tree_A.root_node);
+        StdCoutLogger cout_B(tree_B.root_node);
+
+        // minitrace has a single output file
+        MinitraceLogger trace_A(tree_A.root_node, "test_trace.json");
+        MinitraceLogger trace_B(tree_B.root_node, "test_trace.json");
+        EXPECT_THROW(MinitraceLogger(tree_B.root_node, "test_other.json"), std::logic_error);
+
+        FileLogger file_A(tree_A.root_node, "test_A.fbl");
+        FileLogger file_B(tree_B.root_node, "test_B.fbl");
+
+        tree_A.root_node->executeTick();
+        tree_B.root_node->executeTick();
+    }
+    EXPECT_TRUE(fileExists("test_trace.json"));
+    EXPECT_FALSE(fileExists("test_other.json"));
+    EXPECT_EQ(countTransitions("test_A.fbl"), 6);
+    EXPECT_EQ(countTransitions("test_B.fbl"), 6);
+
+    for (const char* file : {"test_trace.json", "test_A.fbl", "test_B.fbl"})
+    {
+        std::remove(file);
+    }
+}
+
+static size_t countOccurrences(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos;
+         pos = text.find(pattern, pos + 1))
+    {
+        count++;
+    }
+    return count;
+}
+
+TEST(FileLoggerTest, TraceLogger)
+{
+    SequenceNode root("root");
+    AsyncActionTest action("action");
+    SyncActionTest condition("condition");
+    action.setTime(1);
+    root.addChild(&action);
+    root.addChild(&condition);
+
+    const char* filename = "test_trace_logger.json";
+    {
+        TraceLogger logger(&root, filename);
+        for (int i = 0; i < 2; i++)
+        {
+            while (root.executeTick() == NodeStatus::RUNNING)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        }
+        logger.flush();
+        EXPECT_EQ(logger.droppedEvents(), 0);
+
+        // written incrementally
+        const std::vector<char> partial = readFile(filename);
+        EXPECT_NE(std::string(partial.begin(), partial.end()).find("\"ph\":\"X\""),
+                  std::string::npos);
+    }
+    const std::vector<char> data = readFile(filename);
+    const std::string text(data.begin(), data.end());
+
+    EXPECT_EQ(text.substr(0, 2), "[\n");
+    EXPECT_EQ(text.substr(text.size() - 4), "}\n]\n");
+
+    // every tick of the root is a span
+    const size_t root_ticks = countOccurrences(text, "\"tick\":");
+    EXPECT_GE(root_ticks, 2);
+    EXPECT_EQ(countOccurrences(text, "{\"name\":\"root\""), root_ticks);
+
+    // the work of the action runs in its own thread, linked to the tick that started it
+    EXPECT_EQ(countOccurrences(text, "\"name\":\"async action\""), 1);
+    EXPECT_EQ(countOccurrences(text, "\"ph\":\"s\""), 2);
+    EXPECT_EQ(countOccurrences(text, "\"ph\":\"f\""), 2);
+    EXPECT_EQ(countOccurrences(text, "\"name\":\"condition\""), 2);
+
+    std::remove(filename);
+}
+
+TEST(FileLoggerTest, FlightRecorder)
+{
+    SequenceNode root("root");
+    SyncActionTest first("first");
+    SyncActionTest second("second");
+    root.addChild(&first);
+    root.addChild(&second);
+
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    FlightRecorderOptions options("test_flight.fbl");
+    options.capacity = 16;
+    options.blackboard = blackboard;
+    const std::string blackboard_file = "test_flight.fbl.blackboard";
+    {
+        FlightRecorder recorder(&root, options);
+
+        for (int i = 0; i < 10; i++)
+        {
+            blackboard->set("iteration", i);
+            EXPECT_EQ(recorder.tick(), NodeStatus::SUCCESS);
+        }
+        EXPECT_EQ(recorder.dumpCount(), 0);
+        EXPECT_FALSE(fileExists("test_flight.fbl"));
+
+        // only the most recent transitions are kept
+        auto transitions = recorder.transitions();
+        ASSERT_EQ(transitions.size(), 16);
+        EXPECT_EQ(transitions.back().uid, root.UID());
+        EXPECT_EQ(transitions.back().status, NodeStatus::SUCCESS);
+
+        auto writes = recorder.blackboardWrites();
+        ASSERT_EQ(writes.size(), 10);
+        EXPECT_EQ(writes.back().key, "iteration");
+        EXPECT_EQ(writes.back().value, "9");
+
+        // the root returns FAILURE: dump
+        second.setBoolean(false);
+        EXPECT_EQ(recorder.tick(), NodeStatus::FAILURE);
+        EXPECT_EQ(recorder.dumpCount(), 1);
+        EXPECT_EQ(countTransitions("test_flight.fbl"), 16);
+
+        LogReader reader("test_flight.fbl");
+        EXPECT_EQ(reader.size(), 16);
+        EXPECT_EQ(reader.node(root.UID()).instance_name, "root");
+
+        const std::vector<char> lines = readFile(blackboard_file);
+        EXPECT_EQ(std::count(lines.begin(), lines.end(), '\n'), 10);
+    }
+    // the observer was removed with the recorder
+    blackboard->set("iteration", 10);
+
+    // fatal signal: the child process dumps before dying
+    std::remove("test_flight.fbl");
+    second.setBoolean(true);
+    options.dump_on_signal = true;
+    options.dump_on_failure = false;
+    options.blackboard = nullptr;
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        FlightRecorder recorder(&root, options);
+        root.executeTick();
+        abort();
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFSIGNALED(status));
+    EXPECT_EQ(WTERMSIG(status), SIGABRT);
+    EXPECT_GT(countTransitions("test_flight.fbl"), 0);
+
+    for (const std::string& file : {std::string("test_flight.fbl"), blackboard_file})
+    {
+        std::remove(file.c_str());
+    }
+}
+
+struct RecordedPose
+{
+    double x;
+};
+
+TEST(FileLoggerTest, FlightRecorderValues)
+{
+    SequenceNode root("root");
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    FlightRecorderOptions options("test_flight_values.fbl");
+    options.dump_on_failure = false;
+    options.blackboard = blackboard;
+    {
+        FlightRecorder recorder(&root, options);
+        blackboard->set("negative", -42);
+        blackboard->set("unsigned", uint64_t(18446744073709551615ull));
+        blackboard->set("real", 2.5);
+        blackboard->set("huge", 1.5e20);
+        blackboard->set("name", std::string("a string longer than thirty-one characters"));
+        blackboard->set("pose", RecordedPose{1.0});
+
+        // formatted only now
+        const auto writes = recorder.blackboardWrites();
+        ASSERT_EQ(writes.size(), 6);
+        EXPECT_EQ(writes[0].value, "-42");
+        EXPECT_EQ(writes[1].value, "18446744073709551615");
+        EXPECT_EQ(writes[2].value, "2.500000");
+        EXPECT_EQ(writes[3].value, "150000000000000000e+3");
+        EXPECT_EQ(writes[4].value, "a string longer than thirty-one");
+        EXPECT_EQ(writes[5].value, "<RecordedPose>");
+    }
+}
+
+// clang-format off
+static const char* xml_text_replay = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <IsReady/>
+            <RetryUntilSuccesful num_attempts="%d">
+                <Move/>
+            </RetryUntilSuccesful>
+            <AlwaysSuccess/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+TEST(FileLoggerTest, LogReplay)
+{
+    char xml_3_attempts[1024];
+    char xml_1_attempt[1024];
+    snprintf(xml_3_attempts, sizeof(xml_3_attempts), xml_text_replay, 3);
+    snprintf(xml_1_attempt, sizeof(xml_1_attempt), xml_text_replay, 1);
+
+    // RUNNING, FAILURE, RUNNING, SUCCESS, ...
+    int moves = 0;
+    BehaviorTreeFactory factory;
+    factory.registerSimpleCondition("IsReady", [](TreeNode&) { return NodeStatus::SUCCESS; });
+    factory.registerSimpleAction("Move", [&moves](TreeNode&) {
+        const int step = moves++ % 4;
+        return step == 1 ? NodeStatus::FAILURE :
+                           (step == 3 ? NodeStatus::SUCCESS : NodeStatus::RUNNING);
+    });
+
+    size_t ticks = 0;
+    {
+        auto tree = buildTreeFromText(factory, xml_3_attempts);
+        FileLogger logger(tree.root_node, "test_replay.fbl", 10);
+        for (int i = 0; i < 3; i++)
+        {
+            do
+            {
+                ticks++;
+            } while (tree.root_node->executeTick() == NodeStatus::RUNNING);
+        }
+    }
+
+    // the actions are stubs: Move is never executed
+    moves = 100;
+    LogReplay replay(factory, xml_3_attempts, "test_replay.fbl");
+    EXPECT_TRUE(replay.run());
+    EXPECT_EQ(moves, 100);
+    EXPECT_GT(replay.totalTransitions(), 0);
+    EXPECT_EQ(replay.replayedTransitions(), replay.totalTransitions());
+    EXPECT_LE(replay.tickCount(), ticks);
+    EXPECT_FALSE(replay.step());
+
+    // a different control logic
+    LogReplay wrong_replay(factory, xml_1_attempt, "test_replay.fbl");
+    EXPECT_FALSE(wrong_replay.run());
+    ASSERT_GE(wrong_replay.divergences().size(), 1);
+    EXPECT_EQ(wrong_replay.tickCount(), 1);
+
+    // the first one is the cause, the others follow in the same tick
+    const LogReplayDivergence& divergence = wrong_replay.divergences().front();
+    EXPECT_EQ(divergence.tick, 0);
+    EXPECT_EQ(divergence.node_name, "RetryUntilSuccesful");
+    ASSERT_TRUE(divergence.expected && divergence.actual);
+    EXPECT_EQ(divergence.expected->status, NodeStatus::SUCCESS);
+    EXPECT_EQ(divergence.actual->status, NodeStatus::FAILURE);
+    EXPECT_NE(toStr(divergence).find("expected RUNNING -> SUCCESS, got RUNNING -> FAILURE"),
+              std::string::npos)
+        << toStr(divergence);
+
+    // a different tree
+    EXPECT_THROW(LogReplay(factory, xml_text_logger, "test_replay.fbl"), BehaviorTreeException);
+    std::remove("test_replay.fbl");
+}
+
+#ifdef ZMQ_FOUND
+#include <zmq.hpp>
+#include "behaviortree_cpp/loggers/bt_zmq_publisher.h"
+
+// Frames of the next message received, ticking the tree until one is published.
+static std::vector<std::string> receiveMessage(zmq::socket_t& subscriber, TreeNode* root_node)
+{
+    std::vector<std::string> frames;
+    for (int i = 0; i < 100 && frames.empty(); i++)
+    {
+        root_node->executeTick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        zmq::message_t frame;
+        while (subscriber.recv(&frame, ZMQ_DONTWAIT))
+        {
+            frames.emplace_back(static_cast<const char*>(frame.data()), frame.size());
+            if (!subscriber.getsockopt<int>(ZMQ_RCVMORE))
+            {
+                break;
+            }
+        }
+    }
+    return frames;
+}
+
+static std::string requestTree(zmq::context_t& context, int port, const std::string& request)
+{
+    zmq::socket_t requester(context, ZMQ_REQ);
+    requester.connect("tcp://localhost:" + std::to_string(port));
+    zmq::message_t request_msg(request.size());
+    memcpy(request_msg.data(), request.data(), request.size());
+    requester.send(request_msg);
+    zmq::message_t reply;
+    requester.recv(&reply);
+    return std::string(static_cast<const char*>(reply.data()), reply.size());
+}
+
+// The root and the number of nodes of a serialized tree.
+static std::pair<int, int> treeSummary(const std::string& buffer)
+{
+    flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(buffer.data()),
+                                   buffer.size());
+    if (buffer.empty() || !BT_Serialization::VerifyBehaviorTreeBuffer(verifier))
+    {
+        return {-1, 0};
+    }
+    auto tree = BT_Serialization::GetBehaviorTree(buffer.data());
+    return {tree->root_uid(), static_cast<int>(tree->nodes()->size())};
+}
+
+static std::pair<int, int> treeSummary(TreeNode* root_node)
+{
+    int count = 0;
+    applyRecursiveVisitor(root_node, [&count](TreeNode*) { count++; });
+    return {root_node->UID(), count};
+}
+
+// [status section size][status section][transitions count][transitions]
+static void checkStatusMessage(const std::string& message)
+{
+    ASSERT_GE(message.size(), 8u);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(message.data());
+    const uint32_t status_size = flatbuffers::ReadScalar<uint32_t>(data);
+    ASSERT_EQ(0u, status_size % 3);
+    ASSERT_GE(message.size(), 8u + status_size);
+    const uint32_t transitions = flatbuffers::ReadScalar<uint32_t>(data + 4 + status_size);
+    EXPECT_EQ(message.size(), 8u + status_size + 12 * transitions);
+}
+
+TEST(PublisherZMQTest, SingleTreeProtocol)
+{
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_logger);
+    auto other_tree = buildTreeFromText(factory, xml_text_logger);
+
+    zmq::context_t context(1);
+    zmq::socket_t subscriber(context, ZMQ_SUB);
+    subscriber.connect("tcp://localhost:16666");
+    subscriber.setsockopt(ZMQ_SUBSCRIBE, "", 0);
+
+    auto hub = std::make_shared<PublisherHub>(16666, 16667);
+    PublisherZMQ publisher(tree.root_node, 100, std::chrono::milliseconds(1000), hub);
+    EXPECT_THROW(PublisherZMQ(other_tree.root_node, 100, std::chrono::milliseconds(1000), hub),
+                 std::logic_error);
+
+    // a single frame, as expected by Groot
+    std::vector<std::string> frames = receiveMessage(subscriber, tree.root_node);
+    ASSERT_EQ(1u, frames.size());
+    checkStatusMessage(frames[0]);
+
+    // any request returns the tree
+    EXPECT_EQ(treeSummary(tree.root_node), treeSummary(requestTree(context, 16667, "x")));
+}
+
+TEST(PublisherZMQTest, MultiTreeProtocol)
+{
+    BehaviorTreeFactory factory;
+    auto tree_A = buildTreeFromText(factory, xml_text_logger);
+    auto tree_B = buildTreeFromText(factory, xml_text_logger);
+
+    auto hub = std::make_shared<PublisherHub>(16668, 16669, true);
+    PublisherZMQ publisher_A(tree_A.root_node, 100, std::chrono::milliseconds(1000), hub);
+    PublisherZMQ publisher_B(tree_B.root_node, 100, std::chrono::milliseconds(1000), hub);
+    ASSERT_NE(publisher_A.treeID(), publisher_B.treeID());
+
+    std::string id_frame(3, '\0');
+    id_frame[0] = static_cast<char>(PublisherHub::MULTI_TREE_PROTOCOL_VERSION);
+    flatbuffers::WriteScalar<uint16_t>(&id_frame[1], publisher_B.treeID());
+
+    zmq::context_t context(1);
+    zmq::socket_t subscriber(context, ZMQ_SUB);
+    subscriber.connect("tcp://localhost:16668");
+    subscriber.setsockopt(ZMQ_SUBSCRIBE, id_frame.data(), id_frame.size());
+
+    std::vector<std::string> frames = receiveMessage(subscriber, tree_B.root_node);
+    ASSERT_EQ(2u, frames.size());
+    EXPECT_EQ(id_frame, frames[0]);
+    checkStatusMessage(frames[1]);
+
+    EXPECT_EQ(treeSummary(tree_B.root_node), treeSummary(requestTree(context, 16669, id_frame)));
+    EXPECT_EQ(treeSummary(tree_A.root_node), treeSummary(requestTree(context, 16669, "")));
+    id_frame[1] = 100;
+    EXPECT_EQ("", requestTree(context, 16669, id_frame));
+}
+
+TEST(PublisherZMQTest, ResyncAfterDrops)
+{
+    BehaviorTreeFactory factory;
+    auto tree = buildTreeFromText(factory, xml_text_logger);
+
+    zmq::context_t context(1);
+    zmq::socket_t subscriber(context, ZMQ_SUB);
+    subscriber.connect("tcp://localhost:16670");
+    subscriber.setsockopt(ZMQ_SUBSCRIBE, "", 0);
+
+    // a single keyframe, the first message
+    auto hub = std::make_shared<PublisherHub>(16670, 16671);
+    PublisherZMQ publisher(tree.root_node, 10, std::chrono::milliseconds(600000), hub);
+    std::vector<std::string> frames = receiveMessage(subscriber, tree.root_node);
+    ASSERT_EQ(1u, frames.size());
+
+    // the state seen by the subscriber
+    std::map<uint16_t, int8_t> statuses;
+    auto apply = [&statuses](const std::string& message) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(message.data());
+        const uint32_t status_size = flatbuffers::ReadScalar<uint32_t>(data);
+        for (uint32_t offset = 4; offset < 4 + status_size; offset += 3)
+        {
+            statuses[flatbuffers::ReadScalar<uint16_t>(data + offset)] =
+                flatbuffers::ReadScalar<int8_t>(data + offset + 2);
+        }
+    };
+    apply(frames[0]);
+
+    // more transitions than the queue can hold between two messages
+    const auto start = std::chrono::steady_clock::now();
+    while (publisher.droppedTransitions() == 0 &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+    {
+        tree.root_node->executeTick();
+    }
+    ASSERT_GT(publisher.droppedTransitions(), 0u);
+    for (int i = 0; i < 1000; i++)
+    {
+        tree.root_node->executeTick();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    zmq::message_t frame;
+    while (subscriber.recv(&frame, ZMQ_DONTWAIT))
+    {
+        apply(std::string(static_cast<const char*>(frame.data()), frame.size()));
+    }
+
+    applyRecursiveVisitor(tree.root_node, [&statuses](TreeNode* node) {
+        EXPECT_EQ(static_cast<int8_t>(convertToFlatbuffers(node->status())),
+                  statuses[node->UID()]);
+    });
+}
+#endif
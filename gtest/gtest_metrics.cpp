@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <fstream>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/metrics/metrics_http_server.h"
+#include "behaviortree_cpp/metrics/tree_metrics.h"
+
+using namespace BT;
+
+// clang-format off
+static const char* xml_text_metrics = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <AlwaysSuccess/>
+            <Step/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+static bool contains(const std::string& text, const std::string& line)
+{
+    return text.find(line + "\n") != std::string::npos;
+}
+
+TEST(MetricsTest, Registry)
+{
+    MetricsRegistry registry;
+
+    Counter& counter = registry.counter("requests", "Number of requests.", {{"path", "/a\"b"}});
+    EXPECT_EQ(&counter, &registry.counter("requests", "", {{"path", "/a\"b"}}));
+    EXPECT_THROW(registry.gauge("requests", ""), BehaviorTreeException);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&counter]() {
+            for (int i = 0; i < 10000; i++)
+            {
+                counter.inc();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(counter.value(), 80000);
+
+    registry.gauge("temperature", "").set(21.5);
+    registry.addCallback("answer", "", MetricType::GAUGE, {}, []() { return 42.0; });
+
+    Histogram& histogram = registry.histogram("latency", "", {0.1, 1.0});
+    histogram.observe(0.05);
+    histogram.observe(0.5);
+    histogram.observe(5.0);
+    EXPECT_EQ(histogram.count(), 3);
+    EXPECT_DOUBLE_EQ(histogram.sum(), 5.55);
+
+    const std::string text = registry.scrape();
+    EXPECT_TRUE(contains(text, "# TYPE requests counter"));
+    EXPECT_TRUE(contains(text, "# HELP requests Number of requests."));
+    EXPECT_TRUE(contains(text, "requests_total{path=\"/a\\\"b\"} 80000"));
+    EXPECT_TRUE(contains(text, "temperature 21.5"));
+    EXPECT_TRUE(contains(text, "answer 42"));
+    EXPECT_TRUE(contains(text, "latency_bucket{le=\"0.1\"} 1"));
+    EXPECT_TRUE(contains(text, "latency_bucket{le=\"1\"} 2"));
+    EXPECT_TRUE(contains(text, "latency_bucket{le=\"+Inf\"} 3"));
+    EXPECT_TRUE(contains(text, "latency_count 3"));
+    EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+
+    registry.remove("answer");
+    EXPECT_FALSE(contains(registry.scrape(), "answer 42"));
+
+    const std::string filename = "test_metrics.prom";
+    registry.writeFile(filename);
+    std::ifstream file(filename);
+    std::stringstream file_content;
+    file_content << file.rdbuf();
+    EXPECT_EQ(file_content.str(), registry.scrape());
+    std::remove(filename.c_str());
+}
+
+TEST(MetricsTest, TreeMetrics)
+{
+    int steps = 0;
+    BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Step", [&steps](TreeNode&) {
+        return (++steps % 2 == 0) ? NodeStatus::SUCCESS : NodeStatus::RUNNING;
+    });
+    auto tree = buildTreeFromText(factory, xml_text_metrics);
+
+    MetricsRegistry registry;
+    {
+        TreeMetrics metrics(registry, tree.root_node, "main", std::chrono::milliseconds(1));
+        EXPECT_EQ(metrics.tick(), NodeStatus::RUNNING);
+
+        const std::string text = registry.scrape();
+        EXPECT_TRUE(contains(text, "bt_tree_running_nodes{tree=\"main\"} 2"));
+        EXPECT_TRUE(contains(text, "bt_tree_async_actions_running{tree=\"main\"} 0"));
+
+        EXPECT_EQ(metrics.tick(), NodeStatus::SUCCESS);
+        metrics.recordTick(std::chrono::milliseconds(3), NodeStatus::FAILURE);
+    }
+    const std::string text = registry.scrape();
+    EXPECT_TRUE(contains(text, "bt_tree_ticks_total{tree=\"main\",status=\"success\"} 1"));
+    EXPECT_TRUE(contains(text, "bt_tree_ticks_total{tree=\"main\",status=\"running\"} 1"));
+    EXPECT_TRUE(contains(text, "bt_tree_ticks_total{tree=\"main\",status=\"failure\"} 1"));
+    EXPECT_TRUE(contains(text, "bt_tree_tick_duration_seconds_count{tree=\"main\"} 3"));
+    EXPECT_TRUE(contains(text, "bt_tree_tick_overruns_total{tree=\"main\"} 1"));
+    // removed with TreeMetrics
+    EXPECT_EQ(text.find("bt_tree_running_nodes"), std::string::npos);
+}
+
+TEST(MetricsTest, HttpServer)
+{
+    MetricsRegistry registry;
+    registry.counter("hits", "").inc(7);
+    MetricsHttpServer server(registry, 0);
+    ASSERT_GT(server.port(), 0);
+
+    auto request = [&server](const std::string& text) {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(server.port()));
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        std::string response;
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            send(fd, text.data(), text.size(), 0);
+            char buffer[1024];
+            ssize_t ret;
+            while ((ret = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            {
+                response.append(buffer, static_cast<size_t>(ret));
+            }
+        }
+        close(fd);
+        return response;
+    };
+
+    const std::string response = request("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    EXPECT_EQ(response.find("HTTP/1.1 200 OK\r\n"), 0);
+    EXPECT_NE(response.find("Content-Type: application/openmetrics-text"), std::string::npos);
+    EXPECT_NE(response.find("\r\n\r\n" + registry.scrape()), std::string::npos);
+
+    EXPECT_EQ(request("GET /other HTTP/1.1\r\n\r\n").find("HTTP/1.1 404"), 0);
+}
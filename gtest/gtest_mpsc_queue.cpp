@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "behaviortree_cpp/mpsc_queue.h"
+
+using BT::MPSCQueue;
+
+TEST(MPSCQueueTest, SingleThread)
+{
+    MPSCQueue<int> queue(5);
+    EXPECT_EQ(queue.capacity(), 8);
+
+    int value = 0;
+    EXPECT_FALSE(queue.pop(value));
+
+    for (int i = 0; i < 8; i++)
+    {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(8));
+
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            ASSERT_TRUE(queue.pop(value));
+            EXPECT_EQ(value, i);
+            EXPECT_TRUE(queue.push(i));
+        }
+    }
+}
+
+TEST(MPSCQueueTest, MultipleProducers)
+{
+    const int producers = 4;
+    const int count = 50000;
+    MPSCQueue<std::pair<int, int>> queue(256);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < count; i++)
+            {
+                while (!queue.push({p, i}))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // the values of each producer are received in order
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    std::pair<int, int> value;
+    while (received < producers * count)
+    {
+        if (queue.pop(value))
+        {
+            ASSERT_EQ(value.second, next[value.first]);
+            next[value.first]++;
+            received++;
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_FALSE(queue.pop(value));
+}
@@ -14,6 +14,8 @@
 #include "action_test_node.h"
 #include "condition_test_node.h"
 #include "behaviortree_cpp/behavior_tree.h"
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
 
 using BT::NodeStatus;
 
@@ -89,6 +91,38 @@ struct ComplexParallelTest : testing::Test
     }
 };
 
+struct ConcurrentParallelTest : SimpleParallelTest
+{
+    ConcurrentParallelTest()
+    {
+        root.setConcurrent(true);
+    }
+};
+
+// SUCCESS after (sleep_ms) milliseconds.
+class SleepAction : public BT::SyncActionNode
+{
+  public:
+    SleepAction(const std::string& name, int sleep_ms, bool throws = false)
+      : BT::SyncActionNode(name), sleep_ms_(sleep_ms), throws_(throws)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms_));
+        if (throws_)
+        {
+            throw std::runtime_error("SleepAction failed");
+        }
+        return NodeStatus::SUCCESS;
+    }
+
+  private:
+    int sleep_ms_;
+    bool throws_;
+};
+
 /****************TESTS START HERE***************************/
 
 TEST_F(SimpleParallelTest, ConditionsTrue)
@@ -196,3 +230,307 @@ TEST_F(ComplexParallelTest, Condition3FalseAction1Done)
     ASSERT_EQ(NodeStatus::IDLE, parallel_2.status());
     ASSERT_EQ(NodeStatus::SUCCESS, state);
 }
+
+TEST_F(ConcurrentParallelTest, ConditionsTrue)
+{
+    BT::NodeStatus state = root.executeTick();
+
+    ASSERT_EQ(NodeStatus::IDLE, condition_1.status());
+    ASSERT_EQ(NodeStatus::IDLE, condition_2.status());
+    ASSERT_EQ(NodeStatus::RUNNING, action_1.status());
+    ASSERT_EQ(NodeStatus::RUNNING, action_2.status());
+    ASSERT_EQ(NodeStatus::RUNNING, state);
+}
+
+TEST_F(ConcurrentParallelTest, Threshold_1)
+{
+    root.setThresholdM(1);
+    BT::NodeStatus state = root.executeTick();
+
+    ASSERT_EQ(NodeStatus::IDLE, condition_1.status());
+    ASSERT_EQ(NodeStatus::IDLE, condition_2.status());
+    ASSERT_EQ(NodeStatus::IDLE, action_1.status());
+    ASSERT_EQ(NodeStatus::IDLE, action_2.status());
+    ASSERT_EQ(NodeStatus::SUCCESS, state);
+}
+
+TEST(ConcurrentParallel, Latency)
+{
+    BT::ParallelNode root("root", 3);
+    SleepAction action_1("action_1", 30);
+    SleepAction action_2("action_2", 30);
+    SleepAction action_3("action_3", 30);
+    root.addChild(&action_1);
+    root.addChild(&action_2);
+    root.addChild(&action_3);
+    root.setConcurrent(true);
+
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(NodeStatus::SUCCESS, root.executeTick());
+    // the slowest child, not the sum of the three
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(80));
+}
+
+TEST(ConcurrentParallel, Exception)
+{
+    BT::ParallelNode root("root", 2);
+    SleepAction action_1("action_1", 1);
+    SleepAction action_2("action_2", 1, true);
+    root.addChild(&action_1);
+    root.addChild(&action_2);
+    root.setConcurrent(true);
+
+    ASSERT_THROW(root.executeTick(), std::runtime_error);
+    ASSERT_EQ(NodeStatus::IDLE, action_1.status());
+}
+
+TEST(ConcurrentParallel, TickThread)
+{
+    // each child checks the thread it is ticked on behalf of
+    std::atomic<int> errors(0);
+    auto check = [&errors](BT::TreeNode& node) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        const auto owner = node.blackboard()->get<std::thread::id>("owner");
+        const auto other = node.blackboard()->get<std::thread::id>("other");
+        if (BT::ParallelNode::tickThreadId() != owner || std::this_thread::get_id() == other)
+        {
+            errors++;
+        }
+        return NodeStatus::SUCCESS;
+    };
+
+    const char* xml_text = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <ParallelNode threshold="4" concurrent="true">
+            <Check/>
+            <Check/>
+            <ParallelNode threshold="2" concurrent="true">
+                <Check/>
+                <Check/>
+            </ParallelNode>
+            <Check/>
+        </ParallelNode>
+    </BehaviorTree>
+</root>)";
+
+    BT::BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Check", check);
+
+    // two trees ticked at the same time: a thread waiting for its children
+    // doesn't tick the ones of the other tree
+    std::vector<BT::Blackboard::Ptr> blackboards;
+    std::vector<BT::Tree> trees;
+    for (int i = 0; i < 2; i++)
+    {
+        blackboards.push_back(BT::Blackboard::create<BT::BlackboardLocal>());
+        trees.push_back(BT::buildTreeFromText(factory, xml_text, blackboards.back()));
+    }
+    std::vector<std::thread> threads;
+    std::atomic<int> ready(0);
+    for (int i = 0; i < 2; i++)
+    {
+        threads.emplace_back([&, i]() {
+            blackboards[i]->set("owner", std::this_thread::get_id());
+            ready++;
+            while (ready < 3)
+            {
+                std::this_thread::yield();
+            }
+            for (int tick = 0; tick < 50; tick++)
+            {
+                trees[i].root_node->executeTick();
+            }
+        });
+    }
+    blackboards[0]->set("other", threads[1].get_id());
+    blackboards[1]->set("other", threads[0].get_id());
+    ready++;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(0, errors);
+}
+
+TEST(ConcurrentParallel, Blackboard)
+{
+    const char* xml_text = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <ParallelNode threshold="4" concurrent="true">
+            <Write name="A"/>
+            <Write name="B"/>
+            <Write name="C"/>
+            <Write name="D"/>
+        </ParallelNode>
+    </BehaviorTree>
+</root>)";
+
+    BT::BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Write", [](BT::TreeNode& node) {
+        for (int i = 0; i < 100; i++)
+        {
+            node.blackboard()->set(node.name(), i);
+        }
+        return NodeStatus::SUCCESS;
+    });
+    auto blackboard = BT::Blackboard::create<BT::BlackboardLocal>();
+    auto tree = BT::buildTreeFromText(factory, xml_text, blackboard);
+    // before the first tick
+    ASSERT_TRUE(blackboard->isThreadSafe());
+
+    ASSERT_EQ(NodeStatus::SUCCESS, tree.root_node->executeTick());
+    for (const char* key : {"A", "B", "C", "D"})
+    {
+        ASSERT_EQ(99, blackboard->get<int>(key));
+    }
+
+    // in any order
+    BT::ParallelNode parallel("parallel", 1);
+    auto first = BT::Blackboard::create<BT::BlackboardLocal>();
+    parallel.setBlackboard(first);
+    ASSERT_FALSE(first->isThreadSafe());
+    parallel.setConcurrent(true);
+    ASSERT_TRUE(first->isThreadSafe());
+
+    auto second = BT::Blackboard::create<BT::BlackboardLocal>();
+    parallel.setBlackboard(second);
+    ASSERT_TRUE(second->isThreadSafe());
+}
+
+struct PolicyParallelTest : testing::Test
+{
+    BT::PolicyParallelNode root;
+    BT::ConditionTestNode condition_1;
+    BT::AsyncActionTest action_1;
+    BT::AsyncActionTest action_2;
+
+    PolicyParallelTest()
+      : root("root_policy_parallel")
+      , condition_1("condition_1")
+      , action_1("action_1")
+      , action_2("action_2")
+    {
+        root.addChild(&condition_1);
+        root.addChild(&action_1);
+        root.addChild(&action_2);
+        action_1.setTime(1);
+        action_2.setTime(3);
+    }
+    ~PolicyParallelTest()
+    {
+        haltAllActions(&root);
+    }
+
+    NodeStatus tickWhileRunning()
+    {
+        NodeStatus state = root.executeTick();
+        while (state == NodeStatus::RUNNING)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            state = root.executeTick();
+        }
+        return state;
+    }
+};
+
+TEST_F(PolicyParallelTest, SucceedOnAll)
+{
+    ASSERT_EQ(NodeStatus::SUCCESS, tickWhileRunning());
+
+    // the completed children are not ticked again
+    ASSERT_EQ(1, condition_1.tickCount());
+    ASSERT_EQ(3u, root.completedCount());
+    for (size_t i = 0; i < 3; i++)
+    {
+        ASSERT_EQ(NodeStatus::SUCCESS, root.childStatus(i));
+    }
+    ASSERT_EQ(NodeStatus::IDLE, action_1.status());
+    ASSERT_EQ(NodeStatus::IDLE, action_2.status());
+
+    // a new execution starts from scratch
+    root.executeTick();
+    ASSERT_EQ(2, condition_1.tickCount());
+    ASSERT_EQ(NodeStatus::RUNNING, root.childStatus(1));
+}
+
+TEST_F(PolicyParallelTest, FailOnOne)
+{
+    condition_1.setBoolean(false);
+    ASSERT_EQ(NodeStatus::FAILURE, root.executeTick());
+
+    ASSERT_EQ(NodeStatus::FAILURE, root.childStatus(0));
+    ASSERT_EQ(NodeStatus::IDLE, root.childStatus(1));
+    ASSERT_EQ(NodeStatus::IDLE, action_1.status());
+}
+
+TEST_F(PolicyParallelTest, SucceedOnOne)
+{
+    BT::PolicyParallelNode parallel("parallel", BT::SUCCEED_ON_ONE, BT::FAIL_ON_ALL);
+    parallel.addChild(&action_1);
+    parallel.addChild(&action_2);
+
+    ASSERT_EQ(NodeStatus::RUNNING, parallel.executeTick());
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    ASSERT_EQ(NodeStatus::SUCCESS, parallel.executeTick());
+
+    // the slowest child is halted
+    ASSERT_EQ(NodeStatus::SUCCESS, parallel.childStatus(0));
+    ASSERT_EQ(NodeStatus::IDLE, parallel.childStatus(1));
+    ASSERT_EQ(NodeStatus::IDLE, action_2.status());
+}
+
+TEST_F(PolicyParallelTest, FailOnAll)
+{
+    BT::PolicyParallelNode parallel("parallel", BT::SUCCEED_ON_ALL, BT::FAIL_ON_ALL);
+    parallel.addChild(&condition_1);
+    parallel.addChild(&action_1);
+    condition_1.setBoolean(false);
+
+    NodeStatus state = parallel.executeTick();
+    while (state == NodeStatus::RUNNING)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        state = parallel.executeTick();
+    }
+
+    // the SuccessPolicy can't be met anymore
+    ASSERT_EQ(NodeStatus::FAILURE, state);
+    ASSERT_EQ(1, condition_1.tickCount());
+    ASSERT_EQ(NodeStatus::FAILURE, parallel.childStatus(0));
+    ASSERT_EQ(NodeStatus::SUCCESS, parallel.childStatus(1));
+}
+
+TEST(PolicyParallel, Parameters)
+{
+    const char* xml_text = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <PolicyParallel success_policy="SUCCEED_ON_ONE" failure_policy="FAIL_ON_ALL">
+            <AlwaysFailure/>
+            <AlwaysSuccess/>
+        </PolicyParallel>
+    </BehaviorTree>
+</root>)";
+
+    BT::BehaviorTreeFactory factory;
+    auto tree = BT::buildTreeFromText(factory, xml_text);
+    auto parallel = dynamic_cast<BT::PolicyParallelNode*>(tree.root_node);
+    ASSERT_TRUE(parallel != nullptr);
+    ASSERT_EQ(BT::SUCCEED_ON_ONE, parallel->successPolicy());
+    ASSERT_EQ(BT::FAIL_ON_ALL, parallel->failurePolicy());
+    ASSERT_EQ(NodeStatus::SUCCESS, parallel->executeTick());
+
+    // the defaults
+    tree = BT::buildTreeFromText(factory, R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <PolicyParallel><AlwaysSuccess/></PolicyParallel>
+    </BehaviorTree>
+</root>)");
+    parallel = dynamic_cast<BT::PolicyParallelNode*>(tree.root_node);
+    ASSERT_TRUE(parallel != nullptr);
+    ASSERT_EQ(BT::SUCCEED_ON_ALL, parallel->successPolicy());
+    ASSERT_EQ(BT::FAIL_ON_ONE, parallel->failurePolicy());
+}
@@ -0,0 +1,518 @@
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sched.h>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/tick_driver.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
+#include "behaviortree_cpp/metrics/tree_metrics.h"
+
+using namespace BT;
+
+// clang-format off
+static const char* xml_text_driver = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <AsyncWork/>
+            <Count/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+// Records the CPU of its thread.
+class AsyncWork : public AsyncActionNode
+{
+  public:
+    AsyncWork(const std::string& name) : AsyncActionNode(name), cpu(-1)
+    {
+    }
+
+    ~AsyncWork() override
+    {
+        stopAndJoinThread();
+    }
+
+    NodeStatus tick() override
+    {
+        cpu = sched_getcpu();
+        return NodeStatus::SUCCESS;
+    }
+
+    void halt() override
+    {
+    }
+
+    std::atomic<int> cpu;
+};
+
+// Succeeds after 50 milliseconds.
+class AsyncSleep : public AsyncActionNode
+{
+  public:
+    AsyncSleep(const std::string& name) : AsyncActionNode(name)
+    {
+    }
+
+    ~AsyncSleep() override
+    {
+        stopAndJoinThread();
+    }
+
+    NodeStatus tick() override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return NodeStatus::SUCCESS;
+    }
+
+    void halt() override
+    {
+    }
+};
+
+// RUNNING until halted; the parent sets it IDLE.
+class KeepRunning : public ActionNodeBase
+{
+  public:
+    KeepRunning(const std::string& name) : ActionNodeBase(name), halts(0)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        return NodeStatus::RUNNING;
+    }
+
+    void halt() override
+    {
+        halts++;
+    }
+
+    std::atomic<int> halts;
+};
+
+struct TickDriverTest : testing::Test
+{
+    BehaviorTreeFactory factory;
+    std::atomic<int> count;
+    std::atomic<int> tick_cpu;
+    int running_ticks;
+    std::chrono::milliseconds tick_duration;
+    int slow_ticks;
+    std::vector<std::chrono::steady_clock::time_point> tick_times;
+
+    TickDriverTest()
+      : count(0), tick_cpu(-1), running_ticks(1000000), tick_duration(0), slow_ticks(1000000)
+    {
+        factory.registerNodeType<AsyncWork>("AsyncWork");
+        // RUNNING, until it is ticked (running_ticks) times. The first (slow_ticks)
+        // ticks last (tick_duration).
+        factory.registerSimpleAction("Count", [this](TreeNode&) {
+            tick_cpu = sched_getcpu();
+            tick_times.push_back(std::chrono::steady_clock::now());
+            if (count < slow_ticks)
+            {
+                std::this_thread::sleep_for(tick_duration);
+            }
+            return ++count > running_ticks ? NodeStatus::SUCCESS : NodeStatus::RUNNING;
+        });
+    }
+
+    // Period of 10 ms; the first tick lasts 42 ms and misses 4 deadlines.
+    TickDriverOptions runWithOverrun(OverrunPolicy policy, unsigned max_catch_up_ticks = 10)
+    {
+        running_ticks = 6;
+        slow_ticks = 1;
+        tick_duration = std::chrono::milliseconds(42);
+        auto tree = buildTreeFromText(factory, xml_text_driver);
+
+        TickDriverOptions options(std::chrono::milliseconds(10));
+        options.overrun_policy = policy;
+        options.max_catch_up_ticks = max_catch_up_ticks;
+        TickDriver driver(tree.root_node, options);
+        EXPECT_EQ(NodeStatus::SUCCESS, driver.run());
+
+        // the ticks that follow are late, but they are not overruns
+        EXPECT_EQ(1u, driver.statistics().overruns);
+        const auto overruns = driver.overruns();
+        EXPECT_EQ(1u, overruns.size());
+        if (!overruns.empty())
+        {
+            EXPECT_EQ(0u, overruns[0].tick);
+            EXPECT_GE(overruns[0].lateness(), std::chrono::milliseconds(32));
+        }
+        return options;
+    }
+
+    // since the first tick
+    std::chrono::milliseconds tickTime(size_t index) const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(tick_times.at(index) -
+                                                                     tick_times.front());
+    }
+};
+
+TEST_F(TickDriverTest, FixedRate)
+{
+    running_ticks = 20;
+    auto tree = buildTreeFromText(factory, xml_text_driver);
+
+    TickDriver driver(tree.root_node, TickDriverOptions(std::chrono::milliseconds(2)));
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(NodeStatus::SUCCESS, driver.run());
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // the first tick is immediate
+    EXPECT_EQ(21, count);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(40));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(200));
+
+    const TickJitterStatistics stats = driver.statistics();
+    EXPECT_EQ(21u, stats.ticks);
+    EXPECT_LE(stats.percentileNs(0.5), stats.max_ns);
+    EXPECT_EQ(NodeStatus::SUCCESS, driver.lastStatus());
+}
+
+TEST_F(TickDriverTest, StartStop)
+{
+    auto tree = buildTreeFromText(factory, xml_text_driver);
+
+    TickDriver driver(tree.root_node, TickDriverOptions(std::chrono::seconds(10)));
+    driver.start();
+    while (count == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // interrupts the wait of the next deadline
+    const auto start = std::chrono::steady_clock::now();
+    driver.stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    EXPECT_EQ(1, count);
+    EXPECT_EQ(NodeStatus::RUNNING, driver.lastStatus());
+    EXPECT_EQ(1u, driver.statistics().ticks);
+}
+
+TEST_F(TickDriverTest, Overruns)
+{
+    // each tick starts within a period of its deadline, even on a loaded machine
+    running_ticks = 5;
+    tick_duration = std::chrono::milliseconds(30);
+    auto tree = buildTreeFromText(factory, xml_text_driver);
+
+    TickDriver driver(tree.root_node, TickDriverOptions(std::chrono::milliseconds(10)));
+    ASSERT_EQ(NodeStatus::SUCCESS, driver.run());
+    EXPECT_EQ(5u, driver.statistics().overruns);
+    EXPECT_EQ(5u, driver.overruns().size());
+}
+
+TEST_F(TickDriverTest, Metrics)
+{
+    running_ticks = 5;
+    tick_duration = std::chrono::milliseconds(30);
+    auto tree = buildTreeFromText(factory, xml_text_driver);
+
+    MetricsRegistry registry;
+    TreeMetrics metrics(registry, tree.root_node, "main");
+    TickDriverOptions options(std::chrono::milliseconds(10));
+    options.metrics = &metrics;
+    TickDriver driver(tree.root_node, options);
+    ASSERT_EQ(NodeStatus::SUCCESS, driver.run());
+
+    const auto stats = driver.statistics();
+    const std::string text = registry.scrape();
+    const auto contains = [&text](const std::string& line) {
+        return text.find(line + "\n") != std::string::npos;
+    };
+    EXPECT_TRUE(contains("bt_tree_ticks_total{tree=\"main\",status=\"running\"} " +
+                         std::to_string(stats.ticks - 1)));
+    EXPECT_TRUE(contains("bt_tree_ticks_total{tree=\"main\",status=\"success\"} 1"));
+    EXPECT_TRUE(contains("bt_tree_tick_duration_seconds_count{tree=\"main\"} " +
+                         std::to_string(stats.ticks)));
+    EXPECT_GT(stats.overruns, 0u);
+    EXPECT_TRUE(contains("bt_tree_tick_overruns_total{tree=\"main\"} " +
+                         std::to_string(stats.overruns)));
+}
+
+TEST_F(TickDriverTest, OverrunSkip)
+{
+    runWithOverrun(OverrunPolicy::SKIP);
+    ASSERT_EQ(7u, tick_times.size());
+    // on the original grid: 50, 60, ...
+    EXPECT_GE(tickTime(1), std::chrono::milliseconds(49));
+    EXPECT_GE(tickTime(2), std::chrono::milliseconds(59));
+}
+
+TEST_F(TickDriverTest, OverrunCatchUp)
+{
+    runWithOverrun(OverrunPolicy::CATCH_UP);
+    ASSERT_EQ(7u, tick_times.size());
+    // the deadlines 10, 20, 30 and 40 are recovered immediately, then 50
+    EXPECT_LT(tickTime(4), std::chrono::milliseconds(49));
+    EXPECT_GE(tickTime(5), std::chrono::milliseconds(49));
+}
+
+TEST_F(TickDriverTest, OverrunCatchUpLimited)
+{
+    runWithOverrun(OverrunPolicy::CATCH_UP, 2);
+    ASSERT_EQ(7u, tick_times.size());
+    // only 30 and 40 are recovered
+    EXPECT_LT(tickTime(2), std::chrono::milliseconds(49));
+    EXPECT_GE(tickTime(3), std::chrono::milliseconds(49));
+}
+
+TEST_F(TickDriverTest, OverrunStretch)
+{
+    runWithOverrun(OverrunPolicy::STRETCH);
+    ASSERT_EQ(7u, tick_times.size());
+    // immediately, then every 10 ms from there
+    EXPECT_LT(tickTime(1), std::chrono::milliseconds(49));
+    EXPECT_GE(tickTime(2) - tickTime(1), std::chrono::milliseconds(9));
+    EXPECT_GE(tickTime(3) - tickTime(1), std::chrono::milliseconds(19));
+}
+
+TEST(TickDriverHaltTest, HaltOnStop)
+{
+    static const char* xml_text = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <AlwaysSuccess/>
+            <KeepRunning/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+
+    BehaviorTreeFactory factory;
+    factory.registerNodeType<KeepRunning>("KeepRunning");
+
+    for (bool halt_on_stop : {true, false})
+    {
+        auto tree = buildTreeFromText(factory, xml_text);
+        KeepRunning* action = nullptr;
+        for (const auto& node : tree.nodes)
+        {
+            if (auto keep_running = dynamic_cast<KeepRunning*>(node.get()))
+            {
+                action = keep_running;
+            }
+        }
+        ASSERT_TRUE(action);
+
+        TickDriverOptions options(std::chrono::milliseconds(1));
+        options.halt_on_stop = halt_on_stop;
+        TickDriver driver(tree.root_node, options);
+        driver.start();
+        while (driver.lastStatus() != NodeStatus::RUNNING)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        driver.stop();
+
+        EXPECT_EQ(NodeStatus::RUNNING, driver.lastStatus());
+        EXPECT_EQ(halt_on_stop ? 1 : 0, action->halts.load());
+        EXPECT_EQ(halt_on_stop ? NodeStatus::IDLE : NodeStatus::RUNNING,
+                  tree.root_node->status());
+    }
+}
+
+TEST_F(TickDriverTest, RealTimeProfile)
+{
+    running_ticks = 3;
+    auto tree = buildTreeFromText(factory, xml_text_driver);
+
+    TickDriverOptions options(std::chrono::milliseconds(1));
+    options.tick_cpu = 0;
+    options.worker_cpus = {0};
+    options.policy = SchedulingPolicy::FIFO;
+    options.tick_priority = 10;
+    options.worker_priority = 5;
+    options.prefault_stack_size = 64 * 1024;
+
+    // in its own thread, not to change the scheduling of this one
+    TickDriver driver(tree.root_node, options);
+    driver.start();
+    while (driver.lastStatus() != NodeStatus::SUCCESS)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    driver.stop();
+    EXPECT_EQ(0, tick_cpu);
+
+    AsyncWork* async_node = nullptr;
+    for (const auto& node : tree.nodes)
+    {
+        if (auto async = dynamic_cast<AsyncWork*>(node.get()))
+        {
+            async_node = async;
+        }
+    }
+    ASSERT_TRUE(async_node);
+    EXPECT_EQ(0, async_node->cpu);
+
+    // SCHED_FIFO requires CAP_SYS_NICE: the failures are reported, one per thread
+    const auto warnings = driver.warnings();
+    EXPECT_TRUE(warnings.empty() || warnings.size() == 2);
+}
+
+struct EventDrivenTest : testing::Test
+{
+    BehaviorTreeFactory factory;
+    TickDriverOptions options;
+
+    EventDrivenTest() : options(std::chrono::milliseconds(1))
+    {
+        factory.registerNodeType<AsyncSleep>("AsyncSleep");
+        factory.registerNodeType<KeepRunning>("KeepRunning");
+        options.event_driven = true;
+    }
+
+    Tree build(const char* tree_xml, const Blackboard::Ptr& blackboard = Blackboard::Ptr())
+    {
+        const std::string xml_text = std::string(R"(<root main_tree_to_execute = "MainTree">
+                                                    <BehaviorTree ID="MainTree">)") +
+                                     tree_xml + "</BehaviorTree></root>";
+        return buildTreeFromText(factory, xml_text, blackboard);
+    }
+};
+
+TEST_F(EventDrivenTest, AsyncCompletion)
+{
+    auto tree = build("<Sequence><AsyncSleep/><AsyncSleep/></Sequence>");
+    TickDriver driver(tree.root_node, options);
+    ASSERT_EQ(NodeStatus::SUCCESS, driver.run());
+
+    // one tick to start each action, and one after the completion of the second
+    // one; 100 periodic ticks are skipped
+    EXPECT_LE(driver.statistics().ticks, 4u);
+}
+
+TEST_F(EventDrivenTest, TimeoutExpiry)
+{
+    auto tree = build(R"(<Timeout msec="30"><KeepRunning/></Timeout>)");
+    TickDriver driver(tree.root_node, options);
+    ASSERT_EQ(NodeStatus::FAILURE, driver.run());
+    EXPECT_EQ(2u, driver.statistics().ticks);
+}
+
+TEST_F(EventDrivenTest, WatchedKeys)
+{
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    blackboard->set("value", 0);
+    factory.registerSimpleCondition("IsReady", [](TreeNode& node) {
+        return node.blackboard()->get<int>("value") == 42 ? NodeStatus::SUCCESS :
+                                                            NodeStatus::FAILURE;
+    });
+    auto tree = build(R"(<Fallback><IsReady/><KeepRunning/></Fallback>)", blackboard);
+
+    TickDriver driver(tree.root_node, options);
+    driver.watchBlackboard(blackboard, {"value"});
+    driver.start();
+    while (driver.lastStatus() != NodeStatus::RUNNING)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // the tree is parked
+    blackboard->set("other", 42);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(1u, driver.statistics().ticks);
+
+    blackboard->set("value", 42);
+    const auto start = std::chrono::steady_clock::now();
+    while (driver.lastStatus() == NodeStatus::RUNNING &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(NodeStatus::SUCCESS, driver.lastStatus());
+    EXPECT_EQ(2u, driver.statistics().ticks);
+    driver.stop();
+}
+
+TEST_F(EventDrivenTest, ConcurrentParallel)
+{
+    factory.registerSimpleCondition("Ready", [](TreeNode&) { return NodeStatus::SUCCESS; });
+    factory.registerSimpleAction("SlowRunning", [](TreeNode&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return NodeStatus::RUNNING;
+    });
+    auto tree = build(R"(
+        <ParallelNode threshold="3" concurrent="true">
+            <SlowRunning/>
+            <Ready/>
+            <Ready/>
+        </ParallelNode>)");
+
+    // the children ticked by the threads of the pool meanwhile don't wake the driver up
+    TickDriver driver(tree.root_node, options);
+    driver.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    driver.stop();
+    EXPECT_EQ(1u, driver.statistics().ticks);
+}
+
+TEST_F(EventDrivenTest, IdleTimeout)
+{
+    options.idle_timeout = std::chrono::milliseconds(5);
+    auto tree = build("<KeepRunning/>");
+
+    TickDriver driver(tree.root_node, options);
+    driver.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    driver.stop();
+    EXPECT_GT(driver.statistics().ticks, 2u);
+    EXPECT_LT(driver.statistics().ticks, 20u);
+}
+
+TEST_F(EventDrivenTest, EventFd)
+{
+    auto tree = build("<KeepRunning/>");
+    TickDriver driver(tree.root_node, options);
+    ASSERT_GE(driver.eventFd(), 0);
+
+    auto readable = [&driver]() {
+        pollfd fd;
+        fd.fd = driver.eventFd();
+        fd.events = POLLIN;
+        return poll(&fd, 1, 0) == 1;
+    };
+
+    EXPECT_EQ(NodeStatus::RUNNING, driver.processEvents());
+    EXPECT_FALSE(readable());
+
+    std::thread([&driver]() { driver.notify(); }).join();
+    EXPECT_TRUE(readable());
+    EXPECT_EQ(NodeStatus::RUNNING, driver.processEvents());
+    EXPECT_FALSE(readable());
+    EXPECT_EQ(2u, driver.statistics().ticks);
+}
+
+TEST_F(EventDrivenTest, DestroyWhileNotified)
+{
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    auto tree = build("<KeepRunning/>", blackboard);
+
+    // the driver is destroyed while another thread writes a watched key
+    for (int i = 0; i < 50; i++)
+    {
+        std::atomic<bool> done(false);
+        std::thread writer;
+        {
+            TickDriver driver(tree.root_node, options);
+            driver.watchBlackboard(blackboard, {"value"});
+            writer = std::thread([&]() {
+                int value = 0;
+                while (!done)
+                {
+                    blackboard->set("value", value++);
+                }
+            });
+            driver.processEvents();
+        }
+        done = true;
+        writer.join();
+    }
+}
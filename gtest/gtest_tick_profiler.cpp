@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/tick_profiler.h"
+
+using namespace BT;
+
+// clang-format off
+static const char* xml_text_profiler = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Fallback name="root">
+            <Inverter>
+                <Sleep name="sleep"/>
+            </Inverter>
+            <AlwaysFailure name="failure"/>
+        </Fallback>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+static NodeStatus sleepOneMillisecond(TreeNode&)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return NodeStatus::SUCCESS;
+}
+
+TEST(TickProfilerTest, Buckets)
+{
+    for (uint64_t ns = 0; ns < 100000; ns = ns * 2 + 1)
+    {
+        for (uint64_t value : {ns, ns + 1, ns * 3 / 2})
+        {
+            const size_t index = TickProfiler::bucketIndex(value);
+            ASSERT_LT(index + 1, TickProfiler::BUCKETS);
+            EXPECT_LE(TickProfiler::bucketLowerBound(index), value);
+            EXPECT_GT(TickProfiler::bucketLowerBound(index + 1), value);
+        }
+    }
+    EXPECT_EQ(TickProfiler::bucketIndex(uint64_t(1) << 62), TickProfiler::BUCKETS - 1);
+}
+
+TEST(TickProfilerTest, Statistics)
+{
+    BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Sleep", sleepOneMillisecond);
+    auto tree = buildTreeFromText(factory, xml_text_profiler);
+
+    std::unique_ptr<TickProfiler> profiler(new TickProfiler(tree.root_node));
+    for (int i = 0; i < 20; i++)
+    {
+        EXPECT_EQ(tree.root_node->executeTick(), NodeStatus::FAILURE);
+    }
+
+    auto statistics = profiler->snapshot();
+    ASSERT_EQ(statistics.size(), 4);
+    const NodeTickStatistics& root = statistics[0];
+    const NodeTickStatistics& sleep = statistics[2];
+    const NodeTickStatistics& failure = statistics[3];
+
+    EXPECT_EQ(root.name, "root");
+    EXPECT_EQ(root.ticks, 20);
+    EXPECT_EQ(root.failure, 20);
+    EXPECT_EQ(sleep.name, "sleep");
+    EXPECT_EQ(sleep.success, 20);
+    EXPECT_EQ(failure.failure, 20);
+
+    // the time of a node includes the children
+    EXPECT_GE(sleep.percentileNs(0.5), 1000000 * 3 / 4);
+    EXPECT_LE(sleep.percentileNs(0.5), sleep.percentileNs(0.99));
+    EXPECT_LE(sleep.percentileNs(0.99), sleep.max_ns);
+    EXPECT_GE(root.total_ns, sleep.total_ns);
+    EXPECT_LT(failure.max_ns, sleep.max_ns);
+
+    std::ostringstream table;
+    profiler->dumpTable(table);
+    EXPECT_NE(table.str().find("sleep"), std::string::npos);
+
+    std::ostringstream json;
+    profiler->dumpJSON(json);
+    EXPECT_NE(json.str().find("\"name\": \"failure\""), std::string::npos);
+
+    profiler->reset();
+    EXPECT_EQ(profiler->snapshot()[0].ticks, 0);
+
+    // detached when destroyed
+    profiler.reset();
+    tree.root_node->executeTick();
+}
+
+TEST(TickProfilerTest, SeveralMonitors)
+{
+    BehaviorTreeFactory factory;
+    factory.registerSimpleAction("Sleep", sleepOneMillisecond);
+    auto tree = buildTreeFromText(factory, xml_text_profiler);
+
+    struct CountTicks : public TickMonitor
+    {
+        int ticks = 0;
+        void onTick(const TreeNode&, size_t, MonitorTime, std::chrono::nanoseconds,
+                    NodeStatus) override
+        {
+            ticks++;
+        }
+    } counter;
+    tree.root_node->addTickMonitor(&counter);
+    EXPECT_THROW(tree.root_node->addTickMonitor(&counter), std::logic_error);
+
+    // the profiler doesn't replace the monitor, nor detaches it when destroyed
+    std::unique_ptr<TickProfiler> profiler(new TickProfiler(tree.root_node));
+    tree.root_node->executeTick();
+    EXPECT_EQ(counter.ticks, 1);
+    EXPECT_EQ(profiler->snapshot()[0].ticks, 1);
+
+    profiler.reset();
+    tree.root_node->executeTick();
+    EXPECT_EQ(counter.ticks, 2);
+
+    EXPECT_TRUE(tree.root_node->removeTickMonitor(&counter));
+    EXPECT_FALSE(tree.root_node->removeTickMonitor(&counter));
+    tree.root_node->executeTick();
+    EXPECT_EQ(counter.ticks, 2);
+}
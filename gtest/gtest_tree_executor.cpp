@@ -0,0 +1,331 @@
+#include <gtest/gtest.h>
+#include <map>
+#include "behaviortree_cpp/xml_parsing.h"
+#include "behaviortree_cpp/tree_executor.h"
+#include "behaviortree_cpp/metrics/tree_metrics.h"
+
+using namespace BT;
+
+// clang-format off
+static const char* xml_text_executor = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+            <AlwaysSuccess/>
+            <CountTicks/>
+        </Sequence>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+// RUNNING until it is ticked (running_ticks) times; detects concurrent ticks and halts.
+class CountTicks : public ActionNodeBase
+{
+  public:
+    CountTicks(const std::string& name)
+      : ActionNodeBase(name), running_ticks(10), ticks(0), overlaps(0), halts(0), inside_(false)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        if (inside_.exchange(true))
+        {
+            overlaps++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.push_back(std::this_thread::get_id());
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        const bool done = ++ticks > running_ticks;
+        inside_ = false;
+        return done ? NodeStatus::SUCCESS : NodeStatus::RUNNING;
+    }
+
+    void halt() override
+    {
+        if (inside_)
+        {
+            overlaps++;
+        }
+        halts++;
+    }
+
+    int running_ticks;
+    std::atomic<int> ticks;
+    std::atomic<int> overlaps;
+    std::atomic<int> halts;
+    std::mutex mutex;
+    std::vector<std::thread::id> threads;
+
+  private:
+    std::atomic<bool> inside_;
+};
+
+struct TreeExecutorTest : testing::Test
+{
+    BehaviorTreeFactory factory;
+    std::vector<Tree> trees;
+
+    TreeExecutorTest()
+    {
+        factory.registerNodeType<CountTicks>("CountTicks");
+    }
+
+    CountTicks* addTree()
+    {
+        trees.push_back(buildTreeFromText(factory, xml_text_executor));
+        for (const auto& node : trees.back().nodes)
+        {
+            if (auto counter = dynamic_cast<CountTicks*>(node.get()))
+            {
+                return counter;
+            }
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(TreeExecutorTest, ManyTrees)
+{
+    std::vector<CountTicks*> counters;
+    for (int i = 0; i < 50; i++)
+    {
+        counters.push_back(addTree());
+    }
+
+    TreeExecutor executor(TreeExecutorOptions(4));
+    std::vector<TreeExecutor::TreeID> ids;
+    for (const auto& tree : trees)
+    {
+        ids.push_back(executor.add(tree.root_node, TreeScheduleHints(std::chrono::microseconds(0))));
+    }
+    for (auto id : ids)
+    {
+        EXPECT_EQ(NodeStatus::SUCCESS, executor.wait(id));
+    }
+
+    for (auto counter : counters)
+    {
+        EXPECT_EQ(11, counter->ticks);
+        EXPECT_EQ(0, counter->overlaps);
+    }
+    EXPECT_EQ(50u * 11, executor.ticks());
+    EXPECT_EQ(50u, executor.size());
+}
+
+TEST_F(TreeExecutorTest, Rate)
+{
+    addTree();
+    TreeExecutor executor(TreeExecutorOptions(2));
+
+    const auto start = std::chrono::steady_clock::now();
+    auto id = executor.add(trees[0].root_node, TreeScheduleHints(std::chrono::milliseconds(5)));
+    EXPECT_EQ(NodeStatus::SUCCESS, executor.wait(id));
+    // 11 ticks, the first one immediate
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+}
+
+TEST_F(TreeExecutorTest, Metrics)
+{
+    addTree();
+    MetricsRegistry registry;
+    TreeMetrics metrics(registry, trees[0].root_node, "main");
+    TreeExecutor executor(TreeExecutorOptions(2));
+
+    TreeScheduleHints hints(std::chrono::microseconds(0));
+    hints.metrics = &metrics;
+    EXPECT_EQ(NodeStatus::SUCCESS, executor.wait(executor.add(trees[0].root_node, hints)));
+
+    const std::string text = registry.scrape();
+    EXPECT_NE(text.find("bt_tree_ticks_total{tree=\"main\",status=\"running\"} 10\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bt_tree_ticks_total{tree=\"main\",status=\"success\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bt_tree_tick_duration_seconds_count{tree=\"main\"} 11\n"),
+              std::string::npos);
+}
+
+TEST_F(TreeExecutorTest, Priority)
+{
+    CountTicks* low = addTree();
+    CountTicks* high = addTree();
+
+    // the only worker is busy while the other trees are added
+    std::atomic<bool> blocked(false);
+    std::atomic<bool> release(false);
+    factory.registerSimpleAction("Block", [&blocked, &release](TreeNode&) {
+        blocked = true;
+        while (!release)
+        {
+            std::this_thread::yield();
+        }
+        return NodeStatus::SUCCESS;
+    });
+    auto block_tree = buildTreeFromText(factory, R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree"><Block/></BehaviorTree>
+</root>)");
+
+    TreeExecutor executor(TreeExecutorOptions(1));
+    auto block_id = executor.add(block_tree.root_node);
+    while (!blocked)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    TreeScheduleHints hints(std::chrono::milliseconds(100));
+    auto low_id = executor.add(trees[0].root_node, hints);
+    hints.priority = 10;
+    auto high_id = executor.add(trees[1].root_node, hints);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    release = true;
+    EXPECT_EQ(NodeStatus::SUCCESS, executor.wait(block_id));
+
+    while (low->ticks == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(1, high->ticks);
+    executor.remove(low_id);
+    executor.remove(high_id);
+}
+
+TEST_F(TreeExecutorTest, Affinity)
+{
+    CountTicks* counter = addTree();
+    counter->running_ticks = 20;
+
+    TreeExecutor executor(TreeExecutorOptions(2));
+    TreeScheduleHints hints(std::chrono::milliseconds(1));
+    hints.worker = 1;
+    EXPECT_EQ(NodeStatus::SUCCESS, executor.wait(executor.add(trees[0].root_node, hints)));
+
+    // stolen at most when its worker is late
+    std::map<std::thread::id, int> ticks_per_thread;
+    for (auto id : counter->threads)
+    {
+        ticks_per_thread[id]++;
+    }
+    int max_ticks = 0;
+    for (const auto& it : ticks_per_thread)
+    {
+        max_ticks = std::max(max_ticks, it.second);
+    }
+    EXPECT_GE(max_ticks, 15);
+}
+
+TEST_F(TreeExecutorTest, DueTreesAreStolen)
+{
+    CountTicks* counter = addTree();
+    counter->running_ticks = 1000000;
+
+    std::atomic<bool> blocked(false);
+    std::atomic<bool> release(false);
+    factory.registerSimpleAction("Block", [&blocked, &release](TreeNode&) {
+        blocked = true;
+        while (!release)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return NodeStatus::SUCCESS;
+    });
+    auto block_tree = buildTreeFromText(factory, R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree"><Block/></BehaviorTree>
+</root>)");
+
+    // Both trees return to the first worker; when it is the one stuck in the long
+    // tick (any worker may pick the first tick), the other one must wake up when
+    // the tree is due.
+    for (int round = 0; round < 4; round++)
+    {
+        blocked = false;
+        release = false;
+        block_tree.root_node->setStatus(NodeStatus::IDLE);
+        TreeExecutor executor(TreeExecutorOptions(2));
+        TreeScheduleHints hints(std::chrono::milliseconds(5));
+        hints.worker = 0;
+        auto block_id = executor.add(block_tree.root_node, hints);
+        while (!blocked)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto id = executor.add(trees[0].root_node, hints);
+
+        const int ticks = counter->ticks;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_GE(counter->ticks - ticks, 3);
+
+        release = true;
+        EXPECT_EQ(NodeStatus::SUCCESS, executor.wait(block_id));
+        executor.remove(id);
+    }
+}
+
+TEST_F(TreeExecutorTest, Remove)
+{
+    CountTicks* counter = addTree();
+    counter->running_ticks = 1000000;
+
+    TreeExecutor executor(TreeExecutorOptions(2));
+    auto id = executor.add(trees[0].root_node, TreeScheduleHints(std::chrono::milliseconds(1)));
+    while (counter->ticks < 3)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(executor.remove(id));
+    EXPECT_FALSE(executor.remove(id));
+    EXPECT_EQ(0u, executor.size());
+
+    // halted, and never ticked again
+    EXPECT_EQ(1, counter->halts);
+    EXPECT_EQ(NodeStatus::IDLE, trees[0].root_node->status());
+    const int ticks = counter->ticks;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(ticks, counter->ticks);
+}
+
+TEST_F(TreeExecutorTest, AddRemoveStress)
+{
+    std::vector<CountTicks*> counters;
+    for (int i = 0; i < 8; i++)
+    {
+        counters.push_back(addTree());
+        counters.back()->running_ticks = 1000000;
+    }
+
+    TreeExecutor executor(TreeExecutorOptions(4));
+    const TreeScheduleHints hints(std::chrono::microseconds(0));
+    for (int round = 0; round < 200; round++)
+    {
+        std::vector<TreeExecutor::TreeID> ids;
+        for (const auto& tree : trees)
+        {
+            ids.push_back(executor.add(tree.root_node, hints));
+        }
+        if (round % 2 == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        for (auto id : ids)
+        {
+            EXPECT_TRUE(executor.remove(id));
+        }
+    }
+    EXPECT_EQ(0u, executor.size());
+
+    std::vector<int> ticks;
+    for (auto counter : counters)
+    {
+        EXPECT_EQ(0, counter->overlaps);
+        ticks.push_back(counter->ticks);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (size_t i = 0; i < counters.size(); i++)
+    {
+        EXPECT_EQ(ticks[i], counters[i]->ticks);
+    }
+}
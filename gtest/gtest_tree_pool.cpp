@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <future>
+#include "behaviortree_cpp/tree_pool.h"
+#include "behaviortree_cpp/blackboard/blackboard_local.h"
+
+using namespace BT;
+
+// clang-format off
+static const char* xml_text_pool = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <SequenceStar reset_on_failure="false">
+            <Action ID="Counter" />
+            <Condition ID="CheckFlag" />
+        </SequenceStar>
+    </BehaviorTree>
+</root>
+)";
+// clang-format on
+
+// A user decorator with memory: it ticks its child only in its first execution.
+class TickOnce : public DecoratorNode
+{
+  public:
+    TickOnce(const std::string& name) : DecoratorNode(name, {}), done_(false)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        if (done_)
+        {
+            return NodeStatus::SUCCESS;
+        }
+        done_ = true;
+        const NodeStatus child_status = child_node_->executeTick();
+        child_node_->setStatus(NodeStatus::IDLE);
+        return child_status;
+    }
+
+    void halt() override
+    {
+        done_ = false;
+        DecoratorNode::halt();
+    }
+
+  private:
+    bool done_;
+};
+
+class TreePoolTest : public testing::Test
+{
+  protected:
+    BehaviorTreeFactory factory;
+    int counter;
+
+    TreePoolTest() : counter(0)
+    {
+        factory.registerSimpleAction("Counter", [this](TreeNode&) {
+            counter++;
+            return NodeStatus::SUCCESS;
+        });
+        factory.registerSimpleCondition("CheckFlag", [](TreeNode& self) {
+            bool flag = false;
+            self.blackboard()->get("flag", flag);
+            return flag ? NodeStatus::SUCCESS : NodeStatus::FAILURE;
+        });
+    }
+};
+
+TEST_F(TreePoolTest, ReuseAndReset)
+{
+    TreePool pool(factory);
+    Tree* first_tree = nullptr;
+
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    blackboard->set("flag", false);
+    {
+        auto tree = pool.acquire(xml_text_pool, blackboard);
+        first_tree = tree.get();
+        ASSERT_EQ(tree->root_node->blackboard(), blackboard);
+        ASSERT_EQ(tree->root_node->executeTick(), NodeStatus::FAILURE);
+        ASSERT_EQ(counter, 1);
+        // SequenceStar remembers that the first child succeeded
+        ASSERT_EQ(tree->root_node->executeTick(), NodeStatus::FAILURE);
+        ASSERT_EQ(counter, 1);
+    }
+    ASSERT_EQ(pool.idleCount(), 1);
+
+    auto other_blackboard = Blackboard::create<BlackboardLocal>();
+    other_blackboard->set("flag", true);
+    {
+        auto tree = pool.acquire(xml_text_pool, other_blackboard);
+        ASSERT_EQ(tree.get(), first_tree);
+        ASSERT_EQ(pool.idleCount(), 0);
+        ASSERT_EQ(tree->root_node->status(), NodeStatus::IDLE);
+        ASSERT_EQ(tree->root_node->blackboard(), other_blackboard);
+
+        // the memory of SequenceStar was cleared
+        ASSERT_EQ(tree->root_node->executeTick(), NodeStatus::SUCCESS);
+        ASSERT_EQ(counter, 2);
+
+        // a second tree is needed while the first one is in use
+        auto tree_B = pool.acquire(xml_text_pool, other_blackboard);
+        ASSERT_NE(tree_B.get(), tree.get());
+        ASSERT_EQ(tree_B->nodes.size(), 3);
+    }
+    ASSERT_EQ(pool.idleCount(), 2);
+
+    pool.clear();
+    ASSERT_EQ(pool.idleCount(), 0);
+}
+
+TEST_F(TreePoolTest, ResetUserNodes)
+{
+    factory.registerNodeType<TickOnce>("TickOnce");
+    const std::string xml_text_once = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <TickOnce>
+            <Action ID="Counter" />
+        </TickOnce>
+    </BehaviorTree>
+</root>)";
+
+    TreePool pool(factory);
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    for (int i = 1; i <= 2; i++)
+    {
+        auto tree = pool.acquire(xml_text_once, blackboard);
+        ASSERT_EQ(tree->root_node->executeTick(), NodeStatus::SUCCESS);
+        ASSERT_EQ(tree->root_node->executeTick(), NodeStatus::SUCCESS);
+        // the recycled tree ticks the child again
+        ASSERT_EQ(counter, i);
+    }
+    ASSERT_EQ(pool.idleCount(), 1);
+}
+
+TEST_F(TreePoolTest, TreeOutlivesPool)
+{
+    std::shared_ptr<Tree> tree;
+    {
+        TreePool pool(factory);
+        tree = pool.acquire(xml_text_pool, Blackboard::create<BlackboardLocal>());
+    }
+    ASSERT_EQ(tree->nodes.size(), 3);
+    tree.reset();
+}
+
+TEST_F(TreePoolTest, ParseOutsideTheLock)
+{
+    // the first instantiation of "Blocking" waits until it is released
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> building;
+    std::atomic<bool> first(true);
+    NodeBuilder builder = [&](const std::string& name, const NodeParameters& params) {
+        if (first.exchange(false))
+        {
+            building.set_value();
+            released.wait();
+        }
+        return std::unique_ptr<TreeNode>(new SimpleActionNode(
+            name, [](TreeNode&) { return NodeStatus::SUCCESS; }, params));
+    };
+    factory.registerBuilder({NodeType::ACTION, "Blocking", NodeParameters()}, builder);
+
+    const std::string xml_text_blocking = R"(
+<root main_tree_to_execute = "MainTree" >
+    <BehaviorTree ID="MainTree">
+        <Action ID="Blocking" />
+    </BehaviorTree>
+</root>)";
+
+    TreePool pool(factory);
+    auto blackboard = Blackboard::create<BlackboardLocal>();
+    auto slow = std::async(std::launch::async, [&]() {
+        return pool.acquire(xml_text_blocking, blackboard);
+    });
+    building.get_future().wait();
+
+    // another XML is parsed while the first one is still being built
+    auto fast = std::async(std::launch::async, [&]() {
+        return pool.acquire(xml_text_pool, blackboard);
+    });
+    const auto ready = fast.wait_for(std::chrono::seconds(5));
+    release.set_value();
+    ASSERT_EQ(std::future_status::ready, ready);
+    ASSERT_EQ(fast.get()->nodes.size(), 3);
+    ASSERT_EQ(slow.get()->nodes.size(), 1);
+}
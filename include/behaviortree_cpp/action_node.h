@@ -119,6 +119,9 @@ class AsyncActionNode : public ActionNodeBase
 
     void stopAndJoinThread();
 
+    /// Handle of the thread of the node, to change its scheduling or its CPU affinity.
+    std::thread::native_handle_type threadHandle();
+
   protected:
 
     // The method that is going to be executed by the thread
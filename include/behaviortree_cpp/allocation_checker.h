@@ -0,0 +1,106 @@
+#ifndef BT_ALLOCATION_CHECKER_H
+#define BT_ALLOCATION_CHECKER_H
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+#include "behaviortree_cpp/tree_node.h"
+
+namespace BT
+{
+/**
+ * @brief AllocationChecker records the allocations done while the nodes of a tree
+ * are ticked, with the node being ticked and the call stack.
+ *
+ * After the first tick, the built-in nodes don't allocate: a tree ticked
+ * by a real-time loop can be checked with:
+ *
+ *     AllocationChecker checker(tree.root_node);
+ *     tree.root_node->executeTick();   // the first tick may allocate
+ *     checker.reset();
+ *     while( tree.root_node->executeTick() == NodeStatus::RUNNING ) { ... }
+ *     checker.dumpReport(std::cerr);
+ *
+ * Allocations are seen only if the global operator new is replaced by
+ * BT_ALLOCATION_CHECKER_HOOK, written in a single source file of the executable.
+ * Allocations are checked in the thread that ticks the tree, and in the threads
+ * of the AsyncActionNodes while they execute tick(); not in the loggers and
+ * in the TimeoutNode timer.
+ *
+ * It is a TickMonitor, attached next to the other ones of the nodes,
+ * and it must be destroyed before the tree.
+ */
+class AllocationChecker : public TickMonitor
+{
+  public:
+    static const int MAX_FRAMES = 16;
+
+    struct Allocation
+    {
+        /// the innermost node being ticked
+        const TreeNode* node;
+        size_t size;
+        void* frames[MAX_FRAMES];
+        int num_frames;
+    };
+
+    /// Only the first max_records allocations are recorded; all of them are counted.
+    explicit AllocationChecker(TreeNode* root_node, size_t max_records = 64);
+
+    ~AllocationChecker() override;
+
+    AllocationChecker(const AllocationChecker&) = delete;
+    AllocationChecker& operator=(const AllocationChecker&) = delete;
+
+    void onTickStart(const TreeNode& node, size_t slot) override;
+
+    void onTick(const TreeNode& node, size_t slot, MonitorTime start,
+                std::chrono::nanoseconds elapsed, NodeStatus status) override;
+
+    void onAsyncTick(const TreeNode& node, size_t slot, MonitorTime start,
+                     std::chrono::nanoseconds elapsed, NodeStatus status) override;
+
+    /// Number of allocations since the creation or the last reset().
+    uint64_t count() const;
+
+    /// The recorded allocations. Don't invoke it while the tree is ticked.
+    std::vector<Allocation> allocations() const;
+
+    void reset();
+
+    /// Print the node and the call stack of each recorded allocation.
+    void dumpReport(std::ostream& os) const;
+
+    /// Invoked by the operator new of BT_ALLOCATION_CHECKER_HOOK; it doesn't allocate.
+    static void notifyAllocation(size_t size) noexcept;
+
+  private:
+    void record(const TreeNode* node, size_t size) noexcept;
+
+    std::vector<TreeNode*> nodes_;
+    std::atomic<uint64_t> count_;
+    mutable std::mutex records_mutex_;
+    std::vector<Allocation> records_;
+};
+}
+
+/// Replacement of the global operator new that notifies the AllocationChecker.
+#define BT_ALLOCATION_CHECKER_HOOK                                                                 \
+    void* operator new(std::size_t size)                                                           \
+    {                                                                                              \
+        BT::AllocationChecker::notifyAllocation(size);                                             \
+        if (void* ptr = std::malloc(size != 0 ? size : 1))                                         \
+        {                                                                                          \
+            return ptr;                                                                            \
+        }                                                                                          \
+        throw std::bad_alloc();                                                                    \
+    }                                                                                              \
+    void operator delete(void* ptr) noexcept                                                       \
+    {                                                                                              \
+        std::free(ptr);                                                                            \
+    }
+
+#endif   // BT_ALLOCATION_CHECKER_H
@@ -102,6 +102,25 @@ NodeStatus convertFromString<NodeStatus>(const StringView& str);
 template <>  // Names with all capital letters
 NodeType convertFromString<NodeType>(const StringView& str);
 
+template <>  // FAIL_ON_ONE or FAIL_ON_ALL
+FailurePolicy convertFromString<FailurePolicy>(const StringView& str);
+
+template <>  // SUCCEED_ON_ONE or SUCCEED_ON_ALL
+SuccessPolicy convertFromString<SuccessPolicy>(const StringView& str);
+
+/// Same as destination = convertFromString<T>(str), but a string is copied
+/// into the buffer of destination.
+template <typename T> inline
+void convertFromString(const StringView& str, T& destination)
+{
+    destination = convertFromString<T>(str);
+}
+
+inline void convertFromString(const StringView& str, std::string& destination)
+{
+    destination.assign(str.data(), str.size());
+}
+
 
 //------------------------------------------------------------------
 
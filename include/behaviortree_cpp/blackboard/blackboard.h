@@ -1,13 +1,17 @@
 #ifndef BLACKBOARD_H
 #define BLACKBOARD_H
 
+#include <functional>
 #include <iostream>
 #include <string>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
 #include <unordered_map>
 
 #include "behaviortree_cpp/blackboard/safe_any.hpp"
+#include "behaviortree_cpp/signal.h"
 
 
 namespace BT
@@ -32,13 +36,15 @@ class BlackboardImpl
 class Blackboard
 {
     // This is intentionally private. Use Blackboard::create instead
-    Blackboard(std::unique_ptr<BlackboardImpl> base) : impl_(std::move(base))
+    Blackboard(std::unique_ptr<BlackboardImpl> base) : impl_(std::move(base)), thread_safe_(false)
     {
     }
 
   public:
     typedef std::shared_ptr<Blackboard> Ptr;
 
+    using WriteSignal = Signal<const std::string&, const SafeAny::Any&>;
+
     Blackboard() = delete;
 
     /** Use this static method to create an instance of the BlackBoard
@@ -65,16 +71,20 @@ class Blackboard
         {
             return false;
         }
+        auto lock = lockIfThreadSafe();
         const SafeAny::Any* val = impl_->get(key);
         if (!val)
         {
             return false;
         }
 
-        value = val->cast<T>();
+        val->copyTo(value);
         return true;
     }
 
+    /** The pointer is valid until the next set() of the same key.
+     *  If the blackboard is thread safe, read it while holding lockIfThreadSafe().
+     */
     const SafeAny::Any* getAny(const std::string& key) const
     {
         if (!impl_)
@@ -101,19 +111,67 @@ class Blackboard
     template <typename T>
     void set(const std::string& key, const T& value)
     {
-        if (impl_)
+        if (!impl_)
         {
+            return;
+        }
+        if (!write_signal_.hasSubscribers())
+        {
+            auto lock = lockIfThreadSafe();
             impl_->set(key, SafeAny::Any(value));
+            return;
         }
+        // the subscribers receive their own copy, not the stored value,
+        // which another thread may overwrite when the lock is released
+        SafeAny::Any any_value(value);
+        {
+            auto lock = lockIfThreadSafe();
+            impl_->set(key, any_value);
+        }
+        write_signal_.notify(key, any_value);
+    }
+
+    /** The callback is invoked after each set(), by the thread that invokes it.
+     *  It is active until the returned Subscriber is destroyed.
+     *  Don't subscribe while other threads write into the blackboard.
+     */
+    WriteSignal::Subscriber subscribeToWrites(WriteSignal::CallableFunction callback)
+    {
+        return write_signal_.subscribe(std::move(callback));
     }
 
     bool contains(const std::string& key) const
     {
+        auto lock = lockIfThreadSafe();
         return (impl_ && impl_->contains(key));
     }
 
+    /** Serialize get(), set() and contains() with a mutex, for the trees that tick
+     *  nodes in more than one thread (see ParallelNode::setConcurrent()).
+     *  Enable it before those threads access the blackboard.
+     */
+    void setThreadSafe(bool thread_safe)
+    {
+        thread_safe_ = thread_safe;
+    }
+
+    bool isThreadSafe() const
+    {
+        return thread_safe_;
+    }
+
+    /// Locked only if the blackboard is thread safe.
+    std::unique_lock<std::mutex> lockIfThreadSafe() const
+    {
+        return thread_safe_ ? std::unique_lock<std::mutex>(mutex_) :
+                              std::unique_lock<std::mutex>(mutex_, std::defer_lock);
+    }
+
   private:
     std::unique_ptr<BlackboardImpl> impl_;
+    WriteSignal write_signal_;
+    mutable std::mutex mutex_;
+    std::atomic<bool> thread_safe_;
 };
 }
 
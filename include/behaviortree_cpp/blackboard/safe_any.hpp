@@ -90,6 +90,19 @@ class Any
         }
     }
 
+    /// Same as destination = cast<T>(), but a string is copied into the buffer of destination.
+    template <typename T>
+    void copyTo(T& destination) const
+    {
+        destination = cast<T>();
+    }
+
+    /// The string stored, without copies, or nullptr if the value is not a string.
+    const SimpleString* asSimpleString() const noexcept
+    {
+        return linb::any_cast<SimpleString>(&_any);
+    }
+
     const std::type_info& type() const noexcept
     {
         return _any.type();
@@ -107,7 +120,7 @@ class Any
 
         if (type == typeid(SimpleString))
         {
-            return linb::any_cast<SimpleString>(_any).toStdString();
+            return linb::any_cast<const SimpleString&>(_any).toStdString();
         }
         else if (type == typeid(int64_t))
         {
@@ -190,6 +203,19 @@ class Any
     }
 };
 
+template <>
+inline void Any::copyTo<std::string>(std::string& destination) const
+{
+    if (const SimpleString* str = asSimpleString())
+    {
+        destination.assign(str->data(), str->size());
+    }
+    else
+    {
+        destination = cast<std::string>();
+    }
+}
+
 }   // end namespace VarNumber
 
 #endif   // VARNUMBER_H
@@ -18,6 +18,8 @@
 #include <memory>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <mutex>
 #include <cstring>
 #include <algorithm>
 
@@ -25,10 +27,6 @@
 
 namespace BT
 {
-/// The term "Builder" refers to the Builder Pattern (https://en.wikipedia.org/wiki/Builder_pattern)
-typedef std::function<std::unique_ptr<TreeNode>(const std::string&, const NodeParameters&)>
-    NodeBuilder;
-
 /// This information is used mostly by the XMLParser.
 struct TreeNodeManifest
 {
@@ -37,6 +35,13 @@ struct TreeNodeManifest
     NodeParameters required_parameters;
 };
 
+/// Manifests of all the TreeNodes registered by a single plugin.
+struct PluginManifest
+{
+    std::string path;
+    std::vector<TreeNodeManifest> manifests;
+};
+
 const char PLUGIN_SYMBOL[] = "BT_RegisterNodesFromPlugin";
 #define BT_REGISTER_NODES(factory)                                                                 \
     extern "C" void __attribute__((visibility("default")))                                         \
@@ -75,6 +80,31 @@ class BehaviorTreeFactory
      */
     void registerFromPlugin(const std::string file_path);
 
+    /**
+     * @brief registerDeferredPlugin declares the TreeNodes provided by a plugin,
+     * without loading the shared library. Their manifests are visible immediately,
+     * but the library is loaded only when a tree that uses one of them is instantiated.
+     *
+     * Manifests are usually read from a cache (see registerFromManifestCache).
+     */
+    void registerDeferredPlugin(const PluginManifest& plugin);
+
+    /**
+     * @brief loadPluginsFor loads the deferred plugins which provide any of these IDs.
+     * The libraries are opened in parallel, then registered one at a time.
+     *
+     * It is const because it doesn't change the list of TreeNodes advertised by manifests().
+     * The plugins register into a temporary factory; their builders are then moved
+     * here under the lock of this factory, also taken by instantiateTreeNode(), hence
+     * a const factory can be shared between threads.
+     *
+     * This method may throw.
+     */
+    void loadPluginsFor(const std::set<std::string>& IDs) const;
+
+    /// True if at least one deferred plugin hasn't been loaded yet.
+    bool hasDeferredPlugins() const;
+
     /**
      * @brief instantiateTreeNode creates a TreeNode
      *
@@ -131,19 +161,39 @@ class BehaviorTreeFactory
         registerNodeTypeImpl<T>(ID);
     }
 
-    /// All the builders. Made available mostly for debug purposes.
-    const std::map<std::string, NodeBuilder>& builders() const;
+    /** All the builders. Made available mostly for debug purposes.
+     *
+     * The address of a NodeBuilder doesn't change when other builders are registered;
+     * it is valid until its ID is unregistered or the factory is destroyed.
+     * The map itself isn't protected: don't iterate it while deferred plugins may be loaded.
+     */
+    const std::unordered_map<std::string, NodeBuilder>& builders() const;
 
-    /// Manifests of all the registered TreeNodes.
-    const std::vector<TreeNodeManifest>& manifests() const;
+    /// Manifests of all the registered TreeNodes, sorted by type and ID.
+    /// A copy: deferred plugins may be loaded by other threads meanwhile.
+    std::vector<TreeNodeManifest> manifests() const;
 
     const  std::set<std::string>& builtinNodes() const;
 
   private:
-    std::map<std::string, NodeBuilder> builders_;
-    std::vector<TreeNodeManifest> manifests_;
+    // Deferred plugins and the lazy sorting of the manifests modify a const factory,
+    // that may be shared between threads: builders_, manifests_, manifests_sorted_
+    // and deferred_IDs_ are accessed holding mutex_.
+    mutable std::mutex mutex_;
+
+    mutable std::unordered_map<std::string, NodeBuilder> builders_;
     std::set<std::string> builtin_IDs_;
 
+    // sorted only when manifests() is called
+    mutable std::vector<TreeNodeManifest> manifests_;
+    mutable bool manifests_sorted_;
+
+    // registration_ID -> path of the plugin that will register it
+    mutable std::unordered_map<std::string, std::string> deferred_IDs_;
+
+    // registerBuilder(), with mutex_ held
+    void registerBuilderLocked(const TreeNodeManifest& manifest, NodeBuilder builder) const;
+
     // template specialization = SFINAE + black magic
 
     // clang-format off
@@ -182,10 +232,11 @@ class BehaviorTreeFactory
     template <typename T>
     NodeBuilder getBuilderImpl(typename std::enable_if<has_default_constructor<T>::value && has_params_constructor<T>::value >::type* = nullptr)
     {
-        return [this](const std::string& name, const NodeParameters& params)
+        const bool has_required_params = !getRequiredParamsImpl<T>().empty();
+        return [has_required_params](const std::string& name, const NodeParameters& params)
         {
             // Special case. Use default constructor if parameters are empty
-            if( params.empty() && has_default_constructor<T>::value && getRequiredParamsImpl<T>().size()>0)
+            if( params.empty() && has_required_params )
             {
                 return std::unique_ptr<TreeNode>(new T(name));
             }
@@ -215,7 +266,7 @@ class BehaviorTreeFactory
     }
     // clang-format on
 
-    void sortTreeNodeManifests();
+    void sortTreeNodeManifests() const;
 
 };
 
@@ -14,10 +14,37 @@
 #ifndef PARALLEL_NODE_H
 #define PARALLEL_NODE_H
 
+#include <exception>
+#include <thread>
+#include <vector>
 #include "behaviortree_cpp/control_node.h"
 
 namespace BT
 {
+/**
+ * @brief ParallelNode ticks all its children; it returns SUCCESS when (threshold)
+ * of them succeed, FAILURE when that is no longer possible.
+ *
+ * By default, the children are ticked one after the other in the thread that ticks
+ * the tree. With concurrent="true" (or setConcurrent()), they are ticked at the same
+ * time by a pool of threads shared by all the concurrent ParallelNodes, the first
+ * one by the calling thread; executeTick() returns when all of them have returned,
+ * so the latency is close to the one of the slowest child rather than their sum.
+ * All the children are ticked, even if the result is decided by the first ones.
+ *
+ * Contract of the concurrent mode:
+ *  - everything a child did during its tick, blackboard writes included, happens
+ *    before the return of executeTick() of the ParallelNode, and everything done
+ *    before that call happens before the tick of the children;
+ *  - the children run concurrently with each other: if they share a blackboard,
+ *    it must be thread safe (see Blackboard::setThreadSafe(), enabled as soon as
+ *    the node is concurrent and has a blackboard, before any tick), and they must
+ *    not share other mutable state;
+ *  - the status changes of the children are notified to the loggers from the
+ *    threads of the pool, as it already happens for the AsyncActionNodes; there
+ *    tickThreadId() is the thread that ticked the ParallelNode;
+ *  - an exception thrown by a child is rethrown by executeTick().
+ */
 class ParallelNode : public ControlNode
 {
   public:
@@ -28,7 +55,7 @@ class ParallelNode : public ControlNode
 
     static const NodeParameters& requiredNodeParameters()
     {
-        static NodeParameters params = {{THRESHOLD_KEY, "1"}};
+        static NodeParameters params = {{THRESHOLD_KEY, "1"}, {CONCURRENT_KEY, "false"}};
         return params;
     }
 
@@ -39,15 +66,45 @@ class ParallelNode : public ControlNode
     unsigned int thresholdM();
     void setThresholdM(unsigned int threshold_M);
 
+    bool isConcurrent() const;
+
+    /// With true, the blackboard (current and future) is made thread safe immediately.
+    void setConcurrent(bool concurrent);
+
+    virtual void setBlackboard(const Blackboard::Ptr& bb) override;
+
+    /// The thread ticking the tree: the calling one, or the one that ticked the
+    /// concurrent ParallelNode while the pool ticks its children.
+    static std::thread::id tickThreadId();
+
+    /// A child ticked by the pool of the concurrent ParallelNodes.
+    struct ChildTask
+    {
+        TreeNode* child;
+        NodeStatus status;
+        std::exception_ptr error;
+        unsigned* remaining;
+        std::thread::id tick_thread;
+    };
+
   private:
     unsigned int threshold_;
     unsigned int success_childred_num_;
     unsigned int failure_childred_num_;
 
     bool read_parameter_from_blackboard_;
+    bool concurrent_;
+    // the one given to setBlackboard(), readable before the node is initialized
+    Blackboard::Ptr concurrent_blackboard_;
+    std::vector<ChildTask> tasks_;
     static constexpr const char* THRESHOLD_KEY = "threshold";
+    static constexpr const char* CONCURRENT_KEY = "concurrent";
 
     virtual BT::NodeStatus tick() override;
+
+    void tickConcurrently();
+
+    void makeBlackboardThreadSafe();
 };
 }
 #endif   // PARALLEL_NODE_H
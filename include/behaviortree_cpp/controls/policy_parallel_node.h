@@ -0,0 +1,92 @@
+/*  Copyright (C) 2018-2019 Davide Faconti -  All Rights Reserved
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+*   to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*   and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef POLICY_PARALLEL_NODE_H
+#define POLICY_PARALLEL_NODE_H
+
+#include <vector>
+#include "behaviortree_cpp/control_node.h"
+
+namespace BT
+{
+/**
+ * @brief The PolicyParallelNode ticks all its children, but, unlike ParallelNode,
+ * a child that returned SUCCESS or FAILURE is not ticked again until this node
+ * completes or is halted: only the children that are RUNNING or not yet
+ * started are ticked.
+ *
+ * - SUCCESS when the SuccessPolicy is met: one child succeeded (SUCCEED_ON_ONE)
+ *   or all of them (SUCCEED_ON_ALL).
+ *
+ * - FAILURE when the FailurePolicy is met: one child failed (FAIL_ON_ONE) or
+ *   all of them (FAIL_ON_ALL); or when all the children completed and the
+ *   SuccessPolicy is not met.
+ *
+ * - RUNNING otherwise.
+ *
+ * The policies are checked after each child, in order; when one is met, the
+ * children still RUNNING are halted.
+ * The outcome of each child is available with childStatus() until the next
+ * execution of this node starts.
+ */
+class PolicyParallelNode : public ControlNode
+{
+  public:
+    PolicyParallelNode(const std::string& name, SuccessPolicy success_policy = SUCCEED_ON_ALL,
+                       FailurePolicy failure_policy = FAIL_ON_ONE);
+
+    PolicyParallelNode(const std::string& name, const NodeParameters& params);
+
+    virtual ~PolicyParallelNode() override = default;
+
+    static const NodeParameters& requiredNodeParameters()
+    {
+        static NodeParameters params = {{SUCCESS_POLICY_KEY, "SUCCEED_ON_ALL"},
+                                        {FAILURE_POLICY_KEY, "FAIL_ON_ONE"}};
+        return params;
+    }
+
+    SuccessPolicy successPolicy() const;
+    FailurePolicy failurePolicy() const;
+
+    /// SUCCESS or FAILURE if the child completed in the current (or last)
+    /// execution, otherwise its status: RUNNING, or IDLE if not ticked yet.
+    NodeStatus childStatus(size_t index) const;
+
+    /// Number of children that completed in the current (or last) execution.
+    unsigned completedCount() const;
+
+  private:
+    SuccessPolicy success_policy_;
+    FailurePolicy failure_policy_;
+    bool read_parameter_from_blackboard_;
+
+    // one bit for each child
+    std::vector<bool> completed_;
+    std::vector<bool> succeeded_;
+    unsigned success_count_;
+    unsigned failure_count_;
+
+    static constexpr const char* SUCCESS_POLICY_KEY = "success_policy";
+    static constexpr const char* FAILURE_POLICY_KEY = "failure_policy";
+
+    virtual BT::NodeStatus tick() override;
+
+    void readPolicies();
+
+    void resetCompletion();
+
+    NodeStatus complete(NodeStatus status);
+};
+}
+
+#endif   // POLICY_PARALLEL_NODE_H
@@ -42,6 +42,11 @@ class BlackboardPreconditionNode : public DecoratorNode
 
   private:
     virtual BT::NodeStatus tick() override;
+
+    // members, to reuse the memory of the strings at each tick
+    std::string key_;
+    T expected_value_;
+    T current_value_;
 };
 
 //----------------------------------------------------
@@ -49,15 +54,11 @@ class BlackboardPreconditionNode : public DecoratorNode
 template<typename T> inline
 NodeStatus BlackboardPreconditionNode<T>::tick()
 {
-    std::string key;
-    T expected_value;
-    T current_value;
-
-    getParam("key", key);
+    getParam("key", key_);
     setStatus(NodeStatus::RUNNING);
 
     // check if the key is present in the blackboard
-    if ( !blackboard() ||  !(blackboard()->contains(key)) )
+    if ( !blackboard() ||  !(blackboard()->contains(key_)) )
     {
         return NodeStatus::FAILURE;
     }
@@ -67,9 +68,9 @@ NodeStatus BlackboardPreconditionNode<T>::tick()
         return child_node_->executeTick();
     }
 
-    bool same = ( getParam("expected", expected_value) &&
-                  blackboard()->get(key, current_value) &&
-                  current_value == expected_value ) ;
+    bool same = ( getParam("expected", expected_value_) &&
+                  blackboard()->get(key_, current_value_) &&
+                  current_value_ == expected_value_ ) ;
     if(same)
     {
         return child_node_->executeTick();
@@ -12,6 +12,8 @@ class DecoratorSubtreeNode : public DecoratorNode
 
     virtual ~DecoratorSubtreeNode() override = default;
 
+    virtual std::unique_ptr<TreeNode> clone() const override;
+
   private:
     virtual BT::NodeStatus tick() override;
 
@@ -4,6 +4,7 @@
 #include "behaviortree_cpp/decorator_node.h"
 #include <atomic>
 #include "timer_queue.h"
+#include "behaviortree_cpp/signal.h"
 
 namespace BT
 {
@@ -20,6 +21,14 @@ class TimeoutNode : public DecoratorNode
         return params;
     }
 
+    using ExpirySignal = Signal<const TreeNode&>;
+
+    /// The callback is invoked by the thread of the timer, after the child was halted.
+    ExpirySignal::Subscriber subscribeToExpiry(ExpirySignal::CallableFunction callback)
+    {
+        return expiry_signal_.subscribe(std::move(callback));
+    }
+
   private:
     static TimerQueue& timer()
     {
@@ -34,6 +43,8 @@ class TimeoutNode : public DecoratorNode
 
     unsigned msec_;
     bool read_parameter_from_blackboard_;
+
+    ExpirySignal expiry_signal_;
 };
 }
 
@@ -4,6 +4,8 @@
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <algorithm>
+#include <functional>
 #include <queue>
 #include <chrono>
 #include <assert.h>
@@ -67,6 +69,8 @@ class TimerQueue
   public:
     TimerQueue()
     {
+        // add() and cancel() allocate only if more timers are pending
+        m_items.getContainer().reserve(256);
         m_th = std::thread([this] { run(); });
     }
 
@@ -106,28 +110,20 @@ class TimerQueue
     // start with)
     size_t cancel(uint64_t id)
     {
-        // Instead of removing the item from the container (thus breaking the
-        // heap integrity), we set the item as having no handler, and put
-        // that handler on a new item at the top for immediate execution
-        // The timer thread will then ignore the original item, since it has no
-        // handler.
+        // The item is moved to the top of the heap, for immediate execution, by
+        // setting its time to zero; the handler is invoked with aborted == true.
+        // Nothing is added to the container, which doesn't grow when timers are
+        // added and cancelled at each tick.
         std::unique_lock<std::mutex> lk(m_mtx);
-        for (auto&& item : m_items.getContainer())
+        auto& items = m_items.getContainer();
+        for (size_t i = 0; i < items.size(); i++)
         {
-            if (item.id == id && item.handler)
+            if (items[i].id == id && items[i].handler)
             {
-                WorkItem newItem;
-                // Zero time, so it stays at the top for immediate execution
-                newItem.end = Clock::time_point();
-                newItem.id = 0;   // Means it is a canceled item
-                // Move the handler from item to newitem.
-                // Also, we need to manually set the handler to nullptr, since
-                // the standard does not guarantee moving an std::function will
-                // empty it. Some STL implementation will empty it, others will
-                // not.
-                newItem.handler = std::move(item.handler);
-                item.handler = nullptr;
-                m_items.push(std::move(newItem));
+                items[i].end = Clock::time_point();
+                items[i].id = 0;   // Means it is a canceled item
+                // a prefix of a heap is a heap: the item is sifted up
+                std::push_heap(items.begin(), items.begin() + i + 1, std::greater<WorkItem>());
 
                 lk.unlock();
                 // Something changed, so wake up timer thread
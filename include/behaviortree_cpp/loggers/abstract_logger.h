@@ -1,6 +1,7 @@
 #ifndef ABSTRACT_LOGGER_H
 #define ABSTRACT_LOGGER_H
 
+#include <array>
 #include "behaviortree_cpp/behavior_tree.h"
 
 namespace BT
@@ -14,12 +14,12 @@ namespace BT
  * @param root_node
  * @return Important: the returned shared_ptr must not go out of scope,
  *         otherwise the logger is removed.
+ *
+ * Many instances can be created, one for each tree; lines are never interleaved.
  */
 
 class StdCoutLogger : public StatusChangeLogger
 {
-    static std::atomic<bool> ref_count;
-
   public:
     StdCoutLogger(TreeNode* root_node);
     ~StdCoutLogger();
@@ -1,33 +1,148 @@
 #ifndef BT_FILE_LOGGER_H
 #define BT_FILE_LOGGER_H
 
+#include <atomic>
 #include <fstream>
 #include <deque>
 #include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "abstract_logger.h"
+#include "bt_log_codec.h"
 
 namespace BT
 {
+enum class FileLogFormat
+{
+    V1,   // fixed size transitions
+    V2    // compressed blocks, see bt_log_codec.h
+};
+
+struct FileLoggerOptions
+{
+    explicit FileLoggerOptions(size_t buffer_size = 10)
+      : buffer_size(buffer_size),
+        async(false),
+        write_period(std::chrono::milliseconds(100)),
+        async_capacity(16384),
+        max_file_size(0),
+        max_file_age(0),
+        max_files(0),
+        format(FileLogFormat::V1),
+        compress(true),
+        block_size(4096)
+    {
+    }
+
+    /// Number of transitions stored in memory before writing them.
+    size_t buffer_size;
+
+    /// If true, the file is written by a background thread and callback() never waits for the disk.
+    bool async;
+
+    /// When async is true, transitions are written at least this often.
+    std::chrono::milliseconds write_period;
+
+    /** When async is true, maximum number of transitions waiting for the background
+     * thread; the memory is allocated by the constructor. When the disk can't keep up,
+     * the transitions that don't fit are dropped (see FileLogger::droppedTransitions()).
+     */
+    size_t async_capacity;
+
+    /// Rotate when the file is bigger than this (bytes). 0 means unlimited.
+    size_t max_file_size;
+
+    /// Rotate when the file is older than this. 0 means unlimited.
+    std::chrono::seconds max_file_age;
+
+    /** Number of rotated files to keep. If filename is "trace.fbl", they are called
+     * "trace.1.fbl" (most recent) to "trace.N.fbl". Older ones are deleted.
+     * Each file contains the tree and can be opened independently.
+     *
+     * It must be at least 1 when max_file_size or max_file_age is set: the
+     * constructor of FileLogger throws std::invalid_argument otherwise, since
+     * each rotation would discard the whole log.
+     */
+    size_t max_files;
+
+    FileLogFormat format;
+
+    /// V2 only: compress the blocks.
+    bool compress;
+
+    /// V2 only: maximum number of transitions in a block. Blocks never span two files.
+    size_t block_size;
+};
+
 class FileLogger : public StatusChangeLogger
 {
   public:
-    FileLogger(TreeNode* root_node, const char* filename, uint16_t buffer_size = 10);
+    FileLogger(TreeNode* root_node, const char* filename, size_t buffer_size = 10);
+
+    FileLogger(TreeNode* root_node, const char* filename, const FileLoggerOptions& options);
 
     virtual ~FileLogger() override;
 
     virtual void callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
                           NodeStatus status) override;
 
+    /** In async mode, blocks until the transitions received so far are written.
+     * With FileLogFormat::V2, the current block is written even if not full.
+     */
     virtual void flush() override;
 
+    /// Number of transitions lost because async_capacity was exceeded.
+    size_t droppedTransitions() const
+    {
+        return dropped_;
+    }
+
   private:
+    const std::string filename_;
+
+    const FileLoggerOptions options_;
+
     std::ofstream file_os_;
 
-    std::chrono::high_resolution_clock::time_point start_time;
+    // flatbuffer of the tree, written at the beginning of each file
+    std::vector<char> header_;
+
+    LogBlockEncoder encoder_;
+    std::vector<uint8_t> block_;
+
+    size_t file_size_;
+
+    std::chrono::steady_clock::time_point file_open_time_;
 
     std::vector<SerializedTransition> buffer_;
 
-    bool buffer_max_size_;
+    // async mode. Transitions are swapped from buffer_ to write_buffer_; both have
+    // capacity async_capacity, and are never reallocated
+    std::vector<SerializedTransition> write_buffer_;
+    size_t async_capacity_;
+    std::atomic<size_t> dropped_;
+    std::mutex buffer_mutex_;
+    std::condition_variable buffer_cv_;
+    std::condition_variable flushed_cv_;
+    std::thread writer_thread_;
+    bool stop_writer_;
+    uint64_t flush_requested_;
+    uint64_t flush_done_;
+
+    void openFile();
+
+    void rotate();
+
+    std::string rotatedFilename(size_t index) const;
+
+    void writeTransitions(const SerializedTransition* transitions, size_t count);
+
+    void writeBlock();
+
+    void writerLoop();
+
+    size_t writeThreshold() const;
 };
 
 }   // end namespace
@@ -0,0 +1,163 @@
+#ifndef BT_FLIGHT_RECORDER_H
+#define BT_FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "abstract_logger.h"
+#include "bt_log_codec.h"
+
+namespace BT
+{
+struct FlightRecorderOptions
+{
+    explicit FlightRecorderOptions(const std::string& filename = "bt_flight_recorder.fbl")
+      : filename(filename),
+        capacity(8192),
+        dump_on_failure(true),
+        dump_on_signal(false),
+        blackboard_capacity(1024)
+    {
+    }
+
+    /// File written by the automatic dumps; it is overwritten each time.
+    std::string filename;
+
+    /// Number of transitions kept in memory (rounded up to a power of two).
+    size_t capacity;
+
+    /// Dump when the root node returns FAILURE.
+    bool dump_on_failure;
+
+    /// Dump when the process receives SIGSEGV, SIGABRT, SIGBUS, SIGFPE or SIGILL.
+    bool dump_on_signal;
+
+    /** If set, its writes are recorded too and dumped into "<filename>.blackboard".
+     * Only the first 23 characters of the keys and 31 of the strings are kept; numbers
+     * are formatted when dumped, the other types are written as "<type name>".
+     * Like Blackboard::subscribeToWrites(), the recorder must be created and
+     * destroyed while no other thread writes into the blackboard.
+     */
+    Blackboard::Ptr blackboard;
+
+    /// Number of blackboard writes kept in memory (rounded up to a power of two).
+    size_t blackboard_capacity;
+};
+
+/// A write into the blackboard, see FlightRecorder::blackboardWrites().
+struct BlackboardWrite
+{
+    uint64_t timestamp_usec;
+    std::string key;
+    std::string value;
+};
+
+/**
+ * @brief FlightRecorder keeps the most recent transitions of a tree in a
+ * fixed-size ring buffer, and writes them to a file only when something goes wrong:
+ * when the root returns FAILURE, when an exception escapes tick(), on a fatal
+ * signal, or on demand with dump().
+ *
+ * The file has the same format as FileLogger (FileLogFormat::V1) and can be read with
+ * bt_log_cat, LogReader or Groot.
+ *
+ * Recording a transition is lock free: an atomic increment and four stores.
+ * Transitions can be recorded by many threads; a dump never blocks them.
+ */
+class FlightRecorder : public StatusChangeLogger
+{
+  public:
+    FlightRecorder(TreeNode* root_node,
+                   const FlightRecorderOptions& options = FlightRecorderOptions());
+
+    ~FlightRecorder() override;
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    void callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
+                  NodeStatus status) override;
+
+    /// Same as dump(options.filename).
+    void flush() override;
+
+    /// Write the recorded transitions (and blackboard writes) into a file.
+    void dump(const std::string& filename);
+
+    /// Tick the root node; dump and rethrow if an exception escapes it.
+    NodeStatus tick();
+
+    /// The recorded transitions, oldest first.
+    std::vector<LogTransition> transitions() const;
+
+    /// The recorded blackboard writes, oldest first.
+    std::vector<BlackboardWrite> blackboardWrites() const;
+
+    /// Number of dumps written so far.
+    size_t dumpCount() const
+    {
+        return dump_count_.load();
+    }
+
+  private:
+    static const size_t KEY_WORDS = 3;
+    static const size_t VALUE_WORDS = 4;
+
+    // sequence is 2*index+1 while the record is written, 2*index+2 when it is complete
+    struct TransitionRecord
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> timestamp_usec;
+        std::atomic<uint32_t> data;   // uid, previous status, status
+    };
+
+    // the value is stored raw, and formatted only when it is read: a number, the
+    // characters of a string, or the std::type_info of the other types
+    struct BlackboardRecord
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> timestamp_usec;
+        std::atomic<uint64_t> key[KEY_WORDS];
+        std::atomic<uint64_t> value_type;
+        std::atomic<uint64_t> value[VALUE_WORDS];
+    };
+
+    void recordBlackboardWrite(const std::string& key, const SafeAny::Any& value);
+
+    // The following methods are async-signal-safe: no allocation and no lock.
+
+    bool readTransition(uint64_t index, uint64_t& timestamp_usec, uint32_t& data) const;
+
+    // key and value have size KEY_WORDS*8 and VALUE_WORDS*8. The names of the other
+    // types are demangled only if demangle_types, since it allocates.
+    bool readBlackboardWrite(uint64_t index, uint64_t& timestamp_usec, char* key, char* value,
+                             bool demangle_types) const;
+
+    void writeDump(int fd, int blackboard_fd, bool demangle_types) const;
+
+    static void signalHandler(int signal);
+
+    static void installSignalHandlers(FlightRecorder* recorder);
+
+    static void removeSignalHandlers(FlightRecorder* recorder);
+
+    TreeNode* root_node_;
+    FlightRecorderOptions options_;
+    std::string blackboard_filename_;
+    std::vector<uint8_t> header_;
+
+    std::unique_ptr<TransitionRecord[]> transitions_;
+    size_t transitions_mask_;
+    std::atomic<uint64_t> transitions_head_;
+
+    std::unique_ptr<BlackboardRecord[]> blackboard_;
+    size_t blackboard_mask_;
+    std::atomic<uint64_t> blackboard_head_;
+    Blackboard::WriteSignal::Subscriber blackboard_subscriber_;
+
+    std::mutex dump_mutex_;
+    std::atomic<size_t> dump_count_;
+};
+}
+
+#endif   // BT_FLIGHT_RECORDER_H
@@ -0,0 +1,117 @@
+#ifndef BT_LOG_CODEC_H
+#define BT_LOG_CODEC_H
+
+#include <cstdint>
+#include <vector>
+#include "abstract_logger.h"
+
+/**
+ * Log files (*.fbl) come in two formats. Both start with the tree serialized
+ * with flatbuffers, preceded by its size (uint32).
+ *
+ * V1 (no magic number): a sequence of 12 bytes transitions
+ *     [sec: uint32][usec: uint32][uid: uint16][prev_status: int8][status: int8]
+ *
+ * V2: the file starts with the magic number "BTL2"; after the tree,
+ * transitions are grouped in blocks. Each block has a fixed size header (LogBlockHeader)
+ * followed by its payload. For each transition the payload contains:
+ *
+ *     [timestamp delta from the previous transition, usec: zigzag varint]
+ *     [uid: varint]
+ *     [prev_status << 4 | status: uint8]
+ *
+ * The delta of the first transition of a block is relative to first_timestamp_usec.
+ * The payload may be compressed with a simple LZ77 (see CompressLZ).
+ *
+ * All integers are little endian.
+ */
+
+namespace BT
+{
+const char LOG_V2_MAGIC[4] = {'B', 'T', 'L', '2'};
+
+struct LogTransition
+{
+    uint64_t timestamp_usec;
+    uint16_t uid;
+    NodeStatus prev_status;
+    NodeStatus status;
+};
+
+/// Read a 12 bytes transition of the V1 format.
+LogTransition DeserializeTransition(const uint8_t* buffer);
+
+struct LogBlockHeader
+{
+    static const size_t SIZE = 32;
+    static const uint32_t COMPRESSED = 1;
+
+    uint32_t payload_size;   // bytes after the header
+    uint32_t raw_size;       // bytes of the payload once decompressed
+    uint32_t count;          // number of transitions
+    uint32_t flags;
+    uint64_t first_timestamp_usec;
+    uint64_t last_timestamp_usec;
+};
+
+/// Return false if size is smaller than LogBlockHeader::SIZE.
+bool ReadLogBlockHeader(const uint8_t* data, size_t size, LogBlockHeader& header);
+
+/**
+ * @brief DecodeLogBlock appends the transitions of a block to the vector.
+ *
+ * @param payload      the bytes following the header (header.payload_size).
+ * @param scratch      buffer used for decompression, to reuse memory between calls.
+ *
+ * Throws std::runtime_error if the block is corrupted.
+ */
+void DecodeLogBlock(const LogBlockHeader& header, const uint8_t* payload,
+                    std::vector<LogTransition>& transitions, std::vector<uint8_t>& scratch);
+
+/**
+ * @brief LogBlockEncoder builds the blocks of the V2 format.
+ * Only integer arithmetic is done in push(); compression happens in finish().
+ */
+class LogBlockEncoder
+{
+  public:
+    LogBlockEncoder(bool compress);
+
+    void push(const LogTransition& transition);
+
+    /// Number of transitions in the current block.
+    size_t count() const
+    {
+        return count_;
+    }
+
+    /// Append the current block (header and payload) to output and start a new one.
+    void finish(std::vector<uint8_t>& output);
+
+  private:
+    bool compress_;
+    std::vector<uint8_t> raw_;
+    std::vector<uint8_t> compressed_;
+    std::vector<int32_t> hash_table_;
+    uint32_t count_;
+    uint64_t first_timestamp_;
+    uint64_t last_timestamp_;
+};
+
+/**
+ * Byte oriented LZ77. The output is a sequence of:
+ *
+ *     [literals count: varint][literals][match length: varint][match offset: varint]
+ *
+ * terminated by a literal run that reaches the size of the uncompressed data.
+ *
+ * @param hash_table   reused between calls to avoid allocations.
+ */
+void CompressLZ(const uint8_t* input, size_t size, std::vector<uint8_t>& output,
+                std::vector<int32_t>& hash_table);
+
+/// Return false if the input is corrupted or doesn't decompress to exactly output_size bytes.
+bool DecompressLZ(const uint8_t* input, size_t size, uint8_t* output, size_t output_size);
+}
+
+#endif   // BT_LOG_CODEC_H
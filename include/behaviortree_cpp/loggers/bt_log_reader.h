@@ -0,0 +1,148 @@
+#ifndef BT_LOG_READER_H
+#define BT_LOG_READER_H
+
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include "bt_log_codec.h"
+
+namespace BT
+{
+struct LogFilter
+{
+    LogFilter()
+      : from_usec(0), to_usec(std::numeric_limits<uint64_t>::max()), status_mask(0xFF)
+    {
+    }
+
+    /// Time range, inclusive.
+    uint64_t from_usec;
+    uint64_t to_usec;
+
+    /// If not empty, only the transitions of these nodes.
+    std::vector<uint16_t> uids;
+
+    /// Bit (1 << status) set for each accepted value of the new status.
+    uint8_t status_mask;
+
+    void onlyStatus(NodeStatus status)
+    {
+        if (status_mask == 0xFF)
+        {
+            status_mask = 0;
+        }
+        status_mask |= static_cast<uint8_t>(1 << static_cast<int>(status));
+    }
+};
+
+/**
+ * @brief LogReader reads the files written by FileLogger, both V1 and V2.
+ *
+ * The file is memory mapped and never loaded entirely: V1 transitions are read in place,
+ * V2 blocks are decoded one at a time. The file can be larger than the available memory.
+ *
+ * A sparse index (one entry every few thousand transitions in V1, one per block in V2)
+ * is built when the file is opened, to seek to the beginning of a time range.
+ * Timestamps are assumed to be sorted, except for small differences between
+ * nodes running in different threads.
+ *
+ * Throws BehaviorTreeException if the file can't be opened or the tree is not valid.
+ * A truncated transition or block at the end of the file (still being written) is ignored.
+ */
+class LogReader
+{
+  public:
+    struct Node
+    {
+        uint16_t uid;
+        std::string instance_name;
+        std::string registration_name;
+        NodeType type;
+        std::vector<uint16_t> children_uid;
+    };
+
+    /// Return false to stop the iteration.
+    typedef std::function<bool(const LogTransition&)> Visitor;
+
+    explicit LogReader(const std::string& filename);
+
+    ~LogReader();
+
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    /// 1 or 2
+    int formatVersion() const
+    {
+        return version_;
+    }
+
+    uint16_t rootUID() const
+    {
+        return root_uid_;
+    }
+
+    /// Nodes in the same order of the file (depth first).
+    const std::vector<Node>& nodes() const
+    {
+        return nodes_;
+    }
+
+    /// Throws std::out_of_range if uid is not in the tree.
+    const Node& node(uint16_t uid) const;
+
+    /// UIDs of the nodes with this instance name or registration name.
+    std::vector<uint16_t> findUIDs(const std::string& name) const;
+
+    /// Number of transitions in the file.
+    size_t size() const
+    {
+        return transitions_count_;
+    }
+
+    /**
+     * @brief forEach calls the visitor for each transition that matches the filter,
+     * in the order of the file.
+     *
+     * @return the number of transitions passed to the visitor.
+     */
+    size_t forEach(const LogFilter& filter, const Visitor& visitor) const;
+
+    size_t forEach(const Visitor& visitor) const
+    {
+        return forEach(LogFilter(), visitor);
+    }
+
+  private:
+    struct IndexEntry
+    {
+        uint64_t timestamp_usec;   // first transition
+        size_t offset;             // V1: first transition. V2: block header
+    };
+
+    const uint8_t* data_;
+    size_t size_;
+
+    int version_;
+    size_t transitions_offset_;
+    size_t transitions_count_;
+
+    uint16_t root_uid_;
+    std::vector<Node> nodes_;
+    std::unordered_map<uint16_t, size_t> node_index_;
+
+    std::vector<IndexEntry> index_;
+
+    void readTree();
+
+    void buildIndex();
+
+    size_t forEachV1(size_t first_entry, const LogFilter& filter,
+                     const std::vector<bool>& uid_mask, const Visitor& visitor) const;
+
+    size_t forEachV2(size_t first_entry, const LogFilter& filter,
+                     const std::vector<bool>& uid_mask, const Visitor& visitor) const;
+};
+}
+
+#endif   // BT_LOG_READER_H
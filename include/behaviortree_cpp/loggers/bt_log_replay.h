@@ -0,0 +1,151 @@
+#ifndef BT_LOG_REPLAY_H
+#define BT_LOG_REPLAY_H
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/xml_parsing.h"
+#include "bt_log_reader.h"
+
+namespace BT
+{
+/// A point where the replayed tree disagrees with the log, see LogReplay.
+struct LogReplayDivergence
+{
+    /// Index of the replayed tick.
+    size_t tick;
+
+    /// UID of the node in the log.
+    uint16_t uid;
+
+    std::string node_name;
+
+    /// Empty if the tree did a transition that isn't in the log.
+    optional<LogTransition> expected;
+
+    /// Empty if the tree didn't do the expected transition.
+    /// Its timestamp is the one of the log at the current position.
+    optional<LogTransition> actual;
+};
+
+std::string toStr(const LogReplayDivergence& divergence);
+
+/**
+ * @brief LogReplay ticks a tree, created from the same XML of a recorded log,
+ * against the transitions of that log (see FileLogger and LogReader).
+ *
+ * Actions and conditions are replaced by stubs that return the statuses found in
+ * the log, in the same order. Control nodes and decorators are the real ones:
+ * each of their transitions is compared with the log, and the disagreements are
+ * reported as divergences.
+ *
+ * The replay is deterministic and doesn't wait: the position in the log is the
+ * clock. A stub that was RUNNING completes as soon as all the transitions logged
+ * before its completion were replayed; ticks that changed nothing are skipped.
+ * A TickProfiler attached to rootNode() measures the overhead of the control logic.
+ *
+ * Requirements:
+ *  - the log must start from the first tick of the tree (a dump of FlightRecorder
+ *    may start in the middle of an execution);
+ *  - nodes that depend on the wall clock or other threads, such as TimeoutNode,
+ *    behave differently than in the log;
+ *  - built-in actions are stubbed too: SetBlackboard doesn't write the blackboard.
+ *
+ * Throws BehaviorTreeException if the tree doesn't match the one in the log.
+ */
+class LogReplay
+{
+  public:
+    LogReplay(const BehaviorTreeFactory& factory, const std::string& xml_text,
+              const std::string& log_filename,
+              const Blackboard::Ptr& blackboard = Blackboard::Ptr());
+
+    LogReplay(const LogReplay&) = delete;
+    LogReplay& operator=(const LogReplay&) = delete;
+
+    /**
+     * @brief step ticks the root node once.
+     *
+     * @return false if there is nothing left to replay, or if the tree stopped
+     * following the log (the divergence is reported).
+     */
+    bool step();
+
+    /// Call step() until the end of the log or until max_divergences are found.
+    /// Return true if there isn't any divergence.
+    bool run(size_t max_divergences = 1);
+
+    const std::vector<LogReplayDivergence>& divergences() const
+    {
+        return divergences_;
+    }
+
+    TreeNode* rootNode() const
+    {
+        return tree_.root_node;
+    }
+
+    size_t tickCount() const
+    {
+        return tick_count_;
+    }
+
+    /// Transitions of the log reproduced by the tree.
+    size_t replayedTransitions() const
+    {
+        return replayed_count_;
+    }
+
+    size_t totalTransitions() const
+    {
+        return transitions_.size();
+    }
+
+    /// Timestamp of the last transition of the log reproduced by the tree.
+    uint64_t now() const
+    {
+        return now_usec_;
+    }
+
+  private:
+    class StubNode;
+
+    struct NodeTrack
+    {
+        TreeNode* node;
+        uint16_t log_uid;
+        std::vector<size_t> transitions;   // indexes into transitions_
+        size_t next_transition;            // next expected
+        size_t next_result;                // next non-IDLE status, used by stubs
+    };
+
+    NodeStatus stubTick(StubNode& stub);
+
+    void onTransition(size_t slot, NodeStatus prev_status, NodeStatus status);
+
+    void skipIdleResults(NodeTrack& track);
+
+    void markReplayed(size_t index);
+
+    void reportMissing(size_t index);
+
+    // first: it is destroyed after the subscribers, that refer to the other members
+    Tree tree_;
+
+    std::vector<LogTransition> transitions_;
+    std::vector<size_t> transition_slot_;
+    std::vector<bool> replayed_;
+    size_t first_pending_;
+
+    std::vector<NodeTrack> tracks_;
+    std::vector<TreeNode::StatusChangeSubscriber> subscribers_;
+
+    std::vector<LogReplayDivergence> divergences_;
+    size_t tick_count_;
+    size_t replayed_count_;
+    size_t last_replayed_in_tick_;
+    bool replayed_in_tick_;
+    bool stalled_;
+    uint64_t now_usec_;
+};
+}
+
+#endif   // BT_LOG_REPLAY_H
@@ -6,10 +6,15 @@
 
 namespace BT
 {
+/**
+ * @brief MinitraceLogger writes a trace in the JSON format of chrome://tracing.
+ *
+ * minitrace has a single global output: many instances can be created, for instance
+ * one for each tree, but all of them must use the same file, else the constructor
+ * throws std::logic_error. The file is written when the last one is destroyed.
+ */
 class MinitraceLogger : public StatusChangeLogger
 {
-    static std::atomic<bool> ref_count;
-
   public:
     MinitraceLogger(TreeNode* root_node, const char* filename_json);
 
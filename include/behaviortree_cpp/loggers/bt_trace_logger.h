@@ -0,0 +1,113 @@
+#ifndef BT_TRACE_LOGGER_H
+#define BT_TRACE_LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "behaviortree_cpp/behavior_tree.h"
+#include "behaviortree_cpp/mpsc_queue.h"
+
+namespace BT
+{
+/**
+ * @brief TraceLogger writes a trace in the JSON format of chrome://tracing and
+ * Perfetto (ui.perfetto.dev).
+ *
+ * Each executeTick() is a span on the lane of the thread that invoked it; the
+ * spans of the root node carry the index of the tick. The work of an
+ * AsyncActionNode is a span on the lane of its own thread, linked by a flow
+ * arrow to the tick that started it.
+ *
+ * Events are queued without locks and written to the file by a background thread,
+ * as they arrive: the file can be opened while the tree is running (a missing
+ * closing bracket is tolerated by the viewers). If the queue is full, events are
+ * dropped and counted by droppedEvents().
+ *
+ * The logger is attached as TickMonitor of all the nodes, next to the other ones
+ * (for instance a TickProfiler). Destroy it before the tree, when no node is running.
+ */
+class TraceLogger : public TickMonitor
+{
+  public:
+    TraceLogger(TreeNode* root_node, const char* filename_json,
+                size_t queue_capacity = 65536);
+
+    ~TraceLogger() override;
+
+    TraceLogger(const TraceLogger&) = delete;
+    TraceLogger& operator=(const TraceLogger&) = delete;
+
+    void onTick(const TreeNode& node, size_t slot, MonitorTime start,
+                std::chrono::nanoseconds elapsed, NodeStatus status) override;
+
+    void onAsyncStart(const TreeNode& node, size_t slot) override;
+
+    void onAsyncTick(const TreeNode& node, size_t slot, MonitorTime start,
+                     std::chrono::nanoseconds elapsed, NodeStatus status) override;
+
+    /// Block until all the events pushed so far are written into the file.
+    void flush();
+
+    uint64_t droppedEvents() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    enum class EventType : uint8_t
+    {
+        TICK,
+        ASYNC_WORK,
+        FLOW_START
+    };
+
+    struct Event
+    {
+        EventType type;
+        NodeStatus status;
+        uint32_t slot;
+        uint32_t thread;
+        int64_t start_ns;
+        int64_t duration_ns;
+        uint64_t flow_id;
+    };
+
+    void push(const Event& event);
+
+    void writerLoop();
+
+    void beginEvent();
+
+    void writeEvent(const Event& event);
+
+    std::vector<TreeNode*> nodes_;
+    // Each execution of an AsyncActionNode is a flow, identified by the node and the
+    // index of the execution: one counter is incremented by the thread that ticks,
+    // the other by the worker thread.
+    std::unique_ptr<uint32_t[]> async_started_;
+    std::unique_ptr<uint32_t[]> async_completed_;
+    MonitorTime first_timestamp_;
+
+    MPSCQueue<Event> queue_;
+    std::atomic<uint64_t> dropped_;
+
+    FILE* file_;
+    std::string buffer_;
+    bool first_event_;
+    std::vector<bool> named_threads_;
+    uint64_t tick_count_;
+
+    std::mutex mutex_;
+    std::condition_variable writer_cv_;
+    std::condition_variable flushed_cv_;
+    uint64_t flush_requests_;
+    uint64_t flushes_done_;
+    bool stop_;
+    std::thread writer_thread_;
+};
+}
+
+#endif   // BT_TRACE_LOGGER_H
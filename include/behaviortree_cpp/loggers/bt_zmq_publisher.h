@@ -2,47 +2,120 @@
 #define BT_ZMQ_PUBLISHER_H
 
 #include <array>
-#include <future>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include "abstract_logger.h"
 
 
 namespace BT
 {
-class PublisherZMQ : public StatusChangeLogger
+/**
+ * @brief PublisherHub owns the ZMQ sockets used by the PublisherZMQ of a process.
+ *
+ * By default, it publishes a single tree with the protocol expected by Groot and
+ * bt_recorder. Each message published on publisher_port is a single frame:
+ *
+ *   [status section size: uint32][status section][transitions count: uint32][transitions]
+ *
+ * The status section contains (uid: uint16, status: int8) of the nodes that changed
+ * since the previous message, or of all the nodes in a keyframe. Any request to the
+ * server on server_port returns the serialized tree.
+ *
+ * With multi_tree, many trees can be published together. Each message has two frames:
+ *
+ *  - [MULTI_TREE_PROTOCOL_VERSION: uint8][tree ID: uint16, little endian].
+ *    Subscribers can use it as a ZMQ_SUBSCRIBE prefix to receive a single tree.
+ *  - the message of the single tree protocol.
+ *
+ * The server replies to a request with the same content as the first frame with the
+ * serialized tree (empty if unknown). An empty request returns the tree with the lowest ID.
+ *
+ * A single thread sends the messages of all the trees.
+ */
+class PublisherHub
 {
-    static std::atomic<bool> ref_count;
-
   public:
-    PublisherZMQ(TreeNode* root_node, int max_msg_per_second = 25);
+    static constexpr uint8_t MULTI_TREE_PROTOCOL_VERSION = 1;
 
-    virtual ~PublisherZMQ();
+    /// Without multi_tree, adding a second tree throws std::logic_error.
+    PublisherHub(int publisher_port = 1666, int server_port = 1667, bool multi_tree = false);
 
-  private:
-    virtual void callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
-                          NodeStatus status) override;
+    ~PublisherHub();
 
-    virtual void flush() override;
+    PublisherHub(const PublisherHub&) = delete;
+    PublisherHub& operator=(const PublisherHub&) = delete;
+
+    /**
+     * Single tree hub used by the PublisherZMQ created without an explicit one.
+     * It is created, with the default ports, together with the first of them
+     * and destroyed with the last one.
+     */
+    static std::shared_ptr<PublisherHub> defaultHub();
 
-    TreeNode* root_node_;
-    std::vector<uint8_t> tree_buffer_;
-    std::vector<uint8_t> status_buffer_;
-    std::vector<SerializedTransition> transition_buffer_;
-    std::chrono::microseconds min_time_between_msgs_;
+  private:
+    friend class PublisherZMQ;
 
-    std::atomic_bool active_server_;
-    std::thread thread_;
+    /// When *resync is set, the statuses are read again from the nodes and the next
+    /// message is a keyframe. The nodes and the flag must outlive removeTree().
+    uint16_t addTree(TreeNode* root_node, std::chrono::microseconds min_time_between_msgs,
+                     std::chrono::microseconds keyframe_period, std::atomic<bool>* resync);
 
-    void createStatusBuffer();
+    /// The pending transitions of the tree are sent before returning.
+    void removeTree(uint16_t tree_id);
 
-    TimePoint deadline_;
-    std::mutex mutex_;
-    std::atomic_bool send_pending_;
+    /// Lock-free. Return false if the queue is full.
+    bool push(uint16_t tree_id, const SerializedTransition& transition);
 
-    std::future<void> send_future_;
+    void flush();
 
     struct Pimpl;
-    Pimpl* zmq_;
+    std::unique_ptr<Pimpl> _p;
+};
+
+/**
+ * @brief PublisherZMQ publishes the status of a tree through a PublisherHub.
+ *
+ * callback() only pushes the transition into a lock-free queue. The messages of this
+ * tree are sent at most max_msg_per_second and contain the transitions since the
+ * previous one. Every keyframe_period, the status of all the nodes is sent,
+ * so that a late subscriber gets the complete state.
+ *
+ * When the queue is full the transition is dropped: the statuses are then read
+ * again from the nodes, and sent as a keyframe in the next message.
+ */
+class PublisherZMQ : public StatusChangeLogger
+{
+  public:
+    PublisherZMQ(TreeNode* root_node, int max_msg_per_second = 25,
+                 std::chrono::milliseconds keyframe_period = std::chrono::milliseconds(1000),
+                 std::shared_ptr<PublisherHub> hub = nullptr);
+
+    virtual ~PublisherZMQ();
+
+    /// ID of the tree in the messages of a multi-tree hub.
+    uint16_t treeID() const
+    {
+        return tree_id_;
+    }
+
+    /// Number of transitions lost because the queue was full.
+    size_t droppedTransitions() const
+    {
+        return dropped_;
+    }
+
+  private:
+    virtual void callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
+                          NodeStatus status) override;
+
+    /// Send the pending transitions now, without waiting for the rate limit.
+    virtual void flush() override;
 
+    std::shared_ptr<PublisherHub> hub_;
+    uint16_t tree_id_;
+    std::atomic<size_t> dropped_;
+    std::atomic<bool> resync_;
 };
 }
 
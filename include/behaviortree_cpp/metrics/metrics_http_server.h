@@ -0,0 +1,47 @@
+#ifndef BT_METRICS_HTTP_SERVER_H
+#define BT_METRICS_HTTP_SERVER_H
+
+#include <atomic>
+#include <thread>
+#include "behaviortree_cpp/metrics/metrics_registry.h"
+
+namespace BT
+{
+/**
+ * @brief Minimal HTTP server that answers "GET /metrics" with the content
+ * of a MetricsRegistry, for Prometheus or any OpenMetrics scraper.
+ *
+ * Requests are served one at a time by a single thread. By default the server
+ * listens only on localhost. Throws BehaviorTreeException if the port can't be bound.
+ */
+class MetricsHttpServer
+{
+  public:
+    /// Use port 0 to let the system choose a free port (see port()).
+    MetricsHttpServer(const MetricsRegistry& registry, int port = 9464,
+                      const std::string& address = "127.0.0.1");
+
+    ~MetricsHttpServer();
+
+    MetricsHttpServer(const MetricsHttpServer&) = delete;
+    MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+
+    int port() const
+    {
+        return port_;
+    }
+
+  private:
+    void serverLoop();
+
+    void serveClient(int client_fd);
+
+    const MetricsRegistry& registry_;
+    int socket_fd_;
+    int port_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+};
+}
+
+#endif   // BT_METRICS_HTTP_SERVER_H
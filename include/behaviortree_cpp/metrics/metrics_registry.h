@@ -0,0 +1,232 @@
+#ifndef BT_METRICS_REGISTRY_H
+#define BT_METRICS_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace BT
+{
+/// Pairs (label name, label value), for instance {{"tree", "main"}}.
+typedef std::vector<std::pair<std::string, std::string>> MetricLabels;
+
+enum class MetricType
+{
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+};
+
+template <typename T>
+struct PaddedAtomic
+{
+    std::atomic<T> value;
+    char padding[64 - sizeof(std::atomic<T>)];
+};
+
+/**
+ * Values written by many threads: each thread increments one of the SHARDS cells,
+ * each in its own cache line; the cells are summed only when they are read.
+ */
+class ShardedCounter
+{
+  public:
+    static const size_t SHARDS = 16;
+
+    ShardedCounter();
+
+    void add(uint64_t value)
+    {
+        cells_[shardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t sum() const;
+
+    static size_t shardIndex();
+
+  private:
+    PaddedAtomic<uint64_t> cells_[SHARDS];
+};
+
+class Metric
+{
+  public:
+    virtual ~Metric() = default;
+
+    /// Write the samples of this series, in the OpenMetrics text format.
+    virtual void write(std::ostream& os, const std::string& name,
+                       const std::string& labels) const = 0;
+};
+
+/// Monotonic counter. inc() is lock free and cheap even if called by many threads.
+class Counter : public Metric
+{
+  public:
+    void inc(uint64_t value = 1)
+    {
+        counter_.add(value);
+    }
+
+    uint64_t value() const
+    {
+        return counter_.sum();
+    }
+
+    void write(std::ostream& os, const std::string& name,
+               const std::string& labels) const override;
+
+  private:
+    ShardedCounter counter_;
+};
+
+/// Value that can go up and down.
+class Gauge : public Metric
+{
+  public:
+    Gauge() : value_(0)
+    {
+    }
+
+    void set(double value)
+    {
+        value_.store(value, std::memory_order_relaxed);
+    }
+
+    void add(double value);
+
+    double value() const
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    void write(std::ostream& os, const std::string& name,
+               const std::string& labels) const override;
+
+  private:
+    std::atomic<double> value_;
+};
+
+/// Distribution of observed values, counted in buckets with fixed upper bounds.
+class Histogram : public Metric
+{
+  public:
+    /// bounds must be sorted; a last bucket "+Inf" is implicit.
+    explicit Histogram(const std::vector<double>& bounds);
+
+    void observe(double value);
+
+    /// Cumulative count of each bucket, the last one being "+Inf".
+    std::vector<uint64_t> bucketCounts() const;
+
+    uint64_t count() const;
+
+    double sum() const;
+
+    const std::vector<double>& bounds() const
+    {
+        return bounds_;
+    }
+
+    void write(std::ostream& os, const std::string& name,
+               const std::string& labels) const override;
+
+  private:
+    std::vector<double> bounds_;
+    std::unique_ptr<ShardedCounter[]> buckets_;
+    PaddedAtomic<double> sums_[ShardedCounter::SHARDS];
+};
+
+/// Value computed by a function when the registry is scraped.
+class CallbackMetric : public Metric
+{
+  public:
+    CallbackMetric(MetricType type, std::function<double()> callback)
+      : type_(type), callback_(std::move(callback))
+    {
+    }
+
+    void write(std::ostream& os, const std::string& name,
+               const std::string& labels) const override;
+
+  private:
+    MetricType type_;
+    std::function<double()> callback_;
+};
+
+/**
+ * @brief MetricsRegistry owns a set of metrics and writes them in the
+ * OpenMetrics text format (also accepted by Prometheus).
+ *
+ * Metrics are identified by name and labels: requesting the same series twice
+ * returns the same object. References stay valid until the series is removed or
+ * the registry is destroyed. Updating a metric never locks the registry;
+ * only creation, removal and scrape do.
+ *
+ * Counter names must not have the "_total" suffix; it is added to the sample.
+ */
+class MetricsRegistry
+{
+  public:
+    MetricsRegistry() = default;
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /// Registry shared by the whole process.
+    static MetricsRegistry& global();
+
+    Counter& counter(const std::string& name, const std::string& help,
+                     const MetricLabels& labels = MetricLabels());
+
+    Gauge& gauge(const std::string& name, const std::string& help,
+                 const MetricLabels& labels = MetricLabels());
+
+    /// If the series exists already, the bounds are ignored.
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const std::vector<double>& bounds,
+                         const MetricLabels& labels = MetricLabels());
+
+    /// The callback is invoked by the thread that scrapes, with the registry locked.
+    void addCallback(const std::string& name, const std::string& help, MetricType type,
+                     const MetricLabels& labels, std::function<double()> callback);
+
+    /// Remove a series. Does nothing if it doesn't exist.
+    void remove(const std::string& name, const MetricLabels& labels = MetricLabels());
+
+    /// Write all the metrics, terminated by "# EOF".
+    void write(std::ostream& os) const;
+
+    std::string scrape() const;
+
+    /**
+     * Write the metrics into a temporary file that is then renamed: readers
+     * (for instance the textfile collector of node_exporter) never see a partial file.
+     * Throws BehaviorTreeException on error.
+     */
+    void writeFile(const std::string& filename) const;
+
+  private:
+    struct Family
+    {
+        MetricType type;
+        std::string help;
+        // key is the formatted list of labels
+        std::map<std::string, std::unique_ptr<Metric>> series;
+    };
+
+    Metric& getOrCreate(const std::string& name, const std::string& help, MetricType type,
+                        const MetricLabels& labels,
+                        const std::function<Metric*()>& create);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+}
+
+#endif   // BT_METRICS_REGISTRY_H
@@ -0,0 +1,70 @@
+#ifndef BT_TREE_METRICS_H
+#define BT_TREE_METRICS_H
+
+#include <chrono>
+#include "behaviortree_cpp/metrics/metrics_registry.h"
+#include "behaviortree_cpp/tree_node.h"
+
+namespace BT
+{
+/**
+ * @brief TreeMetrics publishes the metrics of a tree into a MetricsRegistry,
+ * with the label tree="<tree_name>":
+ *
+ * - bt_tree_ticks_total{status}: ticks of the root, by resulting status.
+ * - bt_tree_tick_duration_seconds: histogram of the duration of the ticks.
+ * - bt_tree_tick_overruns_total: ticks longer than the tick period.
+ * - bt_tree_running_nodes: nodes in state RUNNING.
+ * - bt_tree_async_actions_running: AsyncActionNodes and CoroActionNodes in state RUNNING.
+ *
+ * The counters are updated by tick() (or by recordTick(), when the root is ticked by
+ * someone else); the gauges are computed only when the registry is scraped.
+ * TickDriver and TreeExecutor update them when TickDriverOptions::metrics or
+ * TreeScheduleHints::metrics point to this object; leave tick_period zero then:
+ * they report the overruns with recordOverrun(), according to their own deadlines.
+ *
+ * The tree must outlive this object, and tree_name must be unique in the registry.
+ */
+class TreeMetrics
+{
+  public:
+    /**
+     * @param tick_period  expected period of the ticks; zero to disable the overruns.
+     */
+    TreeMetrics(MetricsRegistry& registry, TreeNode* root_node, const std::string& tree_name,
+                std::chrono::microseconds tick_period = std::chrono::microseconds(0));
+
+    ~TreeMetrics();
+
+    TreeMetrics(const TreeMetrics&) = delete;
+    TreeMetrics& operator=(const TreeMetrics&) = delete;
+
+    /// Tick the root node and record the duration.
+    NodeStatus tick();
+
+    void recordTick(std::chrono::nanoseconds elapsed, NodeStatus status);
+
+    /// Count an overrun detected by the caller, in addition to the ones of tick_period.
+    void recordOverrun();
+
+    /// Upper bounds (seconds) of the buckets of bt_tree_tick_duration_seconds.
+    static const std::vector<double>& durationBuckets();
+
+  private:
+    MetricsRegistry& registry_;
+    TreeNode* root_node_;
+    MetricLabels labels_;
+    std::chrono::nanoseconds tick_period_;
+
+    std::vector<TreeNode*> nodes_;
+    std::vector<TreeNode*> async_nodes_;
+
+    Counter& success_;
+    Counter& failure_;
+    Counter& running_;
+    Counter& overruns_;
+    Histogram& duration_;
+};
+}
+
+#endif   // BT_TREE_METRICS_H
@@ -0,0 +1,110 @@
+#ifndef BT_MPSC_QUEUE_H
+#define BT_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace BT
+{
+/**
+ * @brief Bounded, lock-free queue with many producers and a single consumer.
+ *
+ * push() never blocks and never allocates: it returns false if the queue is full.
+ * Based on the bounded queue of Dmitry Vyukov; each cell has a sequence number
+ * that tells whether it can be written or read.
+ */
+template <typename T>
+class MPSCQueue
+{
+  public:
+    /// capacity is rounded up to a power of two.
+    explicit MPSCQueue(size_t capacity) : head_(0), tail_(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    /// Thread safe.
+    bool push(const T& value)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // full
+            }
+            else
+            {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Must be called by one thread only.
+    bool pop(T& value)
+    {
+        Cell& cell = cells_[tail_ & mask_];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail_ + 1) < 0)
+        {
+            return false;   // empty
+        }
+        value = cell.value;
+        cell.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+    size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+  private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+
+    std::atomic<size_t> head_;
+    // producers and consumer write different cache lines. Padding instead of alignas:
+    // before C++17, operator new ignores the alignment of heap allocated owners.
+    char padding_[64];
+    size_t tail_;
+};
+}
+
+#endif   // BT_MPSC_QUEUE_H
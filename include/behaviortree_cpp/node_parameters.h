@@ -0,0 +1,194 @@
+#ifndef BT_NODE_PARAMETERS_H
+#define BT_NODE_PARAMETERS_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <initializer_list>
+#include "behaviortree_cpp/basic_types.h"
+
+namespace BT
+{
+/**
+ * We call Parameters the set of Key/Values that can be read from file and are
+ * used to parametrize an object. It is up to the user's code to parse the string.
+ *
+ * Every key/value pair is interned in a process-wide, thread-safe pool:
+ * thousands of nodes sharing the same parameters don't duplicate any string
+ * and each entry costs a single pointer. The pairs are reference counted and
+ * removed from the pool when the last NodeParameters that uses them is released.
+ * Entries are kept in a small vector sorted by key.
+ *
+ * The interface is similar to a read-only std::map<std::string,std::string>;
+ * use set() to add or modify an entry.
+ */
+class NodeParameters
+{
+  public:
+    typedef std::pair<std::string, std::string> value_type;
+
+  private:
+    struct InternedEntry
+    {
+        value_type value;
+        mutable std::atomic<unsigned> references;
+    };
+    typedef std::vector<const InternedEntry*> Entries;
+
+  public:
+    class const_iterator
+    {
+      public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef NodeParameters::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef const value_type& reference;
+
+        const_iterator() : it_()
+        {
+        }
+
+        reference operator*() const
+        {
+            return (*it_)->value;
+        }
+
+        pointer operator->() const
+        {
+            return &(*it_)->value;
+        }
+
+        const_iterator& operator++()
+        {
+            ++it_;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator tmp = *this;
+            ++it_;
+            return tmp;
+        }
+
+        const_iterator& operator--()
+        {
+            --it_;
+            return *this;
+        }
+
+        const_iterator operator+(difference_type n) const
+        {
+            return const_iterator(it_ + n);
+        }
+
+        difference_type operator-(const const_iterator& other) const
+        {
+            return it_ - other.it_;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return it_ == other.it_;
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return it_ != other.it_;
+        }
+
+      private:
+        friend class NodeParameters;
+
+        explicit const_iterator(Entries::const_iterator it) : it_(it)
+        {
+        }
+
+        Entries::const_iterator it_;
+    };
+
+    typedef const_iterator iterator;
+
+    NodeParameters() = default;
+
+    NodeParameters(std::initializer_list<value_type> init);
+
+    NodeParameters(const NodeParameters& other);
+
+    NodeParameters(NodeParameters&& other) noexcept;
+
+    NodeParameters& operator=(const NodeParameters& other);
+
+    NodeParameters& operator=(NodeParameters&& other) noexcept;
+
+    ~NodeParameters();
+
+    /// Add a new entry or replace the value of an existing one.
+    void set(StringView key, StringView value);
+
+    /// Return false if the key was not present.
+    bool erase(StringView key);
+
+    const_iterator find(StringView key) const;
+
+    /// Throw std::out_of_range if the key is not present.
+    const std::string& at(StringView key) const;
+
+    size_t count(StringView key) const
+    {
+        return find(key) == end() ? 0 : 1;
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(entries_.begin());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(entries_.end());
+    }
+
+    size_t size() const
+    {
+        return entries_.size();
+    }
+
+    bool empty() const
+    {
+        return entries_.empty();
+    }
+
+    void clear();
+
+    bool operator==(const NodeParameters& other) const
+    {
+        // interned entries can be compared by address
+        return entries_ == other.entries_;
+    }
+
+    bool operator!=(const NodeParameters& other) const
+    {
+        return entries_ != other.entries_;
+    }
+
+    /// Number of distinct key/value pairs currently interned, by all the instances.
+    static size_t internedCount();
+
+  private:
+    struct Pool;
+
+    static const InternedEntry* intern(StringView key, StringView value);
+
+    static void release(const InternedEntry* entry);
+
+    Entries::const_iterator lowerBound(StringView key) const;
+
+    Entries entries_;
+};
+}
+
+#endif   // BT_NODE_PARAMETERS_H
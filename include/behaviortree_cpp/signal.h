@@ -1,6 +1,7 @@
 #ifndef SIMPLE_SIGNAL_H
 #define SIMPLE_SIGNAL_H
 
+#include <algorithm>
 #include <memory>
 #include <functional>
 #include <vector>
@@ -10,6 +11,7 @@ namespace BT
 /**
  * Super simple Signal/Slop implementation, AKA "Observable pattern".
  * The subscriber is active until it goes out of scope or Subscriber::reset() is called.
+ * notify() doesn't allocate.
  */
 template <typename... CallableArgs>
 class Signal
@@ -18,24 +20,34 @@ class Signal
     using CallableFunction = std::function<void(CallableArgs...)>;
     using Subscriber = std::shared_ptr<CallableFunction>;
 
+    // Expired subscribers are skipped, not erased: releasing them would touch the allocator.
     void notify(CallableArgs... args)
     {
-        for (size_t i = 0; i < subscribers_.size();)
+        for (const auto& weak_sub : subscribers_)
         {
-            if (auto sub = subscribers_[i].lock())
+            if (auto sub = weak_sub.lock())
             {
                 (*sub)(args...);
-                i++;
-            }
-            else
-            {
-                subscribers_.erase(subscribers_.begin() + i);
             }
         }
     }
 
+    /// False if no subscriber is active: the arguments of notify() needn't be built.
+    bool hasSubscribers() const
+    {
+        return std::any_of(subscribers_.begin(), subscribers_.end(),
+                           [](const std::weak_ptr<CallableFunction>& sub) {
+                               return !sub.expired();
+                           });
+    }
+
     Subscriber subscribe(CallableFunction func)
     {
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                          [](const std::weak_ptr<CallableFunction>& sub) {
+                                              return sub.expired();
+                                          }),
+                           subscribers_.end());
         Subscriber sub = std::make_shared<CallableFunction>(std::move(func));
         subscribers_.emplace_back(sub);
         return sub;
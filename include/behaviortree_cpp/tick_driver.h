@@ -0,0 +1,287 @@
+#ifndef BT_TICK_DRIVER_H
+#define BT_TICK_DRIVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "behaviortree_cpp/tree_node.h"
+#include "behaviortree_cpp/blackboard/blackboard.h"
+
+namespace BT
+{
+class TreeMetrics;
+
+enum class SchedulingPolicy
+{
+    OTHER,   // SCHED_OTHER, the default time sharing
+    FIFO,    // SCHED_FIFO
+    RR       // SCHED_RR
+};
+
+/// What TickDriver does after a tick that ended after the deadline of the following one.
+enum class OverrunPolicy
+{
+    SKIP,       // skip the deadlines already missed, keeping the phase
+    CATCH_UP,   // tick immediately, until the missed deadlines are recovered
+    STRETCH     // tick immediately, and count the next deadlines from there
+};
+
+struct TickDriverOptions
+{
+    explicit TickDriverOptions(std::chrono::microseconds period = std::chrono::milliseconds(10))
+      : period(period),
+        policy(SchedulingPolicy::OTHER),
+        tick_priority(0),
+        worker_priority(0),
+        tick_cpu(-1),
+        lock_memory(false),
+        prefault_stack_size(0),
+        overrun_policy(OverrunPolicy::SKIP),
+        max_catch_up_ticks(10),
+        overrun_history(64),
+        halt_on_stop(true),
+        event_driven(false),
+        idle_timeout(0),
+        metrics(nullptr)
+    {
+    }
+
+    /// Period of the ticks. The deadlines are absolute: they don't drift.
+    std::chrono::microseconds period;
+
+    /// Scheduling of the tick thread and of the threads of the AsyncActionNodes.
+    SchedulingPolicy policy;
+
+    /// With FIFO and RR, from 1 (lowest) to 99.
+    int tick_priority;
+    int worker_priority;
+
+    /// CPU of the tick thread; -1 to leave it unpinned.
+    int tick_cpu;
+
+    /// CPUs of the AsyncActionNodes, assigned in depth first order (round robin).
+    /// Empty to leave them unpinned.
+    std::vector<int> worker_cpus;
+
+    /** Lock all the memory of the process in RAM with mlockall(), including the
+     * nodes and the blackboard, and don't let malloc give the freed memory back
+     * to the system: the tick never waits for a page fault.
+     */
+    bool lock_memory;
+
+    /// Bytes of stack of the tick thread written before the first tick, to fault its pages in.
+    size_t prefault_stack_size;
+
+    OverrunPolicy overrun_policy;
+
+    /// With CATCH_UP, the older missed deadlines are skipped.
+    unsigned max_catch_up_ticks;
+
+    /// Number of the most recent overruns returned by TickDriver::overruns().
+    size_t overrun_history;
+
+    /// When stop() interrupts a RUNNING tree, halt it from the tick thread before returning.
+    bool halt_on_stop;
+
+    /** Tick only when something can change (see TickDriver::notify()). The period is
+     * then the minimum interval between two ticks: the events in between are coalesced.
+     */
+    bool event_driven;
+
+    /// With event_driven, tick anyway after this time without events; zero to wait forever.
+    std::chrono::microseconds idle_timeout;
+
+    /// If not null, updated with the duration and result of each tick, and the overruns.
+    /// It must outlive the driver.
+    TreeMetrics* metrics;
+};
+
+/// A tick that ended after the deadline of the following one.
+struct TickOverrun
+{
+    /// Counted from 0 since the last resetStatistics().
+    uint64_t tick;
+
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+
+    /// How much the end was late with respect to the deadline of the following tick.
+    std::chrono::nanoseconds lateness() const;
+};
+
+/// Lateness of the start of the ticks with respect to their deadlines.
+struct TickJitterStatistics
+{
+    uint64_t ticks;
+
+    /// Ticks that ended after the deadline of the following one.
+    uint64_t overruns;
+
+    uint64_t total_ns;
+    uint64_t max_ns;
+
+    /// Counts with the buckets of TickProfiler (see TickProfiler::bucketLowerBound()).
+    std::vector<uint32_t> histogram;
+
+    /// Approximated from the histogram (relative error smaller than 25%). 0 <= p <= 1.
+    uint64_t percentileNs(double p) const;
+};
+
+/**
+ * @brief TickDriver ticks the root of a tree at a fixed rate, with a real-time
+ * profile: the tick thread and the threads of the AsyncActionNodes can be pinned to
+ * CPUs and scheduled with SCHED_FIFO or SCHED_RR, and the memory locked in RAM.
+ *
+ *     TickDriverOptions options(std::chrono::milliseconds(1));
+ *     options.policy = SchedulingPolicy::FIFO;
+ *     options.tick_priority = 80;
+ *     options.tick_cpu = 3;
+ *     options.lock_memory = true;
+ *
+ *     TickDriver driver(tree.root_node, options);
+ *     NodeStatus status = driver.run();
+ *
+ * The parts of the profile that can't be applied (for instance SCHED_FIFO without
+ * the capability CAP_SYS_NICE) are listed by warnings(); the others are applied anyway.
+ * Scheduling, affinity and memory locking are supported only on Linux.
+ *
+ * With options.event_driven, a RUNNING tree sleeps until one of these events:
+ *
+ *  - an AsyncActionNode completes, or any node changes status outside the tick thread;
+ *  - a TimeoutNode expires;
+ *  - a key passed to watchBlackboard() is written outside the tick thread;
+ *  - notify() is invoked.
+ *
+ * eventFd() becomes readable on the same events, to tick the tree with processEvents()
+ * from an existing epoll loop instead of run().
+ *
+ * After an overrun, the next deadline depends on options.overrun_policy. When
+ * stop() interrupts a RUNNING tree, the root is halted (see options.halt_on_stop):
+ * the halt runs in the tick thread, never concurrently with a tick.
+ *
+ * The tree must outlive the driver.
+ */
+class TickDriver
+{
+  public:
+    TickDriver(TreeNode* root_node, const TickDriverOptions& options = TickDriverOptions());
+
+    /** Invokes stop(). Then it waits for the callbacks of the tree that are invoking
+     * notify() in other threads (AsyncActionNodes, TimeoutNodes, blackboard writes):
+     * after the destructor, they don't touch the driver anymore.
+     */
+    ~TickDriver();
+
+    TickDriver(const TickDriver&) = delete;
+    TickDriver& operator=(const TickDriver&) = delete;
+
+    /**
+     * Apply the profile to the calling thread and tick the root until it returns
+     * SUCCESS or FAILURE, or stop() is invoked. Return the last status of the root.
+     */
+    NodeStatus run();
+
+    /// Invoke run() in a new thread.
+    void start();
+
+    /// Make run() return after the current tick, and join the thread of start().
+    /// A RUNNING tree is halted first, if options.halt_on_stop.
+    void stop();
+
+    /// Last status returned by the root, IDLE before the first tick.
+    NodeStatus lastStatus() const;
+
+    TickJitterStatistics statistics() const;
+
+    /// Also clears the overruns.
+    void resetStatistics();
+
+    /// The most recent overruns (at most options.overrun_history), the oldest first.
+    std::vector<TickOverrun> overruns() const;
+
+    /// The parts of the profile that were not applied, and the reasons.
+    std::vector<std::string> warnings() const;
+
+    const TickDriverOptions& options() const;
+
+    /// Wake up an event driven tree. Thread safe; it can be invoked by any thread.
+    void notify();
+
+    /// Invoke notify() when one of these keys is written. Invoke before ticking.
+    void watchBlackboard(const Blackboard::Ptr& blackboard, const std::vector<std::string>& keys);
+
+    /** With event_driven, an eventfd that becomes readable after notify() (Linux only;
+     * -1 otherwise). It is non blocking, and reset by processEvents().
+     */
+    int eventFd() const;
+
+    /** For an external event loop, alternative to run() and start(): reset eventFd()
+     * and tick the root once. The calling thread becomes the tick thread.
+     * Invoke it once to start the tree, then each time eventFd() is readable.
+     */
+    NodeStatus processEvents();
+
+  private:
+    NodeStatus loop();
+
+    NodeStatus periodicLoop();
+
+    NodeStatus eventLoop();
+
+    NodeStatus tickOnEvent();
+
+    bool isTickThread() const;
+
+    // Wraps the callbacks subscribed to the tree: the destructor waits for them.
+    template <typename... Args>
+    std::function<void(Args...)> guardedCallback(std::function<void(Args...)> callback);
+
+    void applyProfile();
+
+    void recordTick(std::chrono::nanoseconds lateness, std::chrono::nanoseconds duration,
+                    NodeStatus status, bool overrun);
+
+    void recordOverrun(std::chrono::steady_clock::time_point deadline,
+                       std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end);
+
+    void addWarning(const std::string& warning);
+
+    TreeNode* root_node_;
+    TickDriverOptions options_;
+    std::vector<TreeNode*> async_nodes_;
+
+    // status changes, timeouts and blackboard writes that invoke notify()
+    std::vector<std::shared_ptr<void>> subscribers_;
+    struct CallbackGuard;
+    std::shared_ptr<CallbackGuard> callback_guard_;
+    std::atomic<std::thread::id> tick_thread_;
+    bool pending_event_;
+    std::chrono::steady_clock::time_point event_time_;
+    int event_fd_;
+
+    std::atomic<bool> stop_requested_;
+    std::atomic<NodeStatus> last_status_;
+    std::mutex wakeup_mutex_;
+    std::condition_variable wakeup_;
+    std::thread thread_;
+
+    mutable std::mutex warnings_mutex_;
+    std::vector<std::string> warnings_;
+
+    // ring buffer, allocated in the constructor
+    mutable std::mutex overruns_mutex_;
+    std::vector<TickOverrun> overruns_;
+    size_t overruns_next_;
+
+    struct Statistics;
+    std::unique_ptr<Statistics> statistics_;
+};
+}
+
+#endif   // BT_TICK_DRIVER_H
@@ -0,0 +1,56 @@
+#ifndef BT_TICK_MONITOR_H
+#define BT_TICK_MONITOR_H
+
+#include <chrono>
+#include <cstddef>
+#include "behaviortree_cpp/basic_types.h"
+
+namespace BT
+{
+class TreeNode;
+
+/**
+ * @brief TickMonitor is notified at the end of each TreeNode::executeTick()
+ * of the nodes it is attached to (see TreeNode::addTickMonitor).
+ *
+ * onTick() is invoked by the thread that ticks the node, with no lock held:
+ * implementations must be cheap and thread safe.
+ */
+class TickMonitor
+{
+  public:
+    virtual ~TickMonitor() = default;
+
+    /// Not BT::TimePoint: the ticks are measured with the steady clock.
+    typedef std::chrono::steady_clock::time_point MonitorTime;
+
+    /**
+     * @param node      the node that was ticked.
+     * @param slot      the value passed to TreeNode::addTickMonitor().
+     * @param start     when executeTick() was invoked.
+     * @param elapsed   time spent in executeTick(), including the children.
+     * @param status    status of the node after the tick.
+     */
+    virtual void onTick(const TreeNode& node, size_t slot, MonitorTime start,
+                        std::chrono::nanoseconds elapsed, NodeStatus status) = 0;
+
+    /// Invoked at the beginning of executeTick(), and of the work of an AsyncActionNode
+    /// in its own thread. Each invocation is followed by onTick() or onAsyncTick().
+    virtual void onTickStart(const TreeNode& /*node*/, size_t /*slot*/)
+    {
+    }
+
+    /// Invoked by AsyncActionNode::executeTick() when it wakes up its worker thread.
+    virtual void onAsyncStart(const TreeNode& /*node*/, size_t /*slot*/)
+    {
+    }
+
+    /// Invoked by the worker thread of an AsyncActionNode when its tick() is completed.
+    virtual void onAsyncTick(const TreeNode& /*node*/, size_t /*slot*/, MonitorTime /*start*/,
+                             std::chrono::nanoseconds /*elapsed*/, NodeStatus /*status*/)
+    {
+    }
+};
+}
+
+#endif   // BT_TICK_MONITOR_H
@@ -0,0 +1,100 @@
+#ifndef BT_TICK_PROFILER_H
+#define BT_TICK_PROFILER_H
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "behaviortree_cpp/tree_node.h"
+
+namespace BT
+{
+/// Statistics of a single node, copied by TickProfiler::snapshot().
+struct NodeTickStatistics
+{
+    uint16_t uid;
+    std::string name;
+    std::string registration_name;
+
+    uint64_t ticks;
+    uint64_t success;
+    uint64_t failure;
+    uint64_t running;
+
+    uint64_t total_ns;
+    uint64_t max_ns;
+
+    /// Counts of the log-linear histogram, see TickProfiler::bucketLowerBound().
+    std::vector<uint32_t> histogram;
+
+    /// Approximated from the histogram (relative error smaller than 25%). 0 <= p <= 1.
+    uint64_t percentileNs(double p) const;
+};
+
+/// Percentile (0 <= p <= 1) of a histogram with the buckets of TickProfiler.
+uint64_t histogramPercentileNs(const std::vector<uint32_t>& histogram, uint64_t max_ns, double p);
+
+/**
+ * @brief TickProfiler measures the time spent in executeTick() by each node of a tree,
+ * and counts the results.
+ *
+ * The time of a node includes the time of its children.
+ *
+ * Each node writes into its own slot, preallocated in the constructor; no lock is taken
+ * and nothing is allocated while ticking. A node must not be ticked concurrently by
+ * two threads (which is never the case in this library).
+ *
+ * The profiler is attached next to the other TickMonitors of the nodes, and detaches
+ * itself in the destructor. It must be destroyed before the tree.
+ */
+class TickProfiler : public TickMonitor
+{
+  public:
+    /// Latencies longer than about 18 minutes are stored in the last bucket.
+    static const size_t BUCKETS = 156;
+
+    explicit TickProfiler(TreeNode* root_node);
+
+    ~TickProfiler() override;
+
+    TickProfiler(const TickProfiler&) = delete;
+    TickProfiler& operator=(const TickProfiler&) = delete;
+
+    void onTick(const TreeNode& node, size_t slot, MonitorTime start,
+                std::chrono::nanoseconds elapsed, NodeStatus status) override;
+
+    /// Statistics of all the nodes, in depth first order.
+    std::vector<NodeTickStatistics> snapshot() const;
+
+    /// Clear all the statistics. Concurrent ticks may be partially lost.
+    void reset();
+
+    /// Print a table, sorted by total time. Latencies are in microseconds.
+    void dumpTable(std::ostream& os) const;
+
+    /// Print a JSON array with an object per node.
+    void dumpJSON(std::ostream& os) const;
+
+    static size_t bucketIndex(uint64_t ns);
+
+    /// Smallest latency (ns) stored in the bucket.
+    static uint64_t bucketLowerBound(size_t index);
+
+  private:
+    struct Slot
+    {
+        std::atomic<uint64_t> ticks;
+        std::atomic<uint64_t> success;
+        std::atomic<uint64_t> failure;
+        std::atomic<uint64_t> running;
+        std::atomic<uint64_t> total_ns;
+        std::atomic<uint64_t> max_ns;
+        std::atomic<uint32_t> histogram[BUCKETS];
+    };
+
+    std::vector<TreeNode*> nodes_;
+    std::unique_ptr<Slot[]> slots_;
+};
+}
+
+#endif   // BT_TICK_PROFILER_H
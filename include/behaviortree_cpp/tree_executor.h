@@ -0,0 +1,158 @@
+#ifndef BT_TREE_EXECUTOR_H
+#define BT_TREE_EXECUTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "behaviortree_cpp/tree_node.h"
+
+namespace BT
+{
+class TreeMetrics;
+
+struct TreeExecutorOptions
+{
+    explicit TreeExecutorOptions(unsigned threads = std::thread::hardware_concurrency())
+      : threads(threads > 0 ? threads : 1)
+    {
+    }
+
+    /// Number of worker threads.
+    unsigned threads;
+
+    /// CPU of each worker (round robin); empty to leave them unpinned.
+    /// Best effort, Linux only.
+    std::vector<int> worker_cpus;
+};
+
+/// How a tree is scheduled by TreeExecutor.
+struct TreeScheduleHints
+{
+    explicit TreeScheduleHints(std::chrono::microseconds period = std::chrono::milliseconds(10))
+      : period(period), priority(0), worker(-1), metrics(nullptr)
+    {
+    }
+
+    /// Period of the ticks; zero to tick it again as soon as a worker is free.
+    /// The ticks that can't be executed in time are skipped, not accumulated.
+    std::chrono::microseconds period;
+
+    /// Among the trees ready to be ticked, the ones with higher priority go first.
+    int priority;
+
+    /// The worker (and therefore CPU, see TreeExecutorOptions::worker_cpus) the tree
+    /// returns to after each tick; -1 to let it move to the worker that stole it last.
+    int worker;
+
+    /// If not null, updated with the duration and result of each tick, and the ticks that
+    /// ended after the deadline of the following one. It must outlive the schedule of the tree.
+    TreeMetrics* metrics;
+};
+
+/**
+ * @brief TreeExecutor ticks many independent trees on a small pool of worker
+ * threads, instead of a thread and a loop for each tree.
+ *
+ *     TreeExecutor executor(TreeExecutorOptions(4));
+ *     for (auto& tree : trees)
+ *     {
+ *         executor.add(tree.root_node, TreeScheduleHints(std::chrono::milliseconds(20)));
+ *     }
+ *
+ * Each worker has its own queue of trees, ordered by deadline and priority; an idle
+ * worker steals the trees that are due from the others, and sleeps until the earliest
+ * deadline of the workers busy ticking: a tree doesn't wait for the long tick of another.
+ * A tree is in a single queue, or being ticked by a single worker: it is never ticked
+ * concurrently with itself. Different trees are ticked concurrently; they must not
+ * share a blackboard or nodes unless those are thread safe.
+ *
+ * A tree is removed from the schedule when it returns SUCCESS or FAILURE, or with remove().
+ * The trees must outlive the executor, or be removed first.
+ */
+class TreeExecutor
+{
+  public:
+    typedef uint64_t TreeID;
+
+    explicit TreeExecutor(const TreeExecutorOptions& options = TreeExecutorOptions());
+
+    /// Joins the workers; the trees that are still scheduled are not halted.
+    ~TreeExecutor();
+
+    TreeExecutor(const TreeExecutor&) = delete;
+    TreeExecutor& operator=(const TreeExecutor&) = delete;
+
+    /// Schedule a tree; the first tick is immediate. Thread safe.
+    TreeID add(TreeNode* root_node, const TreeScheduleHints& hints = TreeScheduleHints());
+
+    /// Unschedule a tree, waiting for its current tick, if any, and halt it if RUNNING.
+    /// Thread safe. Return false if the tree was not found.
+    bool remove(TreeID id);
+
+    /// Last status returned by the root of a tree; IDLE before its first tick.
+    NodeStatus status(TreeID id) const;
+
+    /// Block until a tree returns SUCCESS or FAILURE, and return it.
+    NodeStatus wait(TreeID id);
+
+    /// Number of trees added and not removed, finished ones included.
+    size_t size() const;
+
+    /// Ticks executed by all the workers.
+    uint64_t ticks() const;
+
+    const TreeExecutorOptions& options() const;
+
+  private:
+    struct Entry;
+    struct Worker;
+
+    void workerLoop(size_t index);
+
+    Entry* popReady(Worker& worker, std::chrono::steady_clock::time_point now,
+                    std::chrono::steady_clock::time_point* next_deadline, bool* backlog);
+
+    // next_deadline is lowered to the earliest deadline of the other busy workers
+    Entry* steal(size_t thief, std::chrono::steady_clock::time_point now,
+                 std::chrono::steady_clock::time_point* next_deadline);
+
+    void tickEntry(Entry* entry, size_t worker_index);
+
+    void push(size_t worker_index, Entry* entry);
+
+    void wakeUpWorkers();
+
+    // wake up the sleeping workers, unless they are going to wake up before the deadline
+    void wakeUpWorkerBefore(std::chrono::steady_clock::time_point deadline);
+
+    std::shared_ptr<Entry> find(TreeID id) const;
+
+    TreeExecutorOptions options_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    mutable std::mutex entries_mutex_;
+    std::unordered_map<TreeID, std::shared_ptr<Entry>> entries_;
+    TreeID next_id_;
+    size_t next_worker_;
+
+    // idle workers sleep here until their next deadline or a new generation
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<uint64_t> wake_generation_;
+    std::atomic<unsigned> idle_workers_;
+    // deadline of the last worker that went to sleep
+    std::chrono::steady_clock::time_point sleep_until_;
+    std::atomic<bool> stop_;
+
+    // completed and removed trees
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+};
+}
+
+#endif   // BT_TREE_EXECUTOR_H
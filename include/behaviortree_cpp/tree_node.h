@@ -18,23 +18,31 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <functional>
 
 #include "behaviortree_cpp/optional.hpp"
 #include "behaviortree_cpp/tick_engine.h"
+#include "behaviortree_cpp/tick_monitor.h"
 #include "behaviortree_cpp/exceptions.h"
 #include "behaviortree_cpp/signal.h"
 #include "behaviortree_cpp/basic_types.h"
+#include "behaviortree_cpp/node_parameters.h"
 #include "behaviortree_cpp/blackboard/blackboard.h"
 
 namespace BT
 {
-// We call Parameters the set of Key/Values that can be read from file and are
-// used to parametrize an object. It is up to the user's code to parse the string.
-typedef std::unordered_map<std::string, std::string> NodeParameters;
-
 typedef std::chrono::high_resolution_clock::time_point TimePoint;
 typedef std::chrono::high_resolution_clock::duration Duration;
 
+class TreeNode;
+
+/// The term "Builder" refers to the Builder Pattern (https://en.wikipedia.org/wiki/Builder_pattern)
+typedef std::function<std::unique_ptr<TreeNode>(const std::string&, const NodeParameters&)>
+    NodeBuilder;
+
 // Abstract base class for Behavior Tree Nodes
 class TreeNode
 {
@@ -58,7 +66,7 @@ class TreeNode
      * static const NodeParameters& requiredNodeParameters();
      */
     TreeNode(const std::string& name, const NodeParameters& parameters);
-    virtual ~TreeNode() = default;
+    virtual ~TreeNode();
 
     typedef std::shared_ptr<TreeNode> Ptr;
 
@@ -74,7 +82,8 @@ class TreeNode
 
     void setStatus(NodeStatus new_status);
 
-    void setBlackboard(const Blackboard::Ptr& bb);
+    /// Virtual, for the nodes that need to configure the blackboard they use.
+    virtual void setBlackboard(const Blackboard::Ptr& bb);
 
     const Blackboard::Ptr& blackboard() const;
 
@@ -101,7 +110,11 @@ class TreeNode
      */
     StatusChangeSubscriber subscribeToStatusChange(StatusChangeCallback callback);
 
-    // get an unique identifier of this instance of treeNode
+    /** Identifier of this node, unique in its Tree: the nodes of a tree built by
+     * XMLParser are numbered from 1, in the order of creation, and a clone has
+     * the same UIDs of the original. A node that doesn't belong to a tree has a
+     * UID unique among the nodes of the process in the same condition.
+     */
     uint16_t UID() const;
 
     /// registrationName is the ID used by BehaviorTreeFactory to create an instance.
@@ -114,7 +127,7 @@ class TreeNode
     /** Get a parameter from the NodeParameters and convert it to type T.
      */
     template <typename T>
-    BT::optional<T> getParam(const std::string& key) const
+    BT::optional<T> getParam(const StringView& key) const
     {
         T out;
         return getParam(key, out) ? std::move(out) : BT::nullopt;
@@ -124,11 +137,110 @@ class TreeNode
      *  Return false either if there is no parameter with this key or if conversion failed.
      */
     template <typename T>
-    bool getParam(const std::string& key, T& destination) const;
+    bool getParam(const StringView& key, T& destination) const;
 
     static bool isBlackboardPattern(StringView str);
 
+    /**
+     * @brief clone creates a new instance of this node, with the same name,
+     * NodeParameters and registrationName. Children, blackboard and UID
+     * are NOT copied: this is done by Tree::clone().
+     *
+     * The default implementation invokes again the builder of the BehaviorTreeFactory
+     * that created this node; that factory must still be alive.
+     * Override it if your node was not created by a factory or if you
+     * have a faster way to copy it.
+     */
+    virtual std::unique_ptr<TreeNode> clone() const;
+
+    /**
+     * @brief addTickMonitor attaches a TickMonitor to this node, next to the ones
+     * already attached; they are notified in the order they were added.
+     * The monitors are not copied by clone().
+     *
+     * executeTick() of the built-in nodes notifies them; a node overriding executeTick()
+     * must either call the executeTick() of its base class or use a MonitorScope.
+     *
+     * The ticks read the monitors without locks: a tick that started before
+     * removeTickMonitor() may still notify the monitor. The replaced lists of monitors
+     * (a few bytes for each add or remove) are freed with the node.
+     *
+     * @throw std::logic_error if the monitor is already attached.
+     */
+    void addTickMonitor(TickMonitor* monitor, size_t slot = 0);
+
+    /// Detach a monitor attached by addTickMonitor(); the others are left in place.
+    /// Return false if it was not attached.
+    bool removeTickMonitor(TickMonitor* monitor);
+
   protected:
+    struct AttachedMonitor
+    {
+        TickMonitor* monitor;
+        size_t slot;
+    };
+    typedef std::vector<AttachedMonitor> TickMonitorList;
+
+    /// Notifies the TickMonitors, if any, when it goes out of scope.
+    class MonitorScope
+    {
+      public:
+        /// async_work is true in the worker thread of an asynchronous node.
+        explicit MonitorScope(TreeNode& node, bool async_work = false)
+          : node_(node),
+            monitors_(node.tick_monitors_.load(std::memory_order_acquire)),
+            async_work_(async_work)
+        {
+            if (monitors_)
+            {
+                for (const auto& attached : *monitors_)
+                {
+                    attached.monitor->onTickStart(node_, attached.slot);
+                }
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~MonitorScope()
+        {
+            if (!monitors_)
+            {
+                return;
+            }
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            const NodeStatus status = node_.status();
+            for (const auto& attached : *monitors_)
+            {
+                if (async_work_)
+                {
+                    attached.monitor->onAsyncTick(node_, attached.slot, start_, elapsed, status);
+                }
+                else
+                {
+                    attached.monitor->onTick(node_, attached.slot, start_, elapsed, status);
+                }
+            }
+        }
+
+      private:
+        TreeNode& node_;
+        const TickMonitorList* monitors_;
+        bool async_work_;
+        TickMonitor::MonitorTime start_;
+    };
+
+    /// To be invoked by asynchronous nodes when executeTick() starts their work.
+    void notifyAsyncStart()
+    {
+        if (const TickMonitorList* monitors = tick_monitors_.load(std::memory_order_acquire))
+        {
+            for (const auto& attached : *monitors)
+            {
+                attached.monitor->onAsyncStart(*this, attached.slot);
+            }
+        }
+    }
+
     /// Method to be implemented by the user
     virtual BT::NodeStatus tick() = 0;
 
@@ -136,9 +248,17 @@ class TreeNode
     void setRegistrationName(const std::string& registration_name);
 
     friend class BehaviorTreeFactory;
+    friend class XMLParser;
+    friend struct Tree;
 
     void initializeOnce();
 
+    /// Release the UID of the process and use this one, unique in the tree.
+    void setTreeUID(uint16_t uid);
+
+    /// Number the nodes of a tree from 1. Throw BehaviorTreeException after 65535 nodes.
+    static void assignTreeUIDs(const std::vector<Ptr>& nodes);
+
   private:
 
     bool not_initialized_;
@@ -153,21 +273,35 @@ class TreeNode
 
     StatusChangeSignal state_change_signal_;
 
-    const uint16_t uid_;
+    uint16_t uid_;
+
+    // true while uid_ is taken from the UIDs of the process
+    bool owns_uid_;
 
     std::string registration_name_;
 
     const NodeParameters parameters_;
 
+    // builder used by BehaviorTreeFactory to create this instance (can be null)
+    const NodeBuilder* builder_;
+
     Blackboard::Ptr bb_;
 
+    // the attached monitors, null if none; a list is replaced, never modified
+    std::atomic<const TickMonitorList*> tick_monitors_;
+
+    // every list ever published: a running tick may still read a replaced one
+    std::vector<std::unique_ptr<const TickMonitorList>> tick_monitor_lists_;
+
+    std::mutex tick_monitors_mutex_;
+
 };
 
 //-------------------------------------------------------
 
 
 template <typename T> inline
-bool TreeNode::getParam(const std::string& key, T& destination) const
+bool TreeNode::getParam(const StringView& key, T& destination) const
 {
     auto it = parameters_.find(key);
     if (it == parameters_.end())
@@ -189,24 +323,32 @@ bool TreeNode::getParam(const std::string& key, T& destination) const
         // check if it follows this ${pattern}, if it does, search inside the blackboard
         if ( bb_pattern && blackboard() )
         {
-            const std::string stripped_key(&str[2], str.size() - 3);
+            // reused by the following calls: the key is not allocated at each tick
+            static thread_local std::string stripped_key;
+            stripped_key.assign(&str[2], str.size() - 3);
+            auto lock = blackboard()->lockIfThreadSafe();
             const SafeAny::Any* val = blackboard()->getAny(stripped_key);
             if( val )
             {
-                if( std::is_same<T,std::string>::value == false &&
-                    (val->type() == typeid (std::string) ||
-                     val->type() == typeid (SafeAny::SimpleString)))
+                const SafeAny::SimpleString* simple_str = val->asSimpleString();
+                if( std::is_same<T,std::string>::value == false && simple_str )
+                {
+                    convertFromString(StringView(simple_str->data(), simple_str->size()),
+                                      destination);
+                }
+                else if( std::is_same<T,std::string>::value == false &&
+                         val->type() == typeid (std::string) )
                 {
                     destination = convertFromString<T>(val->cast<std::string>());
                 }
                 else{
-                    destination = val->cast<T>();
+                    val->copyTo(destination);
                 }
             }
             return val != nullptr;
         }
         else{
-            destination = convertFromString<T>(str.c_str());
+            convertFromString(StringView(str), destination);
             return true;
         }
     }
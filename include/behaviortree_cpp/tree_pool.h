@@ -0,0 +1,67 @@
+#ifndef BT_TREE_POOL_H
+#define BT_TREE_POOL_H
+
+#include <memory>
+#include "behaviortree_cpp/xml_parsing.h"
+
+namespace BT
+{
+/**
+ * @brief TreePool recycles the trees created from the same XML.
+ *
+ * Building a tree requires parsing the XML and invoking the factory, while destroying it
+ * joins the threads of the AsyncActionNodes. When the same trees are created and
+ * destroyed many times, acquire them from a TreePool instead:
+ *
+ *     BT::TreePool pool(factory);
+ *     {
+ *         auto tree = pool.acquire(xml_text, blackboard);
+ *         tree->root_node->executeTick();
+ *     } // the tree goes back to the pool here
+ *
+ * The XML is parsed once, without holding the lock of the pool; new trees are
+ * created with Tree::clone(). If two threads request a new XML at the same time,
+ * both parse it and only the first result is kept.
+ *
+ * When a tree is released, running nodes are halted, and so are all the ControlNodes and
+ * DecoratorNodes, to clear the memory of nodes like SequenceStar, Retry or PolicyParallel:
+ * a control or decorator node that keeps a state between its executions must reset it
+ * in halt(). Leaves are halted only if they are RUNNING.
+ * The blackboard passed to acquire() is assigned to all the nodes only if it is
+ * different from the previous one.
+ *
+ * A tree may outlive the pool; in that case it is destroyed when released.
+ * The factory must outlive the pool and all its trees.
+ *
+ * This class is thread-safe.
+ */
+class TreePool
+{
+  public:
+    /**
+     * @param factory          used to instantiate a tree the first time an XML is requested.
+     * @param max_idle_trees   maximum number of idle trees kept for each XML.
+     */
+    TreePool(const BehaviorTreeFactory& factory, size_t max_idle_trees = 16);
+
+    ~TreePool();
+
+    TreePool(const TreePool& other) = delete;
+    TreePool& operator=(const TreePool& other) = delete;
+
+    /// Returns an IDLE tree. It goes back to the pool when the last copy of the pointer is destroyed.
+    std::shared_ptr<Tree> acquire(const std::string& xml_text, const Blackboard::Ptr& blackboard);
+
+    /// Number of idle trees, for all the XMLs.
+    size_t idleCount() const;
+
+    /// Destroy all the idle trees.
+    void clear();
+
+  private:
+    struct Pimpl;
+    std::shared_ptr<Pimpl> _p;
+};
+}
+
+#endif   // BT_TREE_POOL_H
@@ -44,12 +44,35 @@ struct Tree
 
     }
 
+    // Copying is not allowed: both copies would try to halt the same nodes.
+    Tree(Tree&& other) : root_node(other.root_node), nodes(std::move(other.nodes))
+    {
+        other.root_node = nullptr;
+    }
+
+    Tree& operator=(Tree&& other)
+    {
+        std::swap(root_node, other.root_node);
+        std::swap(nodes, other.nodes);
+        return *this;
+    }
+
     ~Tree()
     {
         if (root_node) {
             haltAllActions(root_node);
         }
     }
+
+    /** Create a deep copy of this tree, without parsing the XML again.
+     *
+     * Each node is duplicated using TreeNode::clone(); structure, names and
+     * NodeParameters are preserved, and so are the UIDs: they are unique within
+     * each tree (see TreeNode::UID()), hence the number of clones is unlimited.
+     *
+     * @param blackboard  the blackboard assigned to all the nodes of the new tree.
+     */
+    Tree clone(const Blackboard::Ptr& blackboard) const;
 };
 
 /** Helper function to do the most common steps all at once:
@@ -76,6 +99,19 @@ Tree buildTreeFromFile(const BehaviorTreeFactory& factory,
 
 std::string writeXML(const BehaviorTreeFactory& factory, const TreeNode* root_node,
                      bool compact_representation = false);
+
+/** Serialize the manifests of one or more plugins (see bt_plugin_manifest --cache).
+ */
+std::string writePluginManifestCache(const std::vector<PluginManifest>& plugins);
+
+/** Read a cache created by writePluginManifestCache and call
+ * BehaviorTreeFactory::registerDeferredPlugin for each plugin.
+ * No library is loaded until a tree that uses one of its nodes is instantiated.
+ *
+ * Relative paths of the plugins are relative to the folder of the cache.
+ * Plain library names (e.g. "libfoo.so") are searched by the dynamic linker.
+ */
+void registerFromManifestCache(BehaviorTreeFactory& factory, const std::string& filename);
 }
 
 #endif   // XML_PARSING_BT_H
@@ -23,6 +23,7 @@ ActionNodeBase::ActionNodeBase(const std::string& name, const NodeParameters& pa
 
 NodeStatus ActionNodeBase::executeTick()
 {
+    MonitorScope monitor_scope(*this);
     initializeOnce();
     NodeStatus prev_status = status();
 
@@ -86,6 +87,7 @@ void AsyncActionNode::waitForTick()
         // notified from the method stopAndJoinThread
         if (loop_ && status() == NodeStatus::IDLE)
         {
+            MonitorScope monitor_scope(*this, true);
             setStatus(NodeStatus::RUNNING);
             setStatus(tick());
         }
@@ -94,11 +96,13 @@ void AsyncActionNode::waitForTick()
 
 NodeStatus AsyncActionNode::executeTick()
 {
+    MonitorScope monitor_scope(*this);
     initializeOnce();
     //send signal to other thread.
     // The other thread is in charge for changing the status
     if (status() == NodeStatus::IDLE)
     {
+        notifyAsyncStart();
         tick_engine_.notify();
     }
 
@@ -117,6 +121,11 @@ void AsyncActionNode::stopAndJoinThread()
     }
 }
 
+std::thread::native_handle_type AsyncActionNode::threadHandle()
+{
+    return thread_.native_handle();
+}
+
 //-------------------------------------
 struct CoroActionNode::Pimpl
 {
@@ -145,6 +154,7 @@ void CoroActionNode::setStatusRunningAndYield()
 
 NodeStatus CoroActionNode::executeTick()
 {
+    MonitorScope monitor_scope(*this);
     initializeOnce();
     if (status() == NodeStatus::IDLE)
     {
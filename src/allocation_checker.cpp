@@ -0,0 +1,180 @@
+#include "behaviortree_cpp/allocation_checker.h"
+#include "behaviortree_cpp/behavior_tree.h"
+#include "behaviortree_cpp/blackboard/demangle_util.h"
+
+#ifdef __linux__
+#include <execinfo.h>
+#endif
+
+namespace BT
+{
+namespace
+{
+// Deeper nodes are attributed to their ancestor at this depth.
+const int MAX_DEPTH = 128;
+
+// The nodes being ticked by this thread; trivially constructed, to be safe
+// to use in operator new.
+struct ThreadState
+{
+    AllocationChecker* checker;
+    const TreeNode* stack[MAX_DEPTH];
+    int depth;
+    bool inside_hook;
+};
+
+thread_local ThreadState thread_state;
+
+// frames of notifyAllocation() and operator new
+const int SKIPPED_FRAMES = 2;
+
+// "./binary(_ZN2BT6Action4tickEv+0x1a) [0x55d0c]" -> "./binary(BT::Action::tick()+0x1a) [0x55d0c]"
+std::string demangleFrame(const std::string& frame)
+{
+    const size_t begin = frame.find('(');
+    const size_t end = frame.find('+', begin);
+    if (begin == std::string::npos || end == std::string::npos || end == begin + 1)
+    {
+        return frame;
+    }
+    const std::string mangled = frame.substr(begin + 1, end - begin - 1);
+    return frame.substr(0, begin + 1) + demangle(mangled.c_str()) + frame.substr(end);
+}
+}
+
+AllocationChecker::AllocationChecker(TreeNode* root_node, size_t max_records) : count_(0)
+{
+    records_.reserve(max_records);
+#ifdef __linux__
+    // the first invocation loads libgcc, and allocates
+    void* frames[MAX_FRAMES];
+    backtrace(frames, MAX_FRAMES);
+#endif
+    applyRecursiveVisitor(root_node, [this](TreeNode* node) { nodes_.push_back(node); });
+    for (TreeNode* node : nodes_)
+    {
+        node->addTickMonitor(this);
+    }
+}
+
+AllocationChecker::~AllocationChecker()
+{
+    for (TreeNode* node : nodes_)
+    {
+        node->removeTickMonitor(this);
+    }
+}
+
+void AllocationChecker::onTickStart(const TreeNode& node, size_t)
+{
+    ThreadState& state = thread_state;
+    if (state.depth == 0)
+    {
+        state.checker = this;
+    }
+    if (state.depth < MAX_DEPTH)
+    {
+        state.stack[state.depth] = &node;
+    }
+    state.depth++;
+}
+
+void AllocationChecker::onTick(const TreeNode&, size_t, MonitorTime, std::chrono::nanoseconds,
+                               NodeStatus)
+{
+    ThreadState& state = thread_state;
+    if (--state.depth == 0)
+    {
+        state.checker = nullptr;
+    }
+}
+
+void AllocationChecker::onAsyncTick(const TreeNode& node, size_t slot, MonitorTime start,
+                                    std::chrono::nanoseconds elapsed, NodeStatus status)
+{
+    onTick(node, slot, start, elapsed, status);
+}
+
+void AllocationChecker::notifyAllocation(size_t size) noexcept
+{
+    ThreadState& state = thread_state;
+    if (!state.checker || state.inside_hook)
+    {
+        return;
+    }
+    state.inside_hook = true;
+    const int depth = std::min(state.depth, MAX_DEPTH);
+    state.checker->record(depth > 0 ? state.stack[depth - 1] : nullptr, size);
+    state.inside_hook = false;
+}
+
+void AllocationChecker::record(const TreeNode* node, size_t size) noexcept
+{
+    count_++;
+    std::lock_guard<std::mutex> lock(records_mutex_);
+    if (records_.size() == records_.capacity())
+    {
+        return;
+    }
+    Allocation allocation;
+    allocation.node = node;
+    allocation.size = size;
+#ifdef __linux__
+    allocation.num_frames = backtrace(allocation.frames, MAX_FRAMES);
+#else
+    allocation.num_frames = 0;
+#endif
+    records_.push_back(allocation);
+}
+
+uint64_t AllocationChecker::count() const
+{
+    return count_.load();
+}
+
+std::vector<AllocationChecker::Allocation> AllocationChecker::allocations() const
+{
+    std::lock_guard<std::mutex> lock(records_mutex_);
+    return records_;
+}
+
+void AllocationChecker::reset()
+{
+    std::lock_guard<std::mutex> lock(records_mutex_);
+    records_.clear();
+    count_ = 0;
+}
+
+void AllocationChecker::dumpReport(std::ostream& os) const
+{
+    const std::vector<Allocation> records = allocations();
+    os << count() << " allocations while ticking";
+    if (records.size() < count())
+    {
+        os << ", the first " << records.size() << " recorded";
+    }
+    os << "\n";
+
+    for (const Allocation& allocation : records)
+    {
+        os << allocation.size << " bytes, ticking ";
+        if (allocation.node)
+        {
+            os << "[" << allocation.node->name() << "] ("
+               << allocation.node->registrationName() << ")\n";
+        }
+        else
+        {
+            os << "an unknown node\n";
+        }
+#ifdef __linux__
+        char** symbols = backtrace_symbols(allocation.frames, allocation.num_frames);
+        for (int i = SKIPPED_FRAMES; symbols && i < allocation.num_frames; i++)
+        {
+            os << "    " << demangleFrame(symbols[i]) << "\n";
+        }
+        std::free(symbols);
+#endif
+    }
+}
+}
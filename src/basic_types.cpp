@@ -1,6 +1,9 @@
 #include "behaviortree_cpp/basic_types.h"
+#include <cerrno>
+#include <climits>
 #include <cstdlib>
 #include <cstring>
+#include <stdexcept>
 
 namespace BT
 {
@@ -76,22 +79,52 @@ const char* convertFromString<const char*>(const StringView& str)
     return str.to_string().c_str();
 }
 
+// std::stoi and similar copy their input into a std::string.
+// This throws the same exceptions, after the parsing in place with strtol() and similar.
+static void checkParsedNumber(const char* function, const char* begin, const char* end)
+{
+    if (end == begin)
+    {
+        throw std::invalid_argument(function);
+    }
+    if (errno == ERANGE)
+    {
+        throw std::out_of_range(function);
+    }
+}
+
 template <>
 int convertFromString<int>(const StringView& str)
 {
-    return  std::stoi(str.data());
+    char* end;
+    errno = 0;
+    const long value = std::strtol(str.data(), &end, 10);
+    checkParsedNumber("stoi", str.data(), end);
+    if (value < INT_MIN || value > INT_MAX)
+    {
+        throw std::out_of_range("stoi");
+    }
+    return static_cast<int>(value);
 }
 
 template <>
 unsigned convertFromString<unsigned>(const StringView& str)
 {
-    return std::stoul(str.data());
+    char* end;
+    errno = 0;
+    const unsigned long value = std::strtoul(str.data(), &end, 10);
+    checkParsedNumber("stoul", str.data(), end);
+    return static_cast<unsigned>(value);
 }
 
 template <>
 double convertFromString<double>(const StringView& str)
 {
-    return std::stod(str.data());
+    char* end;
+    errno = 0;
+    const double value = std::strtod(str.data(), &end);
+    checkParsedNumber("stod", str.data(), end);
+    return value;
 }
 
 template <>
@@ -195,6 +228,36 @@ NodeType convertFromString<NodeType>(const StringView& str)
     throw std::invalid_argument(std::string("Cannot convert this to NodeType: ") + str.to_string());
 }
 
+template <>
+FailurePolicy convertFromString<FailurePolicy>(const StringView& str)
+{
+    if (str == "FAIL_ON_ONE")
+    {
+        return FAIL_ON_ONE;
+    }
+    if (str == "FAIL_ON_ALL")
+    {
+        return FAIL_ON_ALL;
+    }
+    throw std::invalid_argument(std::string("Cannot convert this to FailurePolicy: ") +
+                                str.to_string());
+}
+
+template <>
+SuccessPolicy convertFromString<SuccessPolicy>(const StringView& str)
+{
+    if (str == "SUCCEED_ON_ONE")
+    {
+        return SUCCEED_ON_ONE;
+    }
+    if (str == "SUCCEED_ON_ALL")
+    {
+        return SUCCEED_ON_ALL;
+    }
+    throw std::invalid_argument(std::string("Cannot convert this to SuccessPolicy: ") +
+                                str.to_string());
+}
+
 std::ostream& operator<<(std::ostream& os, const NodeType& type)
 {
     os << toStr(type);
@@ -10,18 +10,37 @@
 *   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <future>
 #include "behaviortree_cpp/bt_factory.h"
 #include "behaviortree_cpp/shared_library.h"
 
 namespace BT
 {
-BehaviorTreeFactory::BehaviorTreeFactory()
+typedef void (*RegisterPluginFunc)(BehaviorTreeFactory&);
+
+// Load the library and return its registration function (nullptr if not found)
+static RegisterPluginFunc loadPlugin(const std::string& file_path)
+{
+    BT::SharedLibrary loader;
+    loader.load(file_path);
+
+    if (loader.hasSymbol(PLUGIN_SYMBOL))
+    {
+        return (RegisterPluginFunc)loader.getSymbol(PLUGIN_SYMBOL);
+    }
+    std::cout << "ERROR loading library [" << file_path << "]: can't find symbol ["
+              << PLUGIN_SYMBOL << "]" << std::endl;
+    return nullptr;
+}
+
+BehaviorTreeFactory::BehaviorTreeFactory() : manifests_sorted_(true)
 {
     registerNodeType<FallbackNode>("Fallback");
     registerNodeType<FallbackStarNode>("FallbackStar");
     registerNodeType<SequenceNode>("Sequence");
     registerNodeType<SequenceStarNode>("SequenceStar");
     registerNodeType<ParallelNode>("ParallelNode");
+    registerNodeType<PolicyParallelNode>("PolicyParallel");
 
     registerNodeType<InverterNode>("Inverter");
     registerNodeType<RetryNode>("RetryUntilSuccesful");
@@ -49,6 +68,7 @@ BehaviorTreeFactory::BehaviorTreeFactory()
 
 bool BehaviorTreeFactory::unregisterBuilder(const std::string& ID)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     auto it = builders_.find(ID);
     if (it == builders_.end())
     {
@@ -59,6 +79,13 @@ bool BehaviorTreeFactory::unregisterBuilder(const std::string& ID)
 }
 
 void BehaviorTreeFactory::registerBuilder(const TreeNodeManifest& manifest, NodeBuilder builder)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    registerBuilderLocked(manifest, std::move(builder));
+}
+
+void BehaviorTreeFactory::registerBuilderLocked(const TreeNodeManifest& manifest,
+                                                NodeBuilder builder) const
 {
     auto it = builders_.find( manifest.registration_ID);
     if (it != builders_.end())
@@ -66,9 +93,25 @@ void BehaviorTreeFactory::registerBuilder(const TreeNodeManifest& manifest, Node
         throw BehaviorTreeException("ID '" + manifest.registration_ID + "' already registered");
     }
 
-    builders_.insert(std::make_pair(manifest.registration_ID, builder));
-    manifests_.push_back(manifest);
-    sortTreeNodeManifests();
+    builders_.insert(std::make_pair(manifest.registration_ID, std::move(builder)));
+
+    if (deferred_IDs_.erase(manifest.registration_ID) != 0)
+    {
+        // the manifest was already declared by registerDeferredPlugin. Replace it.
+        for (auto& declared : manifests_)
+        {
+            if (declared.registration_ID == manifest.registration_ID)
+            {
+                declared = manifest;
+                break;
+            }
+        }
+    }
+    else
+    {
+        manifests_.push_back(manifest);
+        manifests_sorted_ = false;
+    }
 }
 
 void BehaviorTreeFactory::registerSimpleCondition(
@@ -106,52 +149,143 @@ void BehaviorTreeFactory::registerSimpleDecorator(
 
 void BehaviorTreeFactory::registerFromPlugin(const std::string file_path)
 {
-    BT::SharedLibrary loader;
-    loader.load(file_path);
-    typedef void (*Func)(BehaviorTreeFactory&);
-
-    if (loader.hasSymbol(PLUGIN_SYMBOL))
+    RegisterPluginFunc func = loadPlugin(file_path);
+    if (func)
     {
-        Func func = (Func)loader.getSymbol(PLUGIN_SYMBOL);
         func(*this);
     }
-    else
+}
+
+void BehaviorTreeFactory::registerDeferredPlugin(const PluginManifest& plugin)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& manifest : plugin.manifests)
+    {
+        if (builders_.count(manifest.registration_ID) != 0 ||
+            deferred_IDs_.count(manifest.registration_ID) != 0)
+        {
+            throw BehaviorTreeException("ID '" + manifest.registration_ID +
+                                        "' already registered");
+        }
+    }
+    for (const auto& manifest : plugin.manifests)
+    {
+        deferred_IDs_.insert(std::make_pair(manifest.registration_ID, plugin.path));
+        manifests_.push_back(manifest);
+    }
+    manifests_sorted_ = false;
+}
+
+void BehaviorTreeFactory::loadPluginsFor(const std::set<std::string>& IDs) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<std::string> paths;
+    for (const auto& ID : IDs)
+    {
+        auto it = deferred_IDs_.find(ID);
+        if (it != deferred_IDs_.end() &&
+            std::find(paths.begin(), paths.end(), it->second) == paths.end())
+        {
+            paths.push_back(it->second);
+        }
+    }
+    if (paths.empty())
+    {
+        return;
+    }
+
+    // Most of the time is spent by dlopen (relocations and static initialization).
+    std::vector<std::future<RegisterPluginFunc>> loaded;
+    loaded.reserve(paths.size());
+    for (const auto& path : paths)
+    {
+        loaded.push_back(std::async(std::launch::async, loadPlugin, path));
+    }
+
+    // The registration functions need a mutable factory: each one fills a temporary
+    // factory, whose builders are moved here. The manifests don't change, they were
+    // declared by registerDeferredPlugin.
+    for (size_t i = 0; i < paths.size(); i++)
     {
-        std::cout << "ERROR loading library [" << file_path << "]: can't find symbol ["
-                  << PLUGIN_SYMBOL << "]" << std::endl;
+        RegisterPluginFunc func = loaded[i].get();
+        if (func)
+        {
+            BehaviorTreeFactory plugin_factory;
+            func(plugin_factory);
+            for (const auto& manifest : plugin_factory.manifests_)
+            {
+                if (plugin_factory.builtin_IDs_.count(manifest.registration_ID) == 0)
+                {
+                    registerBuilderLocked(
+                        manifest, std::move(plugin_factory.builders_[manifest.registration_ID]));
+                }
+            }
+        }
+        // don't try again to load IDs that the plugin didn't register
+        for (auto it = deferred_IDs_.begin(); it != deferred_IDs_.end();)
+        {
+            if (it->second == paths[i])
+            {
+                it = deferred_IDs_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
     }
 }
 
+bool BehaviorTreeFactory::hasDeferredPlugins() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !deferred_IDs_.empty();
+}
+
 std::unique_ptr<TreeNode> BehaviorTreeFactory::instantiateTreeNode(
         const std::string& ID, const std::string& name,
         const NodeParameters& params,
         const Blackboard::Ptr& blackboard) const
 {
-    auto it = builders_.find(ID);
-    if (it == builders_.end())
+    const NodeBuilder* builder = nullptr;
     {
-        std::cerr << ID << " not included in this list:" << std::endl;
-        for (const auto& it: builders_)
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = builders_.find(ID);
+        if (it == builders_.end())
         {
-            std::cerr << it.first << std::endl;
+            std::cerr << ID << " not included in this list:" << std::endl;
+            for (const auto& it: builders_)
+            {
+                std::cerr << it.first << std::endl;
+            }
+            throw std::invalid_argument("ID '" + ID + "' not registered");
         }
-        throw std::invalid_argument("ID '" + ID + "' not registered");
+        // the address is stable: the node is built without holding the lock
+        builder = &it->second;
     }
-    std::unique_ptr<TreeNode> node = it->second(name, params);
+    std::unique_ptr<TreeNode> node = (*builder)(name, params);
     node->setRegistrationName(ID);
+    node->builder_ = builder;
     node->setBlackboard(blackboard);
     node->initializeOnce();
 
     return node;
 }
 
-const std::map<std::string, NodeBuilder>& BehaviorTreeFactory::builders() const
+const std::unordered_map<std::string, NodeBuilder>& BehaviorTreeFactory::builders() const
 {
     return builders_;
 }
 
-const std::vector<TreeNodeManifest>& BehaviorTreeFactory::manifests() const
+std::vector<TreeNodeManifest> BehaviorTreeFactory::manifests() const
 {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!manifests_sorted_)
+    {
+        sortTreeNodeManifests();
+        manifests_sorted_ = true;
+    }
     return manifests_;
 }
 
@@ -160,7 +294,7 @@ const std::set<std::string> &BehaviorTreeFactory::builtinNodes() const
     return builtin_IDs_;
 }
 
-void BehaviorTreeFactory::sortTreeNodeManifests()
+void BehaviorTreeFactory::sortTreeNodeManifests() const
 {
     std::sort(manifests_.begin(), manifests_.end(),
               [](const TreeNodeManifest& a, const TreeNodeManifest& b) {
@@ -12,16 +12,177 @@
 */
 
 #include "behaviortree_cpp/controls/parallel_node.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace BT
 {
 
 constexpr const char* ParallelNode::THRESHOLD_KEY;
+constexpr const char* ParallelNode::CONCURRENT_KEY;
+
+namespace
+{
+// the thread on whose behalf this one ticks a child, if any
+thread_local std::thread::id ticking_for;
+
+// Ticks the children of the concurrent ParallelNodes. A thread waiting for its
+// children ticks the ones still queued meanwhile, never the tasks of other nodes:
+// it never waits for a queued task, hence nested ParallelNodes can't deadlock.
+class ChildTaskPool
+{
+  public:
+    typedef ParallelNode::ChildTask Task;
+
+    static ChildTaskPool& instance()
+    {
+        static ChildTaskPool pool;
+        return pool;
+    }
+
+    // Tick tasks[0] in the calling thread, the others in the pool; return when all are done.
+    void run(std::vector<Task>& tasks)
+    {
+        unsigned remaining = static_cast<unsigned>(tasks.size()) - 1;
+        const std::thread::id tick_thread = ParallelNode::tickThreadId();
+        tasks[0].tick_thread = tick_thread;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 1; i < tasks.size(); i++)
+            {
+                tasks[i].remaining = &remaining;
+                tasks[i].tick_thread = tick_thread;
+                queue_.push_back(&tasks[i]);
+            }
+        }
+        changed_.notify_all();
+
+        execute(tasks[0]);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (remaining > 0)
+        {
+            if (!runOwn(lock, &remaining))
+            {
+                changed_.wait(lock);
+            }
+        }
+    }
+
+  private:
+    ChildTaskPool() : head_(0), stop_(false)
+    {
+        queue_.reserve(256);
+        const unsigned count = std::max(2u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < count; i++)
+        {
+            threads_.emplace_back([this]() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!stop_)
+                {
+                    if (!runOne(lock))
+                    {
+                        changed_.wait(lock);
+                    }
+                }
+            });
+        }
+    }
+
+    ~ChildTaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        changed_.notify_all();
+        for (auto& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    static void execute(Task& task)
+    {
+        const std::thread::id previous = ticking_for;
+        ticking_for = task.tick_thread;
+        try
+        {
+            task.status = task.child->executeTick();
+        }
+        catch (...)
+        {
+            task.error = std::current_exception();
+        }
+        ticking_for = previous;
+    }
+
+    // Pop a task and execute it, releasing the lock meanwhile.
+    bool runOne(std::unique_lock<std::mutex>& lock)
+    {
+        while (head_ < queue_.size() && !queue_[head_])
+        {
+            head_++;
+        }
+        if (head_ == queue_.size())
+        {
+            queue_.clear();
+            head_ = 0;
+            return false;
+        }
+        runAt(lock, head_++);
+        return true;
+    }
+
+    // Execute a queued task of the batch counted by (remaining), if any.
+    bool runOwn(std::unique_lock<std::mutex>& lock, unsigned* remaining)
+    {
+        for (size_t i = head_; i < queue_.size(); i++)
+        {
+            if (queue_[i] && queue_[i]->remaining == remaining)
+            {
+                runAt(lock, i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void runAt(std::unique_lock<std::mutex>& lock, size_t index)
+    {
+        Task* task = queue_[index];
+        // taken from the middle by runOwn(): skipped by runOne()
+        queue_[index] = nullptr;
+        if (index + 1 == queue_.size() && index + 1 == head_)
+        {
+            // the capacity is kept
+            queue_.clear();
+            head_ = 0;
+        }
+        lock.unlock();
+        execute(*task);
+        lock.lock();
+        // the mutex makes the effects of the tick visible to the waiting thread
+        (*task->remaining)--;
+        changed_.notify_all();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<Task*> queue_;
+    size_t head_;
+    bool stop_;
+    std::vector<std::thread> threads_;
+};
+}
 
 ParallelNode::ParallelNode(const std::string& name, int threshold)
   : ControlNode::ControlNode(name, {{THRESHOLD_KEY, std::to_string(threshold)}}),
     threshold_(threshold),
-    read_parameter_from_blackboard_(false)
+    read_parameter_from_blackboard_(false),
+    concurrent_(false)
 {
     setRegistrationName("Parallel");
 }
@@ -29,8 +190,13 @@ ParallelNode::ParallelNode(const std::string& name, int threshold)
 ParallelNode::ParallelNode(const std::string &name,
                                const NodeParameters &params)
     : ControlNode::ControlNode(name, params),
-      read_parameter_from_blackboard_(false)
+      read_parameter_from_blackboard_(false),
+      concurrent_(false)
 {
+    if (params.find(CONCURRENT_KEY) != params.end() && !getParam(CONCURRENT_KEY, concurrent_))
+    {
+        throw std::runtime_error("Invalid parameter [concurrent] in ParallelNode");
+    }
     read_parameter_from_blackboard_ = isBlackboardPattern( params.at(THRESHOLD_KEY) );
     if(!read_parameter_from_blackboard_)
     {
@@ -56,12 +222,19 @@ NodeStatus ParallelNode::tick()
     // Vector size initialization. children_count_ could change at runtime if you edit the tree
     const unsigned children_count = children_nodes_.size();
 
+    if (concurrent_ && children_count > 1)
+    {
+        tickConcurrently();
+    }
+
     // Routing the tree according to the sequence node's logic:
     for (unsigned int i = 0; i < children_count; i++)
     {
         TreeNode* child_node = children_nodes_[i];
 
-        NodeStatus child_status = child_node->executeTick();
+        NodeStatus child_status = (concurrent_ && children_count > 1) ?
+                                      tasks_[i].status :
+                                      child_node->executeTick();
 
         switch (child_status)
         {
@@ -104,6 +277,59 @@ void ParallelNode::halt()
     ControlNode::halt();
 }
 
+void ParallelNode::tickConcurrently()
+{
+    tasks_.resize(children_nodes_.size());
+    for (size_t i = 0; i < tasks_.size(); i++)
+    {
+        tasks_[i].child = children_nodes_[i];
+        tasks_[i].status = NodeStatus::IDLE;
+        tasks_[i].error = nullptr;
+    }
+    ChildTaskPool::instance().run(tasks_);
+
+    for (auto& task : tasks_)
+    {
+        if (task.error)
+        {
+            haltChildren(0);
+            std::rethrow_exception(task.error);
+        }
+    }
+}
+
+std::thread::id ParallelNode::tickThreadId()
+{
+    return ticking_for != std::thread::id() ? ticking_for : std::this_thread::get_id();
+}
+
+bool ParallelNode::isConcurrent() const
+{
+    return concurrent_;
+}
+
+void ParallelNode::setConcurrent(bool concurrent)
+{
+    concurrent_ = concurrent;
+    makeBlackboardThreadSafe();
+}
+
+void ParallelNode::setBlackboard(const Blackboard::Ptr& bb)
+{
+    ControlNode::setBlackboard(bb);
+    concurrent_blackboard_ = bb;
+    makeBlackboardThreadSafe();
+}
+
+void ParallelNode::makeBlackboardThreadSafe()
+{
+    // before the children can access it from the threads of the pool
+    if (concurrent_ && concurrent_blackboard_ && !concurrent_blackboard_->isThreadSafe())
+    {
+        concurrent_blackboard_->setThreadSafe(true);
+    }
+}
+
 unsigned int ParallelNode::thresholdM()
 {
     return threshold_;
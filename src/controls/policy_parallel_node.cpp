@@ -0,0 +1,171 @@
+/*  Copyright (C) 2018-2019 Davide Faconti -  All Rights Reserved
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+*   to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*   and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*   WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "behaviortree_cpp/controls/policy_parallel_node.h"
+
+namespace BT
+{
+
+constexpr const char* PolicyParallelNode::SUCCESS_POLICY_KEY;
+constexpr const char* PolicyParallelNode::FAILURE_POLICY_KEY;
+
+PolicyParallelNode::PolicyParallelNode(const std::string& name, SuccessPolicy success_policy,
+                                       FailurePolicy failure_policy)
+  : ControlNode::ControlNode(
+        name, {{SUCCESS_POLICY_KEY,
+                success_policy == SUCCEED_ON_ONE ? "SUCCEED_ON_ONE" : "SUCCEED_ON_ALL"},
+               {FAILURE_POLICY_KEY, failure_policy == FAIL_ON_ONE ? "FAIL_ON_ONE" : "FAIL_ON_ALL"}})
+  , success_policy_(success_policy)
+  , failure_policy_(failure_policy)
+  , read_parameter_from_blackboard_(false)
+  , success_count_(0)
+  , failure_count_(0)
+{
+    setRegistrationName("PolicyParallel");
+}
+
+PolicyParallelNode::PolicyParallelNode(const std::string& name, const NodeParameters& params)
+  : ControlNode::ControlNode(name, params)
+  , success_policy_(SUCCEED_ON_ALL)
+  , failure_policy_(FAIL_ON_ONE)
+  , read_parameter_from_blackboard_(false)
+  , success_count_(0)
+  , failure_count_(0)
+{
+    for (const char* key : {SUCCESS_POLICY_KEY, FAILURE_POLICY_KEY})
+    {
+        auto it = params.find(key);
+        if (it != params.end() && isBlackboardPattern(it->second))
+        {
+            read_parameter_from_blackboard_ = true;
+        }
+    }
+    if (!read_parameter_from_blackboard_)
+    {
+        readPolicies();
+    }
+}
+
+void PolicyParallelNode::readPolicies()
+{
+    // a parameter that is not given keeps its default
+    const NodeParameters& params = initializationParameters();
+    if (params.find(SUCCESS_POLICY_KEY) != params.end() &&
+        !getParam(SUCCESS_POLICY_KEY, success_policy_))
+    {
+        throw std::runtime_error("Missing parameter [success_policy] in PolicyParallelNode");
+    }
+    if (params.find(FAILURE_POLICY_KEY) != params.end() &&
+        !getParam(FAILURE_POLICY_KEY, failure_policy_))
+    {
+        throw std::runtime_error("Missing parameter [failure_policy] in PolicyParallelNode");
+    }
+}
+
+NodeStatus PolicyParallelNode::tick()
+{
+    const unsigned children_count = children_nodes_.size();
+
+    // a new execution: the previous one completed, or was halted
+    if (status() != NodeStatus::RUNNING || completed_.size() != children_count)
+    {
+        if (read_parameter_from_blackboard_)
+        {
+            readPolicies();
+        }
+        resetCompletion();
+    }
+
+    for (unsigned i = 0; i < children_count; i++)
+    {
+        if (completed_[i])
+        {
+            continue;
+        }
+        TreeNode* child_node = children_nodes_[i];
+        const NodeStatus child_status = child_node->executeTick();
+
+        switch (child_status)
+        {
+            case NodeStatus::SUCCESS:
+                completed_[i] = true;
+                succeeded_[i] = true;
+                child_node->setStatus(NodeStatus::IDLE);
+                if (++success_count_ == children_count || success_policy_ == SUCCEED_ON_ONE)
+                {
+                    return complete(NodeStatus::SUCCESS);
+                }
+                break;
+            case NodeStatus::FAILURE:
+                completed_[i] = true;
+                child_node->setStatus(NodeStatus::IDLE);
+                if (++failure_count_ == children_count || failure_policy_ == FAIL_ON_ONE)
+                {
+                    return complete(NodeStatus::FAILURE);
+                }
+                break;
+            case NodeStatus::RUNNING:
+                setStatus(NodeStatus::RUNNING);
+                break;
+            case NodeStatus::IDLE:
+                throw std::runtime_error("This is not supposed to happen");
+        }
+    }
+
+    // all completed, but neither policy was met: SUCCEED_ON_ALL with FAIL_ON_ALL
+    if (success_count_ + failure_count_ == children_count)
+    {
+        return complete(NodeStatus::FAILURE);
+    }
+    return NodeStatus::RUNNING;
+}
+
+NodeStatus PolicyParallelNode::complete(NodeStatus status)
+{
+    // the outcomes are kept until the next execution
+    haltChildren(0);
+    return status;
+}
+
+void PolicyParallelNode::resetCompletion()
+{
+    completed_.assign(children_nodes_.size(), false);
+    succeeded_.assign(children_nodes_.size(), false);
+    success_count_ = 0;
+    failure_count_ = 0;
+}
+
+SuccessPolicy PolicyParallelNode::successPolicy() const
+{
+    return success_policy_;
+}
+
+FailurePolicy PolicyParallelNode::failurePolicy() const
+{
+    return failure_policy_;
+}
+
+NodeStatus PolicyParallelNode::childStatus(size_t index) const
+{
+    if (index < completed_.size() && completed_[index])
+    {
+        return succeeded_[index] ? NodeStatus::SUCCESS : NodeStatus::FAILURE;
+    }
+    return children_nodes_.at(index)->status();
+}
+
+unsigned PolicyParallelNode::completedCount() const
+{
+    return success_count_ + failure_count_;
+}
+
+}
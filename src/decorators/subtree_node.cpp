@@ -17,3 +17,8 @@ BT::NodeStatus BT::DecoratorSubtreeNode::tick()
     return child_node_->executeTick();
 }
 
+
+std::unique_ptr<BT::TreeNode> BT::DecoratorSubtreeNode::clone() const
+{
+    return std::unique_ptr<TreeNode>( new DecoratorSubtreeNode(name()) );
+}
@@ -55,6 +55,7 @@ NodeStatus TimeoutNode::tick()
                 {
                     child()->halt();
                     child_halted_ = true;
+                    expiry_signal_.notify(*this);
                 }
             });
         }
@@ -1,20 +1,21 @@
 #include "behaviortree_cpp/loggers/bt_cout_logger.h"
+#include <mutex>
 
 namespace BT
 {
-std::atomic<bool> StdCoutLogger::ref_count(false);
+// shared by all the instances
+static std::mutex& coutMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
 
 StdCoutLogger::StdCoutLogger(TreeNode* root_node) : StatusChangeLogger(root_node)
 {
-    bool expected = false;
-    if (!ref_count.compare_exchange_strong(expected, true))
-    {
-        throw std::logic_error("Only one instance of StdCoutLogger shall be created");
-    }
 }
+
 StdCoutLogger::~StdCoutLogger()
 {
-    ref_count.store(false);
 }
 
 void StdCoutLogger::callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
@@ -26,6 +27,7 @@ void StdCoutLogger::callback(Duration timestamp, const TreeNode& node, NodeStatu
     constexpr const size_t ws_count = 25;
 
     double since_epoch = duration<double>(timestamp).count();
+    std::lock_guard<std::mutex> lock(coutMutex());
     printf("[%.3f]: %s%s %s -> %s", since_epoch, node.name().c_str(),
            &whitespaces[std::min(ws_count, node.name().size())], toStr(prev_status, true),
            toStr(status, true));
@@ -34,8 +36,8 @@ void StdCoutLogger::callback(Duration timestamp, const TreeNode& node, NodeStatu
 
 void StdCoutLogger::flush()
 {
+    std::lock_guard<std::mutex> lock(coutMutex());
     std::cout << std::flush;
-	ref_count = false;
 }
 
 }   // end namespace
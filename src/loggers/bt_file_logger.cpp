@@ -1,14 +1,42 @@
+#include <cstdio>
+#include <stdexcept>
 #include "behaviortree_cpp/loggers/bt_file_logger.h"
 #include "behaviortree_cpp/loggers/bt_flatbuffer_helper.h"
 
 namespace BT
 {
-FileLogger::FileLogger(BT::TreeNode* root_node, const char* filename, uint16_t buffer_size)
-  : StatusChangeLogger(root_node), buffer_max_size_(buffer_size)
+FileLogger::FileLogger(BT::TreeNode* root_node, const char* filename, size_t buffer_size)
+  : FileLogger(root_node, filename, FileLoggerOptions(buffer_size))
 {
-    if (buffer_max_size_ != 0)
+}
+
+FileLogger::FileLogger(TreeNode* root_node, const char* filename, const FileLoggerOptions& options)
+  : StatusChangeLogger(root_node),
+    filename_(filename),
+    options_(options),
+    encoder_(options.compress),
+    file_size_(0),
+    async_capacity_(std::max<size_t>(options.async_capacity, 1)),
+    dropped_(0),
+    stop_writer_(false),
+    flush_requested_(0),
+    flush_done_(0)
+{
+    if (options_.max_files == 0 &&
+        (options_.max_file_size != 0 || options_.max_file_age.count() != 0))
+    {
+        throw std::invalid_argument("FileLogger: max_files must be at least 1 when "
+                                    "max_file_size or max_file_age is set");
+    }
+    if (options_.async)
+    {
+        // callback() never allocates
+        buffer_.reserve(async_capacity_);
+        write_buffer_.reserve(async_capacity_);
+    }
+    else if (options_.buffer_size != 0)
     {
-        buffer_.reserve(buffer_max_size_);
+        buffer_.reserve(options_.buffer_size);
     }
 
     enableTransitionToIdle(true);
@@ -16,20 +44,36 @@ FileLogger::FileLogger(BT::TreeNode* root_node, const char* filename, uint16_t b
     flatbuffers::FlatBufferBuilder builder(1024);
     CreateFlatbuffersBehaviorTree(builder, root_node);
 
-    //-------------------------------------
-
-    file_os_.open(filename, std::ofstream::binary | std::ofstream::out);
-
+    if (options_.format == FileLogFormat::V2)
+    {
+        header_.assign(LOG_V2_MAGIC, LOG_V2_MAGIC + sizeof(LOG_V2_MAGIC));
+    }
     // serialize the length of the buffer in the first 4 bytes
-    char size_buff[4];
-    flatbuffers::WriteScalar(size_buff, static_cast<int32_t>(builder.GetSize()));
+    const size_t offset = header_.size();
+    header_.resize(offset + 4 + builder.GetSize());
+    flatbuffers::WriteScalar(&header_[offset], static_cast<int32_t>(builder.GetSize()));
+    std::copy(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize(),
+              header_.begin() + offset + 4);
+
+    openFile();
 
-    file_os_.write(size_buff, 4);
-    file_os_.write(reinterpret_cast<const char*>(builder.GetBufferPointer()), builder.GetSize());
+    if (options_.async)
+    {
+        writer_thread_ = std::thread(&FileLogger::writerLoop, this);
+    }
 }
 
 FileLogger::~FileLogger()
 {
+    if (writer_thread_.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(buffer_mutex_);
+            stop_writer_ = true;
+        }
+        buffer_cv_.notify_one();
+        writer_thread_.join();
+    }
     this->flush();
     file_os_.close();
 }
@@ -40,27 +84,203 @@ void FileLogger::callback(Duration timestamp, const TreeNode& node, NodeStatus p
     SerializedTransition buffer =
         SerializeTransition(node.UID(), timestamp, prev_status, status);
 
-    if (buffer_max_size_ == 0)
+    if (options_.async)
     {
-        file_os_.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        std::unique_lock<std::mutex> lock(buffer_mutex_);
+        if (buffer_.size() >= async_capacity_)
+        {
+            dropped_++;
+            return;
+        }
+        buffer_.push_back(buffer);
+        if (buffer_.size() == writeThreshold())
+        {
+            buffer_cv_.notify_one();
+        }
+    }
+    else if (options_.buffer_size == 0)
+    {
+        writeTransitions(&buffer, 1);
     }
     else
     {
         buffer_.push_back(buffer);
-        if (buffer_.size() >= buffer_max_size_)
+        if (buffer_.size() >= options_.buffer_size)
         {
-            this->flush();
+            // unlike flush(), don't close the current V2 block
+            writeTransitions(buffer_.data(), buffer_.size());
+            file_os_.flush();
+            buffer_.clear();
         }
     }
 }
 
 void FileLogger::flush()
 {
-    for (const auto& array : buffer_)
+    if (writer_thread_.joinable())
     {
-        file_os_.write(reinterpret_cast<const char*>(array.data()), array.size());
+        std::unique_lock<std::mutex> lock(buffer_mutex_);
+        const uint64_t request = ++flush_requested_;
+        buffer_cv_.notify_one();
+        flushed_cv_.wait(lock, [this, request]() { return flush_done_ >= request; });
+        return;
     }
-    file_os_.flush();
+    writeTransitions(buffer_.data(), buffer_.size());
     buffer_.clear();
+    writeBlock();
+    file_os_.flush();
+}
+
+void FileLogger::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(buffer_mutex_);
+    const size_t threshold = writeThreshold();
+
+    while (true)
+    {
+        buffer_cv_.wait_for(lock, options_.write_period, [&]() {
+            return stop_writer_ || buffer_.size() >= threshold || flush_requested_ != flush_done_;
+        });
+        const bool stop = stop_writer_;
+        const uint64_t request = flush_requested_;
+
+        // double buffering: the tick thread keeps filling buffer_ while we write
+        buffer_.swap(write_buffer_);
+        lock.unlock();
+
+        writeTransitions(write_buffer_.data(), write_buffer_.size());
+        write_buffer_.clear();
+        if (request != flush_done_)
+        {
+            writeBlock();
+            file_os_.flush();
+        }
+
+        lock.lock();
+        if (request != flush_done_)
+        {
+            flush_done_ = request;
+            flushed_cv_.notify_all();
+        }
+        if (stop)
+        {
+            return;
+        }
+    }
+}
+
+size_t FileLogger::writeThreshold() const
+{
+    // wake up the writer before the transitions are dropped
+    return std::min(std::max<size_t>(options_.buffer_size, 1), async_capacity_);
+}
+
+void FileLogger::writeTransitions(const SerializedTransition* transitions, size_t count)
+{
+    if (options_.format == FileLogFormat::V2)
+    {
+        const size_t block_size = std::max<size_t>(options_.block_size, 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            encoder_.push(DeserializeTransition(transitions[i].data()));
+            if (encoder_.count() >= block_size)
+            {
+                writeBlock();
+            }
+        }
+        return;
+    }
+
+    const size_t transition_size = sizeof(SerializedTransition);
+
+    while (count > 0)
+    {
+        const bool too_old =
+            options_.max_file_age.count() > 0 &&
+            std::chrono::steady_clock::now() - file_open_time_ >= options_.max_file_age;
+
+        // split the batch if it doesn't fit into the current file
+        size_t to_write = count;
+        if (options_.max_file_size > 0)
+        {
+            const size_t available = file_size_ < options_.max_file_size ?
+                                         (options_.max_file_size - file_size_) / transition_size :
+                                         0;
+            to_write = std::min(count, available);
+        }
+
+        if (too_old || (to_write == 0 && file_size_ > header_.size()))
+        {
+            rotate();
+            continue;
+        }
+        // a file always contains at least one transition
+        to_write = std::max<size_t>(to_write, 1);
+
+        // SerializedTransition is a std::array: the buffer is contiguous
+        file_os_.write(reinterpret_cast<const char*>(transitions), to_write * transition_size);
+        file_size_ += to_write * transition_size;
+        transitions += to_write;
+        count -= to_write;
+    }
+}
+
+void FileLogger::writeBlock()
+{
+    if (encoder_.count() == 0)
+    {
+        return;
+    }
+    block_.clear();
+    encoder_.finish(block_);
+
+    const bool too_old = options_.max_file_age.count() > 0 &&
+                         std::chrono::steady_clock::now() - file_open_time_ >= options_.max_file_age;
+    const bool too_big = options_.max_file_size > 0 &&
+                         file_size_ + block_.size() > options_.max_file_size;
+
+    // a file always contains at least one block
+    if ((too_old || too_big) && file_size_ > header_.size())
+    {
+        rotate();
+    }
+    file_os_.write(reinterpret_cast<const char*>(block_.data()), block_.size());
+    file_size_ += block_.size();
+}
+
+void FileLogger::openFile()
+{
+    file_os_.open(filename_, std::ofstream::binary | std::ofstream::out | std::ofstream::trunc);
+    file_os_.write(header_.data(), header_.size());
+    file_size_ = header_.size();
+    file_open_time_ = std::chrono::steady_clock::now();
+}
+
+void FileLogger::rotate()
+{
+    file_os_.close();
+
+    if (options_.max_files > 0)
+    {
+        std::remove(rotatedFilename(options_.max_files).c_str());
+        for (size_t i = options_.max_files - 1; i >= 1; i--)
+        {
+            std::rename(rotatedFilename(i).c_str(), rotatedFilename(i + 1).c_str());
+        }
+        std::rename(filename_.c_str(), rotatedFilename(1).c_str());
+    }
+    openFile();
+}
+
+std::string FileLogger::rotatedFilename(size_t index) const
+{
+    // "trace.fbl" -> "trace.1.fbl"
+    const size_t dot = filename_.find_last_of('.');
+    const size_t slash = filename_.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        return filename_ + "." + std::to_string(index);
+    }
+    return filename_.substr(0, dot) + "." + std::to_string(index) + filename_.substr(dot);
 }
 }
@@ -0,0 +1,645 @@
+#include "behaviortree_cpp/loggers/bt_flight_recorder.h"
+#include "behaviortree_cpp/loggers/bt_flatbuffer_helper.h"
+#include "behaviortree_cpp/blackboard/demangle_util.h"
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <signal.h>
+#include <unistd.h>
+
+namespace BT
+{
+namespace
+{
+const int FATAL_SIGNALS[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+const size_t NUM_FATAL_SIGNALS = sizeof(FATAL_SIGNALS) / sizeof(int);
+const size_t MAX_SIGNAL_RECORDERS = 16;
+
+// read by the signal handler, hence the fixed size and the atomics
+std::atomic<FlightRecorder*> signal_recorders[MAX_SIGNAL_RECORDERS];
+std::mutex signal_mutex;
+size_t signal_users = 0;
+struct sigaction previous_actions[NUM_FATAL_SIGNALS];
+
+size_t roundUpPowerOfTwo(size_t value)
+{
+    size_t size = 2;
+    while (size < value)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+void storeString(std::atomic<uint64_t>* words, size_t count, const char* data, size_t size)
+{
+    char buffer[64] = {};
+    memcpy(buffer, data, std::min(size, count * 8 - 1));
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t word;
+        memcpy(&word, buffer + i * 8, 8);
+        words[i].store(word, std::memory_order_relaxed);
+    }
+}
+
+// output buffer usable in a signal handler
+class FdWriter
+{
+  public:
+    explicit FdWriter(int fd) : fd_(fd), size_(0)
+    {
+    }
+
+    ~FdWriter()
+    {
+        flush();
+    }
+
+    void append(const void* data, size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const size_t chunk = std::min(size, sizeof(buffer_) - size_);
+            memcpy(buffer_ + size_, bytes, chunk);
+            size_ += chunk;
+            bytes += chunk;
+            size -= chunk;
+            if (size_ == sizeof(buffer_))
+            {
+                flush();
+            }
+        }
+    }
+
+    void append(const char* str)
+    {
+        append(str, strlen(str));
+    }
+
+    void appendUnsigned(uint64_t value, int min_digits = 1)
+    {
+        char digits[24];
+        int count = 0;
+        while (value > 0 || count < min_digits)
+        {
+            digits[sizeof(digits) - 1 - count++] = char('0' + value % 10);
+            value /= 10;
+        }
+        append(digits + sizeof(digits) - count, count);
+    }
+
+    void flush()
+    {
+        size_t written = 0;
+        while (fd_ >= 0 && written < size_)
+        {
+            const ssize_t ret = ::write(fd_, buffer_ + written, size_ - written);
+            if (ret <= 0)
+            {
+                break;
+            }
+            written += static_cast<size_t>(ret);
+        }
+        size_ = 0;
+    }
+
+  private:
+    int fd_;
+    size_t size_;
+    char buffer_[4096];
+};
+
+enum ValueType : uint64_t
+{
+    STRING_VALUE,
+    INT_VALUE,
+    UINT_VALUE,
+    DOUBLE_VALUE,
+    OTHER_VALUE   // value[0] is the address of its std::type_info
+};
+
+// Fixed size output, usable in a signal handler; the text is truncated to the buffer.
+class CharWriter
+{
+  public:
+    CharWriter(char* buffer, size_t size) : buffer_(buffer), size_(size), length_(0)
+    {
+        buffer_[0] = 0;
+    }
+
+    void append(const char* str)
+    {
+        while (*str && length_ + 1 < size_)
+        {
+            buffer_[length_++] = *str++;
+        }
+        buffer_[length_] = 0;
+    }
+
+    void appendUnsigned(uint64_t value, int min_digits = 1)
+    {
+        char digits[24];
+        char* first = digits + sizeof(digits) - 1;
+        *first = 0;
+        for (int count = 0; value > 0 || count < min_digits; count++)
+        {
+            *--first = char('0' + value % 10);
+            value /= 10;
+        }
+        append(first);
+    }
+
+    // like std::to_string(double), without printf
+    void appendDouble(double value)
+    {
+        if (std::isnan(value))
+        {
+            append("nan");
+            return;
+        }
+        if (value < 0)
+        {
+            append("-");
+            value = -value;
+        }
+        if (std::isinf(value))
+        {
+            append("inf");
+            return;
+        }
+        int exponent = 0;
+        while (value >= 1e18)
+        {
+            value /= 10;
+            exponent++;
+        }
+        uint64_t integer = static_cast<uint64_t>(value);
+        uint64_t micros = static_cast<uint64_t>((value - double(integer)) * 1e6 + 0.5);
+        if (micros >= 1000000)
+        {
+            integer++;
+            micros -= 1000000;
+        }
+        appendUnsigned(integer);
+        if (exponent > 0)
+        {
+            append("e+");
+            appendUnsigned(static_cast<uint64_t>(exponent));
+            return;
+        }
+        append(".");
+        appendUnsigned(micros, 6);
+    }
+
+  private:
+    char* buffer_;
+    size_t size_;
+    size_t length_;
+};
+}
+
+const size_t FlightRecorder::KEY_WORDS;
+const size_t FlightRecorder::VALUE_WORDS;
+
+FlightRecorder::FlightRecorder(TreeNode* root_node, const FlightRecorderOptions& options)
+  : StatusChangeLogger(root_node)
+  , root_node_(root_node)
+  , options_(options)
+  , transitions_head_(0)
+  , blackboard_head_(0)
+  , dump_count_(0)
+{
+    setEnabled(false);
+
+    flatbuffers::FlatBufferBuilder builder(1024);
+    CreateFlatbuffersBehaviorTree(builder, root_node);
+    header_.resize(4 + builder.GetSize());
+    flatbuffers::WriteScalar(&header_[0], static_cast<int32_t>(builder.GetSize()));
+    memcpy(&header_[4], builder.GetBufferPointer(), builder.GetSize());
+
+    const size_t capacity = roundUpPowerOfTwo(options_.capacity);
+    transitions_mask_ = capacity - 1;
+    transitions_.reset(new TransitionRecord[capacity]);
+    for (size_t i = 0; i < capacity; i++)
+    {
+        transitions_[i].sequence.store(0, std::memory_order_relaxed);
+    }
+
+    const size_t bb_capacity =
+        options_.blackboard ? roundUpPowerOfTwo(options_.blackboard_capacity) : 0;
+    blackboard_mask_ = bb_capacity - 1;
+    blackboard_.reset(new BlackboardRecord[bb_capacity]);
+    for (size_t i = 0; i < bb_capacity; i++)
+    {
+        blackboard_[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    blackboard_filename_ = options_.filename + ".blackboard";
+
+    if (options_.dump_on_signal)
+    {
+        installSignalHandlers(this);
+    }
+    if (options_.blackboard)
+    {
+        blackboard_subscriber_ = options_.blackboard->subscribeToWrites(
+            [this](const std::string& key, const SafeAny::Any& value) {
+                recordBlackboardWrite(key, value);
+            });
+    }
+    setEnabled(true);
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    setEnabled(false);
+    if (options_.dump_on_signal)
+    {
+        removeSignalHandlers(this);
+    }
+    blackboard_subscriber_.reset();
+}
+
+void FlightRecorder::callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
+                              NodeStatus status)
+{
+    const uint64_t index = transitions_head_.fetch_add(1, std::memory_order_relaxed);
+    TransitionRecord& record = transitions_[index & transitions_mask_];
+
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.timestamp_usec.store(
+        std::chrono::duration_cast<std::chrono::microseconds>(timestamp).count(),
+        std::memory_order_relaxed);
+    record.data.store((uint32_t(node.UID()) << 16) | (uint32_t(prev_status) << 8) |
+                          uint32_t(status),
+                      std::memory_order_relaxed);
+    record.sequence.store(2 * index + 2, std::memory_order_release);
+
+    if (options_.dump_on_failure && status == NodeStatus::FAILURE && &node == root_node_)
+    {
+        try
+        {
+            flush();
+        }
+        catch (std::exception& err)
+        {
+            std::cerr << "[FlightRecorder] " << err.what() << std::endl;
+        }
+    }
+}
+
+void FlightRecorder::recordBlackboardWrite(const std::string& key, const SafeAny::Any& value)
+{
+    const uint64_t timestamp_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::system_clock::now().time_since_epoch())
+                                        .count();
+
+    // nothing is formatted here, in the thread that writes into the blackboard
+    const std::type_info& type = value.type();
+    uint64_t value_type = OTHER_VALUE;
+    uint64_t number = reinterpret_cast<uintptr_t>(&type);
+    const SafeAny::SimpleString* str = value.asSimpleString();
+    if (str)
+    {
+        value_type = STRING_VALUE;
+    }
+    else if (type == typeid(int64_t))
+    {
+        value_type = INT_VALUE;
+        number = static_cast<uint64_t>(value.cast<int64_t>());
+    }
+    else if (type == typeid(uint64_t))
+    {
+        value_type = UINT_VALUE;
+        number = value.cast<uint64_t>();
+    }
+    else if (type == typeid(double))
+    {
+        value_type = DOUBLE_VALUE;
+        const double real = value.cast<double>();
+        memcpy(&number, &real, sizeof(number));
+    }
+
+    const uint64_t index = blackboard_head_.fetch_add(1, std::memory_order_relaxed);
+    BlackboardRecord& record = blackboard_[index & blackboard_mask_];
+
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.timestamp_usec.store(timestamp_usec, std::memory_order_relaxed);
+    storeString(record.key, KEY_WORDS, key.data(), key.size());
+    record.value_type.store(value_type, std::memory_order_relaxed);
+    if (str)
+    {
+        storeString(record.value, VALUE_WORDS, str->data(), str->size());
+    }
+    else
+    {
+        record.value[0].store(number, std::memory_order_relaxed);
+    }
+    record.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void FlightRecorder::flush()
+{
+    dump(options_.filename);
+}
+
+void FlightRecorder::dump(const std::string& filename)
+{
+    std::unique_lock<std::mutex> lock(dump_mutex_);
+    const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("FlightRecorder: can't open the file " + filename);
+    }
+    int blackboard_fd = -1;
+    if (options_.blackboard)
+    {
+        blackboard_fd =
+            ::open((filename + ".blackboard").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    writeDump(fd, blackboard_fd, true);
+    ::close(fd);
+    if (blackboard_fd >= 0)
+    {
+        ::close(blackboard_fd);
+    }
+    dump_count_++;
+}
+
+NodeStatus FlightRecorder::tick()
+{
+    try
+    {
+        return root_node_->executeTick();
+    }
+    catch (...)
+    {
+        try
+        {
+            flush();
+        }
+        catch (std::exception& err)
+        {
+            std::cerr << "[FlightRecorder] " << err.what() << std::endl;
+        }
+        throw;
+    }
+}
+
+bool FlightRecorder::readTransition(uint64_t index, uint64_t& timestamp_usec,
+                                    uint32_t& data) const
+{
+    const TransitionRecord& record = transitions_[index & transitions_mask_];
+    const uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+    timestamp_usec = record.timestamp_usec.load(std::memory_order_relaxed);
+    data = record.data.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // false if the record is being written or was overwritten
+    return sequence == 2 * index + 2 &&
+           record.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool FlightRecorder::readBlackboardWrite(uint64_t index, uint64_t& timestamp_usec, char* key,
+                                         char* value, bool demangle_types) const
+{
+    const BlackboardRecord& record = blackboard_[index & blackboard_mask_];
+    const uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+    timestamp_usec = record.timestamp_usec.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < KEY_WORDS; i++)
+    {
+        const uint64_t word = record.key[i].load(std::memory_order_relaxed);
+        memcpy(key + i * 8, &word, 8);
+    }
+    const uint64_t value_type = record.value_type.load(std::memory_order_relaxed);
+    uint64_t words[VALUE_WORDS];
+    for (size_t i = 0; i < VALUE_WORDS; i++)
+    {
+        words[i] = record.value[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    key[KEY_WORDS * 8 - 1] = 0;
+    if (sequence != 2 * index + 2 || record.sequence.load(std::memory_order_relaxed) != sequence)
+    {
+        return false;
+    }
+
+    CharWriter writer(value, VALUE_WORDS * 8);
+    switch (value_type)
+    {
+        case STRING_VALUE:
+            memcpy(value, words, VALUE_WORDS * 8);
+            value[VALUE_WORDS * 8 - 1] = 0;
+            break;
+        case INT_VALUE:
+        {
+            const int64_t number = static_cast<int64_t>(words[0]);
+            if (number < 0)
+            {
+                writer.append("-");
+            }
+            writer.appendUnsigned(number < 0 ? 0 - words[0] : words[0]);
+            break;
+        }
+        case UINT_VALUE:
+            writer.appendUnsigned(words[0]);
+            break;
+        case DOUBLE_VALUE:
+        {
+            double number;
+            memcpy(&number, &words[0], sizeof(number));
+            writer.appendDouble(number);
+            break;
+        }
+        default:
+        {
+            const std::type_info* type = reinterpret_cast<const std::type_info*>(words[0]);
+            writer.append("<");
+            writer.append(demangle_types ? demangle(type->name()).c_str() : type->name());
+            writer.append(">");
+            break;
+        }
+    }
+    return true;
+}
+
+std::vector<LogTransition> FlightRecorder::transitions() const
+{
+    std::vector<LogTransition> output;
+    const uint64_t head = transitions_head_.load(std::memory_order_acquire);
+    const uint64_t capacity = transitions_mask_ + 1;
+    for (uint64_t index = (head > capacity) ? head - capacity : 0; index < head; index++)
+    {
+        LogTransition transition;
+        uint32_t data;
+        if (readTransition(index, transition.timestamp_usec, data))
+        {
+            transition.uid = static_cast<uint16_t>(data >> 16);
+            transition.prev_status = static_cast<NodeStatus>((data >> 8) & 0xFF);
+            transition.status = static_cast<NodeStatus>(data & 0xFF);
+            output.push_back(transition);
+        }
+    }
+    return output;
+}
+
+std::vector<BlackboardWrite> FlightRecorder::blackboardWrites() const
+{
+    std::vector<BlackboardWrite> output;
+    if (!options_.blackboard)
+    {
+        return output;
+    }
+    const uint64_t head = blackboard_head_.load(std::memory_order_acquire);
+    const uint64_t capacity = blackboard_mask_ + 1;
+    for (uint64_t index = (head > capacity) ? head - capacity : 0; index < head; index++)
+    {
+        uint64_t timestamp_usec;
+        char key[KEY_WORDS * 8];
+        char value[VALUE_WORDS * 8];
+        if (readBlackboardWrite(index, timestamp_usec, key, value, true))
+        {
+            output.push_back({timestamp_usec, key, value});
+        }
+    }
+    return output;
+}
+
+void FlightRecorder::writeDump(int fd, int blackboard_fd, bool demangle_types) const
+{
+    {
+        FdWriter writer(fd);
+        writer.append(header_.data(), header_.size());
+
+        const uint64_t head = transitions_head_.load(std::memory_order_acquire);
+        const uint64_t capacity = transitions_mask_ + 1;
+        for (uint64_t index = (head > capacity) ? head - capacity : 0; index < head; index++)
+        {
+            uint64_t timestamp_usec;
+            uint32_t data;
+            if (readTransition(index, timestamp_usec, data))
+            {
+                const SerializedTransition buffer = SerializeTransition(
+                    static_cast<uint16_t>(data >> 16), std::chrono::microseconds(timestamp_usec),
+                    static_cast<NodeStatus>((data >> 8) & 0xFF),
+                    static_cast<NodeStatus>(data & 0xFF));
+                writer.append(buffer.data(), buffer.size());
+            }
+        }
+    }
+
+    if (blackboard_fd < 0)
+    {
+        return;
+    }
+    // one line per write: "<seconds>.<microseconds> <key> <value>"
+    FdWriter writer(blackboard_fd);
+    const uint64_t head = blackboard_head_.load(std::memory_order_acquire);
+    const uint64_t capacity = blackboard_mask_ + 1;
+    for (uint64_t index = (head > capacity) ? head - capacity : 0; index < head; index++)
+    {
+        uint64_t timestamp_usec;
+        char key[KEY_WORDS * 8];
+        char value[VALUE_WORDS * 8];
+        if (readBlackboardWrite(index, timestamp_usec, key, value, demangle_types))
+        {
+            writer.appendUnsigned(timestamp_usec / 1000000);
+            writer.append(".");
+            writer.appendUnsigned(timestamp_usec % 1000000, 6);
+            writer.append(" ");
+            writer.append(key);
+            writer.append(" ");
+            writer.append(value);
+            writer.append("\n");
+        }
+    }
+}
+
+void FlightRecorder::signalHandler(int signal)
+{
+    // restore the previous handlers first: a fault while dumping must not loop
+    for (size_t i = 0; i < NUM_FATAL_SIGNALS; i++)
+    {
+        sigaction(FATAL_SIGNALS[i], &previous_actions[i], nullptr);
+    }
+
+    for (auto& slot : signal_recorders)
+    {
+        const FlightRecorder* recorder = slot.load();
+        if (!recorder)
+        {
+            continue;
+        }
+        const int fd =
+            ::open(recorder->options_.filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        const int blackboard_fd =
+            recorder->options_.blackboard ?
+                ::open(recorder->blackboard_filename_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) :
+                -1;
+        if (fd >= 0)
+        {
+            recorder->writeDump(fd, blackboard_fd, false);
+            ::close(fd);
+        }
+        if (blackboard_fd >= 0)
+        {
+            ::close(blackboard_fd);
+        }
+    }
+    raise(signal);
+}
+
+void FlightRecorder::installSignalHandlers(FlightRecorder* recorder)
+{
+    std::unique_lock<std::mutex> lock(signal_mutex);
+    bool registered = false;
+    for (auto& slot : signal_recorders)
+    {
+        FlightRecorder* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, recorder))
+        {
+            registered = true;
+            break;
+        }
+    }
+    if (!registered)
+    {
+        throw std::logic_error("FlightRecorder: too many instances with dump_on_signal");
+    }
+
+    if (signal_users++ == 0)
+    {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = &FlightRecorder::signalHandler;
+        sigemptyset(&action.sa_mask);
+        for (size_t i = 0; i < NUM_FATAL_SIGNALS; i++)
+        {
+            sigaction(FATAL_SIGNALS[i], &action, &previous_actions[i]);
+        }
+    }
+}
+
+void FlightRecorder::removeSignalHandlers(FlightRecorder* recorder)
+{
+    std::unique_lock<std::mutex> lock(signal_mutex);
+    for (auto& slot : signal_recorders)
+    {
+        FlightRecorder* expected = recorder;
+        if (slot.compare_exchange_strong(expected, nullptr))
+        {
+            break;
+        }
+    }
+    if (--signal_users == 0)
+    {
+        for (size_t i = 0; i < NUM_FATAL_SIGNALS; i++)
+        {
+            sigaction(FATAL_SIGNALS[i], &previous_actions[i], nullptr);
+        }
+    }
+}
+}
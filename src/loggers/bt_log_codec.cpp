@@ -0,0 +1,253 @@
+#include <cstring>
+#include <stdexcept>
+#include "behaviortree_cpp/loggers/bt_log_codec.h"
+#include "behaviortree_cpp/loggers/bt_flatbuffer_helper.h"
+
+namespace BT
+{
+namespace
+{
+const size_t LZ_MIN_MATCH = 4;
+const int LZ_HASH_BITS = 12;
+
+inline void writeVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool readVarint(const uint8_t*& ptr, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && ptr < end; shift += 7)
+    {
+        const uint8_t byte = *(ptr++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline uint64_t zigzagEncode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline bool validStatus(uint8_t status)
+{
+    return status <= static_cast<uint8_t>(NodeStatus::FAILURE);
+}
+}
+
+LogTransition DeserializeTransition(const uint8_t* buffer)
+{
+    LogTransition transition;
+    const uint32_t t_sec = flatbuffers::ReadScalar<uint32_t>(&buffer[0]);
+    const uint32_t t_usec = flatbuffers::ReadScalar<uint32_t>(&buffer[4]);
+    transition.timestamp_usec = static_cast<uint64_t>(t_sec) * 1000000 + t_usec;
+    transition.uid = flatbuffers::ReadScalar<uint16_t>(&buffer[8]);
+    transition.prev_status = static_cast<NodeStatus>(flatbuffers::ReadScalar<int8_t>(&buffer[10]));
+    transition.status = static_cast<NodeStatus>(flatbuffers::ReadScalar<int8_t>(&buffer[11]));
+    return transition;
+}
+
+bool ReadLogBlockHeader(const uint8_t* data, size_t size, LogBlockHeader& header)
+{
+    if (size < LogBlockHeader::SIZE)
+    {
+        return false;
+    }
+    header.payload_size = flatbuffers::ReadScalar<uint32_t>(&data[0]);
+    header.raw_size = flatbuffers::ReadScalar<uint32_t>(&data[4]);
+    header.count = flatbuffers::ReadScalar<uint32_t>(&data[8]);
+    header.flags = flatbuffers::ReadScalar<uint32_t>(&data[12]);
+    header.first_timestamp_usec = flatbuffers::ReadScalar<uint64_t>(&data[16]);
+    header.last_timestamp_usec = flatbuffers::ReadScalar<uint64_t>(&data[24]);
+    return true;
+}
+
+void DecodeLogBlock(const LogBlockHeader& header, const uint8_t* payload,
+                    std::vector<LogTransition>& transitions, std::vector<uint8_t>& scratch)
+{
+    const uint8_t* ptr = payload;
+    const uint8_t* end = payload + header.payload_size;
+
+    if (header.flags & LogBlockHeader::COMPRESSED)
+    {
+        scratch.resize(header.raw_size);
+        if (!DecompressLZ(payload, header.payload_size, scratch.data(), scratch.size()))
+        {
+            throw std::runtime_error("DecodeLogBlock: corrupted compressed block");
+        }
+        ptr = scratch.data();
+        end = ptr + scratch.size();
+    }
+
+    transitions.reserve(transitions.size() + header.count);
+    uint64_t timestamp = header.first_timestamp_usec;
+
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        uint64_t delta = 0;
+        uint64_t uid = 0;
+        if (!readVarint(ptr, end, delta) || !readVarint(ptr, end, uid) || ptr >= end)
+        {
+            throw std::runtime_error("DecodeLogBlock: truncated block");
+        }
+        const uint8_t statuses = *(ptr++);
+        if (uid > 0xFFFF || !validStatus(statuses >> 4) || !validStatus(statuses & 0x0F))
+        {
+            throw std::runtime_error("DecodeLogBlock: corrupted block");
+        }
+        timestamp += zigzagDecode(delta);
+
+        LogTransition transition;
+        transition.timestamp_usec = timestamp;
+        transition.uid = static_cast<uint16_t>(uid);
+        transition.prev_status = static_cast<NodeStatus>(statuses >> 4);
+        transition.status = static_cast<NodeStatus>(statuses & 0x0F);
+        transitions.push_back(transition);
+    }
+}
+
+LogBlockEncoder::LogBlockEncoder(bool compress)
+  : compress_(compress), count_(0), first_timestamp_(0), last_timestamp_(0)
+{
+}
+
+void LogBlockEncoder::push(const LogTransition& transition)
+{
+    if (count_ == 0)
+    {
+        first_timestamp_ = transition.timestamp_usec;
+        last_timestamp_ = transition.timestamp_usec;
+    }
+    // timestamps may not be monotonic if nodes change status in different threads
+    const int64_t delta = static_cast<int64_t>(transition.timestamp_usec - last_timestamp_);
+    writeVarint(raw_, zigzagEncode(delta));
+    writeVarint(raw_, transition.uid);
+    raw_.push_back(static_cast<uint8_t>((static_cast<uint8_t>(transition.prev_status) << 4) |
+                                        static_cast<uint8_t>(transition.status)));
+    last_timestamp_ = transition.timestamp_usec;
+    count_++;
+}
+
+void LogBlockEncoder::finish(std::vector<uint8_t>& output)
+{
+    uint32_t flags = 0;
+    const std::vector<uint8_t>* payload = &raw_;
+
+    if (compress_)
+    {
+        compressed_.clear();
+        CompressLZ(raw_.data(), raw_.size(), compressed_, hash_table_);
+        if (compressed_.size() < raw_.size())
+        {
+            flags |= LogBlockHeader::COMPRESSED;
+            payload = &compressed_;
+        }
+    }
+
+    const size_t offset = output.size();
+    output.resize(offset + LogBlockHeader::SIZE);
+    uint8_t* header = &output[offset];
+    flatbuffers::WriteScalar(&header[0], static_cast<uint32_t>(payload->size()));
+    flatbuffers::WriteScalar(&header[4], static_cast<uint32_t>(raw_.size()));
+    flatbuffers::WriteScalar(&header[8], count_);
+    flatbuffers::WriteScalar(&header[12], flags);
+    flatbuffers::WriteScalar(&header[16], first_timestamp_);
+    flatbuffers::WriteScalar(&header[24], last_timestamp_);
+    output.insert(output.end(), payload->begin(), payload->end());
+
+    raw_.clear();
+    count_ = 0;
+}
+
+void CompressLZ(const uint8_t* input, size_t size, std::vector<uint8_t>& output,
+                std::vector<int32_t>& hash_table)
+{
+    hash_table.assign(1 << LZ_HASH_BITS, -1);
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    while (pos + LZ_MIN_MATCH <= size)
+    {
+        uint32_t sequence;
+        std::memcpy(&sequence, input + pos, sizeof(sequence));
+        const uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        const int32_t candidate = hash_table[hash];
+        hash_table[hash] = static_cast<int32_t>(pos);
+
+        if (candidate < 0 || std::memcmp(input + candidate, input + pos, LZ_MIN_MATCH) != 0)
+        {
+            pos++;
+            continue;
+        }
+
+        size_t length = LZ_MIN_MATCH;
+        while (pos + length < size && input[candidate + length] == input[pos + length])
+        {
+            length++;
+        }
+        writeVarint(output, pos - anchor);
+        output.insert(output.end(), input + anchor, input + pos);
+        writeVarint(output, length);
+        writeVarint(output, pos - candidate);
+
+        pos += length;
+        anchor = pos;
+    }
+    writeVarint(output, size - anchor);
+    output.insert(output.end(), input + anchor, input + size);
+}
+
+bool DecompressLZ(const uint8_t* input, size_t size, uint8_t* output, size_t output_size)
+{
+    const uint8_t* ptr = input;
+    const uint8_t* end = input + size;
+    size_t out_pos = 0;
+
+    while (true)
+    {
+        uint64_t literals = 0;
+        if (!readVarint(ptr, end, literals) || literals > static_cast<size_t>(end - ptr) ||
+            literals > output_size - out_pos)
+        {
+            return false;
+        }
+        std::memcpy(output + out_pos, ptr, literals);
+        ptr += literals;
+        out_pos += literals;
+
+        if (out_pos == output_size)
+        {
+            return ptr == end;
+        }
+
+        uint64_t length = 0;
+        uint64_t offset = 0;
+        if (!readVarint(ptr, end, length) || !readVarint(ptr, end, offset) || offset == 0 ||
+            offset > out_pos || length > output_size - out_pos)
+        {
+            return false;
+        }
+        // the regions may overlap: copy one byte at a time
+        for (uint64_t i = 0; i < length; i++, out_pos++)
+        {
+            output[out_pos] = output[out_pos - offset];
+        }
+    }
+}
+}
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "behaviortree_cpp/loggers/bt_log_reader.h"
+#include "behaviortree_cpp/loggers/bt_flatbuffer_helper.h"
+
+namespace BT
+{
+namespace
+{
+const size_t V1_TRANSITION_SIZE = 12;
+const size_t V1_INDEX_STRIDE = 4096;
+
+inline bool matches(const LogTransition& transition, const LogFilter& filter,
+                    const std::vector<bool>& uid_mask)
+{
+    return transition.timestamp_usec >= filter.from_usec &&
+           transition.timestamp_usec <= filter.to_usec &&
+           (uid_mask.empty() || uid_mask[transition.uid]) &&
+           ((filter.status_mask >> static_cast<int>(transition.status)) & 1);
+}
+}
+
+LogReader::LogReader(const std::string& filename)
+  : data_(nullptr), size_(0), version_(1), transitions_offset_(0), transitions_count_(0),
+    root_uid_(0)
+{
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw BehaviorTreeException("LogReader: can't open file [" + filename + "]");
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < 4)
+    {
+        ::close(fd);
+        throw BehaviorTreeException("LogReader: invalid file [" + filename + "]");
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void* ptr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        throw BehaviorTreeException("LogReader: can't map file [" + filename + "]");
+    }
+    data_ = static_cast<const uint8_t*>(ptr);
+    ::madvise(ptr, size_, MADV_SEQUENTIAL);
+
+    try
+    {
+        readTree();
+        buildIndex();
+    }
+    catch (...)
+    {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+        throw;
+    }
+}
+
+LogReader::~LogReader()
+{
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+void LogReader::readTree()
+{
+    size_t offset = 0;
+    if (size_ >= sizeof(LOG_V2_MAGIC) &&
+        std::memcmp(data_, LOG_V2_MAGIC, sizeof(LOG_V2_MAGIC)) == 0)
+    {
+        version_ = 2;
+        offset = sizeof(LOG_V2_MAGIC);
+    }
+    if (size_ < offset + 4)
+    {
+        throw BehaviorTreeException("LogReader: file too short");
+    }
+    const size_t tree_size = flatbuffers::ReadScalar<uint32_t>(&data_[offset]);
+    offset += 4;
+    if (tree_size > size_ - offset)
+    {
+        throw BehaviorTreeException("LogReader: file too short");
+    }
+
+    flatbuffers::Verifier verifier(&data_[offset], tree_size);
+    if (!verifier.VerifyBuffer<BT_Serialization::BehaviorTree>())
+    {
+        throw BehaviorTreeException("LogReader: the tree is not valid");
+    }
+    const auto behavior_tree = BT_Serialization::GetBehaviorTree(&data_[offset]);
+    transitions_offset_ = offset + tree_size;
+
+    root_uid_ = behavior_tree->root_uid();
+    if (behavior_tree->nodes())
+    {
+        nodes_.reserve(behavior_tree->nodes()->size());
+        for (const BT_Serialization::TreeNode* fb_node : *(behavior_tree->nodes()))
+        {
+            Node node;
+            node.uid = fb_node->uid();
+            node.instance_name = fb_node->instance_name()->str();
+            node.registration_name = fb_node->registration_name()->str();
+            node.type = static_cast<NodeType>(fb_node->type());
+            if (fb_node->children_uid())
+            {
+                node.children_uid.assign(fb_node->children_uid()->begin(),
+                                         fb_node->children_uid()->end());
+            }
+            node_index_[node.uid] = nodes_.size();
+            nodes_.push_back(std::move(node));
+        }
+    }
+}
+
+void LogReader::buildIndex()
+{
+    if (version_ == 1)
+    {
+        transitions_count_ = (size_ - transitions_offset_) / V1_TRANSITION_SIZE;
+        index_.reserve(transitions_count_ / V1_INDEX_STRIDE + 1);
+        for (size_t i = 0; i < transitions_count_; i += V1_INDEX_STRIDE)
+        {
+            const size_t offset = transitions_offset_ + i * V1_TRANSITION_SIZE;
+            IndexEntry entry = {DeserializeTransition(&data_[offset]).timestamp_usec, offset};
+            index_.push_back(entry);
+        }
+        return;
+    }
+
+    // only the block headers are read
+    size_t offset = transitions_offset_;
+    LogBlockHeader header;
+    while (ReadLogBlockHeader(&data_[offset], size_ - offset, header) &&
+           header.payload_size <= size_ - offset - LogBlockHeader::SIZE)
+    {
+        IndexEntry entry = {header.first_timestamp_usec, offset};
+        index_.push_back(entry);
+        transitions_count_ += header.count;
+        offset += LogBlockHeader::SIZE + header.payload_size;
+    }
+}
+
+const LogReader::Node& LogReader::node(uint16_t uid) const
+{
+    auto it = node_index_.find(uid);
+    if (it == node_index_.end())
+    {
+        throw std::out_of_range("LogReader: no node with UID " + std::to_string(uid));
+    }
+    return nodes_[it->second];
+}
+
+std::vector<uint16_t> LogReader::findUIDs(const std::string& name) const
+{
+    std::vector<uint16_t> uids;
+    for (const Node& node : nodes_)
+    {
+        if (node.instance_name == name || node.registration_name == name)
+        {
+            uids.push_back(node.uid);
+        }
+    }
+    return uids;
+}
+
+size_t LogReader::forEach(const LogFilter& filter, const Visitor& visitor) const
+{
+    if (index_.empty())
+    {
+        return 0;
+    }
+
+    std::vector<bool> uid_mask;
+    if (!filter.uids.empty())
+    {
+        uid_mask.resize(std::numeric_limits<uint16_t>::max() + 1, false);
+        for (uint16_t uid : filter.uids)
+        {
+            uid_mask[uid] = true;
+        }
+    }
+
+    // last entry that starts before from_usec
+    auto it = std::upper_bound(
+        index_.begin(), index_.end(), filter.from_usec,
+        [](uint64_t timestamp, const IndexEntry& entry) { return timestamp < entry.timestamp_usec; });
+    const size_t first_entry = (it == index_.begin()) ? 0 : (it - index_.begin() - 1);
+
+    return (version_ == 1) ? forEachV1(first_entry, filter, uid_mask, visitor) :
+                             forEachV2(first_entry, filter, uid_mask, visitor);
+}
+
+size_t LogReader::forEachV1(size_t first_entry, const LogFilter& filter,
+                            const std::vector<bool>& uid_mask, const Visitor& visitor) const
+{
+    const size_t end = transitions_offset_ + transitions_count_ * V1_TRANSITION_SIZE;
+    size_t visited = 0;
+
+    for (size_t e = first_entry; e < index_.size(); e++)
+    {
+        if (index_[e].timestamp_usec > filter.to_usec)
+        {
+            break;
+        }
+        const size_t entry_end = (e + 1 < index_.size()) ? index_[e + 1].offset : end;
+        for (size_t offset = index_[e].offset; offset < entry_end; offset += V1_TRANSITION_SIZE)
+        {
+            const LogTransition transition = DeserializeTransition(&data_[offset]);
+            if (matches(transition, filter, uid_mask))
+            {
+                visited++;
+                if (!visitor(transition))
+                {
+                    return visited;
+                }
+            }
+        }
+    }
+    return visited;
+}
+
+size_t LogReader::forEachV2(size_t first_entry, const LogFilter& filter,
+                            const std::vector<bool>& uid_mask, const Visitor& visitor) const
+{
+    std::vector<LogTransition> transitions;
+    std::vector<uint8_t> scratch;
+    size_t visited = 0;
+
+    for (size_t e = first_entry; e < index_.size(); e++)
+    {
+        if (index_[e].timestamp_usec > filter.to_usec)
+        {
+            break;
+        }
+        LogBlockHeader header;
+        ReadLogBlockHeader(&data_[index_[e].offset], LogBlockHeader::SIZE, header);
+        transitions.clear();
+        DecodeLogBlock(header, &data_[index_[e].offset + LogBlockHeader::SIZE], transitions,
+                       scratch);
+
+        for (const LogTransition& transition : transitions)
+        {
+            if (matches(transition, filter, uid_mask))
+            {
+                visited++;
+                if (!visitor(transition))
+                {
+                    return visited;
+                }
+            }
+        }
+    }
+    return visited;
+}
+}
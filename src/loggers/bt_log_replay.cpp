@@ -0,0 +1,331 @@
+#include "behaviortree_cpp/loggers/bt_log_replay.h"
+#include <unordered_map>
+
+namespace BT
+{
+// Replaces an action or a condition; its statuses are decided by LogReplay::stubTick()
+class LogReplay::StubNode : public LeafNode
+{
+  public:
+    StubNode(LogReplay& replay, NodeType type, const std::string& name,
+             const NodeParameters& params)
+      : LeafNode(name, params), slot(0), replay_(replay), type_(type)
+    {
+    }
+
+    NodeType type() const override
+    {
+        return type_;
+    }
+
+    NodeStatus executeTick() override
+    {
+        MonitorScope monitor_scope(*this);
+        const NodeStatus status = replay_.stubTick(*this);
+        setStatus(status);
+        return status;
+    }
+
+    NodeStatus tick() override
+    {
+        return status();
+    }
+
+    void halt() override
+    {
+        setStatus(NodeStatus::IDLE);
+    }
+
+    size_t slot;
+
+  private:
+    LogReplay& replay_;
+    NodeType type_;
+};
+
+std::string toStr(const LogReplayDivergence& divergence)
+{
+    auto transition = [](const LogTransition& t) {
+        return std::string(toStr(t.prev_status, false)) + " -> " + toStr(t.status, false);
+    };
+
+    std::string text = "tick " + std::to_string(divergence.tick) + ", node '" +
+                       divergence.node_name + "' (uid " + std::to_string(divergence.uid) + "): ";
+    if (divergence.expected && divergence.actual)
+    {
+        text += "expected " + transition(*divergence.expected) + ", got " +
+                transition(*divergence.actual);
+    }
+    else if (divergence.expected)
+    {
+        text += "expected " + transition(*divergence.expected) + " at " +
+                std::to_string(divergence.expected->timestamp_usec) + " usec, it didn't happen";
+    }
+    else if (divergence.actual)
+    {
+        text += "unexpected " + transition(*divergence.actual);
+    }
+    return text;
+}
+
+LogReplay::LogReplay(const BehaviorTreeFactory& factory, const std::string& xml_text,
+                     const std::string& log_filename, const Blackboard::Ptr& blackboard)
+  : first_pending_(0)
+  , tick_count_(0)
+  , replayed_count_(0)
+  , last_replayed_in_tick_(0)
+  , replayed_in_tick_(false)
+  , stalled_(false)
+  , now_usec_(0)
+{
+    LogReader reader(log_filename);
+
+    // Same factory, but for the leaves
+    std::set<std::string> deferred_IDs;
+    for (const auto& manifest : factory.manifests())
+    {
+        if (manifest.type != NodeType::ACTION && manifest.type != NodeType::CONDITION &&
+            factory.builders().count(manifest.registration_ID) == 0)
+        {
+            deferred_IDs.insert(manifest.registration_ID);
+        }
+    }
+    if (!deferred_IDs.empty())
+    {
+        factory.loadPluginsFor(deferred_IDs);
+    }
+
+    BehaviorTreeFactory stub_factory;
+    for (const auto& manifest : factory.manifests())
+    {
+        NodeBuilder builder;
+        if (manifest.type == NodeType::ACTION || manifest.type == NodeType::CONDITION)
+        {
+            const NodeType type = manifest.type;
+            builder = [this, type](const std::string& name, const NodeParameters& params) {
+                return std::unique_ptr<TreeNode>(new StubNode(*this, type, name, params));
+            };
+        }
+        else
+        {
+            auto it = factory.builders().find(manifest.registration_ID);
+            if (it == factory.builders().end())
+            {
+                continue;
+            }
+            builder = it->second;
+        }
+        stub_factory.unregisterBuilder(manifest.registration_ID);
+        stub_factory.registerBuilder(manifest, builder);
+    }
+
+    tree_ = buildTreeFromText(stub_factory, xml_text, blackboard);
+
+    // Nodes are matched by their position, depth first, like in the file
+    std::vector<TreeNode*> nodes;
+    applyRecursiveVisitor(tree_.root_node, [&nodes](TreeNode* node) { nodes.push_back(node); });
+
+    const auto& log_nodes = reader.nodes();
+    if (nodes.size() != log_nodes.size())
+    {
+        throw BehaviorTreeException("LogReplay: the tree has " + std::to_string(nodes.size()) +
+                                    " nodes, the one of the log " +
+                                    std::to_string(log_nodes.size()));
+    }
+
+    std::unordered_map<uint16_t, size_t> slot_of_uid;
+    for (size_t slot = 0; slot < nodes.size(); slot++)
+    {
+        TreeNode* node = nodes[slot];
+        const LogReader::Node& log_node = log_nodes[slot];
+        if (node->registrationName() != log_node.registration_name ||
+            node->name() != log_node.instance_name)
+        {
+            throw BehaviorTreeException("LogReplay: node [" + node->name() + "] of the tree " +
+                                        "doesn't match node [" + log_node.instance_name +
+                                        "] of the log");
+        }
+        if (StubNode* stub = dynamic_cast<StubNode*>(node))
+        {
+            stub->slot = slot;
+        }
+        NodeTrack track = {node, log_node.uid, {}, 0, 0};
+        tracks_.push_back(track);
+        slot_of_uid[log_node.uid] = slot;
+    }
+
+    reader.forEach([&](const LogTransition& transition) {
+        auto it = slot_of_uid.find(transition.uid);
+        if (it == slot_of_uid.end())
+        {
+            throw BehaviorTreeException("LogReplay: transition of unknown uid " +
+                                        std::to_string(transition.uid));
+        }
+        tracks_[it->second].transitions.push_back(transitions_.size());
+        transitions_.push_back(transition);
+        transition_slot_.push_back(it->second);
+        return true;
+    });
+    replayed_.resize(transitions_.size(), false);
+
+    for (size_t slot = 0; slot < tracks_.size(); slot++)
+    {
+        skipIdleResults(tracks_[slot]);
+        subscribers_.push_back(tracks_[slot].node->subscribeToStatusChange(
+            [this, slot](TimePoint, const TreeNode&, NodeStatus prev, NodeStatus status) {
+                onTransition(slot, prev, status);
+            }));
+    }
+}
+
+bool LogReplay::step()
+{
+    if (stalled_ || first_pending_ >= transitions_.size())
+    {
+        return false;
+    }
+
+    replayed_in_tick_ = false;
+    last_replayed_in_tick_ = 0;
+    tree_.root_node->executeTick();
+
+    if (!replayed_in_tick_)
+    {
+        // nothing will change in the next ticks either
+        reportMissing(first_pending_);
+        stalled_ = true;
+    }
+    else
+    {
+        // the transitions logged before the last one replayed should have been replayed too
+        for (size_t index = first_pending_; index < last_replayed_in_tick_; index++)
+        {
+            if (!replayed_[index])
+            {
+                reportMissing(index);
+            }
+        }
+    }
+    tick_count_++;
+    return !stalled_ && first_pending_ < transitions_.size();
+}
+
+bool LogReplay::run(size_t max_divergences)
+{
+    while (divergences_.size() < max_divergences && step())
+    {
+    }
+    return divergences_.empty();
+}
+
+NodeStatus LogReplay::stubTick(StubNode& stub)
+{
+    NodeTrack& track = tracks_[stub.slot];
+    NodeStatus status = stub.status();
+    bool ticked_when_idle = (status == NodeStatus::IDLE);
+
+    while (track.next_result < track.transitions.size())
+    {
+        // A stub ticked when IDLE was ticked in the log too. Otherwise its status
+        // changes only when all the transitions logged before it were replayed.
+        const size_t index = track.transitions[track.next_result];
+        if (!ticked_when_idle && index != first_pending_)
+        {
+            break;
+        }
+        ticked_when_idle = false;
+
+        track.next_result++;
+        skipIdleResults(track);
+        status = transitions_[index].status;
+        if (status != NodeStatus::RUNNING)
+        {
+            return status;
+        }
+        // it may also complete in this tick
+        stub.setStatus(NodeStatus::RUNNING);
+    }
+
+    if (status == NodeStatus::IDLE)
+    {
+        // ticked, but never again in the log: a divergence of the transition IDLE -> FAILURE
+        return NodeStatus::FAILURE;
+    }
+    return status;
+}
+
+void LogReplay::skipIdleResults(NodeTrack& track)
+{
+    if (track.next_result < track.next_transition)
+    {
+        track.next_result = track.next_transition;
+    }
+    while (track.next_result < track.transitions.size() &&
+           transitions_[track.transitions[track.next_result]].status == NodeStatus::IDLE)
+    {
+        track.next_result++;
+    }
+}
+
+void LogReplay::onTransition(size_t slot, NodeStatus prev_status, NodeStatus status)
+{
+    NodeTrack& track = tracks_[slot];
+    if (track.next_transition < track.transitions.size())
+    {
+        const size_t index = track.transitions[track.next_transition];
+        const LogTransition& expected = transitions_[index];
+        if (expected.prev_status == prev_status && expected.status == status)
+        {
+            track.next_transition++;
+            markReplayed(index);
+            replayed_count_++;
+            replayed_in_tick_ = true;
+            last_replayed_in_tick_ = std::max(last_replayed_in_tick_, index);
+            now_usec_ = std::max(now_usec_, expected.timestamp_usec);
+            return;
+        }
+    }
+
+    LogReplayDivergence divergence;
+    divergence.tick = tick_count_;
+    divergence.uid = track.log_uid;
+    divergence.node_name = track.node->name();
+    if (track.next_transition < track.transitions.size())
+    {
+        divergence.expected = transitions_[track.transitions[track.next_transition]];
+    }
+    const LogTransition actual = {now_usec_, track.log_uid, prev_status, status};
+    divergence.actual = actual;
+    divergences_.push_back(divergence);
+}
+
+void LogReplay::markReplayed(size_t index)
+{
+    replayed_[index] = true;
+    while (first_pending_ < replayed_.size() && replayed_[first_pending_])
+    {
+        first_pending_++;
+    }
+}
+
+void LogReplay::reportMissing(size_t index)
+{
+    NodeTrack& track = tracks_[transition_slot_[index]];
+
+    LogReplayDivergence divergence;
+    divergence.tick = tick_count_;
+    divergence.uid = track.log_uid;
+    divergence.node_name = track.node->name();
+    divergence.expected = transitions_[index];
+    divergences_.push_back(divergence);
+
+    // skip it, to follow the rest of the log
+    if (track.next_transition < track.transitions.size() &&
+        track.transitions[track.next_transition] == index)
+    {
+        track.next_transition++;
+        skipIdleResults(track);
+    }
+    markReplayed(index);
+}
+}
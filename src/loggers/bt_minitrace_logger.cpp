@@ -1,30 +1,60 @@
 
 #include "behaviortree_cpp/loggers/bt_minitrace_logger.h"
 #include "minitrace/minitrace.h"
+#include <mutex>
 
 namespace BT
 {
-std::atomic<bool> MinitraceLogger::ref_count(false);
+namespace
+{
+// the minitrace session is shared by all the instances
+struct MinitraceSession
+{
+    std::mutex mutex;
+    size_t instances = 0;
+    std::string filename;
+};
+
+MinitraceSession& session()
+{
+    static MinitraceSession session;
+    return session;
+}
+}
 
 MinitraceLogger::MinitraceLogger(TreeNode* root_node, const char* filename_json)
   : StatusChangeLogger(root_node)
 {
-    bool expected = false;
-    if (!ref_count.compare_exchange_strong(expected, true))
+    // don't receive callbacks before the session is initialized
+    setEnabled(false);
     {
-        throw std::logic_error("Only one instance of StdCoutLogger shall be created");
+        std::lock_guard<std::mutex> lock(session().mutex);
+        if (session().instances == 0)
+        {
+            minitrace::mtr_register_sigint_handler();
+            minitrace::mtr_init(filename_json);
+            session().filename = filename_json;
+        }
+        else if (session().filename != filename_json)
+        {
+            throw std::logic_error("All the instances of MinitraceLogger shall use the same "
+                                   "file. Already in use: " + session().filename);
+        }
+        session().instances++;
     }
-
-    minitrace::mtr_register_sigint_handler();
-    minitrace::mtr_init(filename_json);
     this->enableTransitionToIdle(true);
+    setEnabled(true);
 }
 
 MinitraceLogger::~MinitraceLogger()
 {
+    setEnabled(false);
+    std::lock_guard<std::mutex> lock(session().mutex);
     minitrace::mtr_flush();
-    minitrace::mtr_shutdown();
-	ref_count = false;
+    if (--session().instances == 0)
+    {
+        minitrace::mtr_shutdown();
+    }
 }
 
 void MinitraceLogger::callback(Duration /*timestamp*/,
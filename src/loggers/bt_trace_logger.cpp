@@ -0,0 +1,254 @@
+#include "behaviortree_cpp/loggers/bt_trace_logger.h"
+#include <unistd.h>
+
+namespace BT
+{
+namespace
+{
+// how often the writer thread writes the queued events into the file
+const std::chrono::milliseconds WRITE_PERIOD(20);
+
+// small and stable thread identifiers, shared by all the loggers of the process
+uint32_t threadLane()
+{
+    static std::atomic<uint32_t> next_lane(1);
+    static thread_local uint32_t lane = next_lane.fetch_add(1);
+    return lane;
+}
+
+std::string escapeJSON(const std::string& str)
+{
+    std::string out;
+    out.reserve(str.size());
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+}
+
+TraceLogger::TraceLogger(TreeNode* root_node, const char* filename_json,
+                         size_t queue_capacity)
+  : first_timestamp_(std::chrono::steady_clock::now())
+  , queue_(queue_capacity)
+  , dropped_(0)
+  , first_event_(true)
+  , tick_count_(0)
+  , flush_requests_(0)
+  , flushes_done_(0)
+  , stop_(false)
+{
+    file_ = fopen(filename_json, "w");
+    if (!file_)
+    {
+        throw std::runtime_error(std::string("TraceLogger: can't open the file ") +
+                                 filename_json);
+    }
+    buffer_ = "[";
+
+    applyRecursiveVisitor(root_node, [this](TreeNode* node) { nodes_.push_back(node); });
+    async_started_.reset(new uint32_t[nodes_.size()]());
+    async_completed_.reset(new uint32_t[nodes_.size()]());
+
+    writer_thread_ = std::thread(&TraceLogger::writerLoop, this);
+
+    for (size_t i = 0; i < nodes_.size(); i++)
+    {
+        nodes_[i]->addTickMonitor(this, i);
+    }
+}
+
+TraceLogger::~TraceLogger()
+{
+    for (TreeNode* node : nodes_)
+    {
+        node->removeTickMonitor(this);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    writer_cv_.notify_one();
+    writer_thread_.join();
+    fclose(file_);
+}
+
+void TraceLogger::push(const Event& event)
+{
+    if (!queue_.push(event))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TraceLogger::onTick(const TreeNode&, size_t slot, MonitorTime start,
+                         std::chrono::nanoseconds elapsed, NodeStatus status)
+{
+    const Event event = {EventType::TICK,
+                         status,
+                         static_cast<uint32_t>(slot),
+                         threadLane(),
+                         (start - first_timestamp_).count(),
+                         elapsed.count(),
+                         0};
+    push(event);
+}
+
+void TraceLogger::onAsyncStart(const TreeNode&, size_t slot)
+{
+    const uint64_t flow_id = (uint64_t(slot) << 32) | ++async_started_[slot];
+    const Event event = {EventType::FLOW_START,
+                         NodeStatus::IDLE,
+                         static_cast<uint32_t>(slot),
+                         threadLane(),
+                         (std::chrono::steady_clock::now() - first_timestamp_).count(),
+                         0,
+                         flow_id};
+    push(event);
+}
+
+void TraceLogger::onAsyncTick(const TreeNode&, size_t slot, MonitorTime start,
+                              std::chrono::nanoseconds elapsed, NodeStatus status)
+{
+    const Event event = {EventType::ASYNC_WORK,
+                         status,
+                         static_cast<uint32_t>(slot),
+                         threadLane(),
+                         (start - first_timestamp_).count(),
+                         elapsed.count(),
+                         (uint64_t(slot) << 32) | ++async_completed_[slot]};
+    push(event);
+}
+
+void TraceLogger::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    const uint64_t request = ++flush_requests_;
+    writer_cv_.notify_one();
+    flushed_cv_.wait(lock, [this, request]() { return flushes_done_ >= request || stop_; });
+}
+
+void TraceLogger::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        writer_cv_.wait_for(lock, WRITE_PERIOD,
+                            [this]() { return stop_ || flush_requests_ > flushes_done_; });
+        const bool stop = stop_;
+        const uint64_t flush_requests = flush_requests_;
+        lock.unlock();
+
+        Event event;
+        while (queue_.pop(event))
+        {
+            writeEvent(event);
+        }
+        if (stop)
+        {
+            buffer_ += "\n]\n";
+        }
+        fwrite(buffer_.data(), 1, buffer_.size(), file_);
+        fflush(file_);
+        buffer_.clear();
+
+        lock.lock();
+        flushes_done_ = flush_requests;
+        flushed_cv_.notify_all();
+        if (stop)
+        {
+            return;
+        }
+    }
+}
+
+void TraceLogger::beginEvent()
+{
+    // separators precede the events: what was written is valid, but for the closing bracket
+    buffer_ += first_event_ ? "\n" : ",\n";
+    first_event_ = false;
+}
+
+void TraceLogger::writeEvent(const Event& event)
+{
+    static const int pid = getpid();
+    const TreeNode* node = nodes_[event.slot];
+    char text[256];
+
+    if (event.thread >= named_threads_.size())
+    {
+        named_threads_.resize(event.thread + 1, false);
+    }
+    if (!named_threads_[event.thread])
+    {
+        named_threads_[event.thread] = true;
+        const std::string thread_name = event.type == EventType::ASYNC_WORK ?
+                                            "async " + escapeJSON(node->name()) :
+                                            "thread " + std::to_string(event.thread);
+        beginEvent();
+        buffer_ += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(pid) +
+                   ",\"tid\":" + std::to_string(event.thread) + ",\"args\":{\"name\":\"" +
+                   thread_name + "\"}}";
+    }
+
+    const double ts = event.start_ns * 1e-3;
+    switch (event.type)
+    {
+        case EventType::TICK:
+        case EventType::ASYNC_WORK:
+        {
+            beginEvent();
+            buffer_ += "{\"name\":\"" + escapeJSON(node->name()) + "\",\"cat\":\"" +
+                       toStr(node->type()) + "\",\"ph\":\"X\"";
+            snprintf(text, sizeof(text),
+                     ",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"uid\":%u,"
+                     "\"status\":\"%s\"",
+                     pid, event.thread, ts, event.duration_ns * 1e-3, unsigned(node->UID()),
+                     toStr(event.status, false));
+            buffer_ += text;
+            if (event.type == EventType::TICK && event.slot == 0)
+            {
+                buffer_ += ",\"tick\":" + std::to_string(tick_count_++);
+            }
+            buffer_ += "}}";
+
+            if (event.type == EventType::ASYNC_WORK)
+            {
+                // binds to the span that encloses it, i.e. the asynchronous work
+                snprintf(text, sizeof(text),
+                         "{\"name\":\"async\",\"cat\":\"flow\",\"ph\":\"f\",\"bp\":\"e\","
+                         "\"id\":%llu,\"pid\":%d,\"tid\":%u,\"ts\":%.3f}",
+                         static_cast<unsigned long long>(event.flow_id), pid, event.thread, ts);
+                beginEvent();
+                buffer_ += text;
+            }
+            break;
+        }
+        case EventType::FLOW_START:
+        {
+            snprintf(text, sizeof(text),
+                     "{\"name\":\"async\",\"cat\":\"flow\",\"ph\":\"s\",\"id\":%llu,"
+                     "\"pid\":%d,\"tid\":%u,\"ts\":%.3f}",
+                     static_cast<unsigned long long>(event.flow_id), pid, event.thread, ts);
+            beginEvent();
+            buffer_ += text;
+            break;
+        }
+    }
+}
+}
@@ -1,162 +1,424 @@
 #include "behaviortree_cpp/loggers/bt_zmq_publisher.h"
 #include "behaviortree_cpp/loggers/bt_flatbuffer_helper.h"
-#include <future>
+#include "behaviortree_cpp/mpsc_queue.h"
+#include <condition_variable>
+#include <map>
+#include <thread>
+#include <unordered_map>
 #include <zmq.hpp>
 
 namespace BT
 {
-std::atomic<bool> PublisherZMQ::ref_count(false);
+// transitions that can be received between two iterations of the sender thread
+static const size_t QUEUE_CAPACITY = 16384;
 
-struct PublisherZMQ::Pimpl
+constexpr uint8_t PublisherHub::MULTI_TREE_PROTOCOL_VERSION;
+
+namespace
+{
+struct QueuedTransition
+{
+    uint16_t tree_id;
+    SerializedTransition transition;
+};
+
+struct TreeState
 {
-    Pimpl():
-        context(1)
+    std::vector<uint8_t> tree_buffer;
+    std::chrono::microseconds min_time_between_msgs;
+    std::chrono::microseconds keyframe_period;
+
+    std::vector<SerializedTransition> transition_buffer;
+    std::vector<std::pair<uint16_t, int8_t>> statuses;
+    std::vector<bool> changed;
+    std::unordered_map<uint16_t, size_t> status_index;
+
+    // read only after a transition was dropped
+    std::vector<const TreeNode*> nodes;
+    std::atomic<bool>* resync;
+    bool keyframe_requested = false;
+
+    TimePoint last_message;
+    TimePoint last_keyframe;
+    bool removed = false;
+};
+}
+
+struct PublisherHub::Pimpl
+{
+    Pimpl(bool multi_tree):
+        multi_tree(multi_tree)
+      , context(1)
       , publisher(context, ZMQ_PUB)
       , server(context, ZMQ_REP)
+      , queue(QUEUE_CAPACITY)
+      , next_tree_id(0)
+      , stop(false)
+      , flush_requested(false)
     {}
 
+    const bool multi_tree;
     zmq::context_t context;
     zmq::socket_t publisher;
     zmq::socket_t server;
+
+    MPSCQueue<QueuedTransition> queue;
+
+    // protects the following members
+    std::mutex mutex;
+    std::condition_variable sender_cv;
+    std::condition_variable removed_cv;
+    std::map<uint16_t, std::unique_ptr<TreeState>> trees;
+    uint16_t next_tree_id;
+    bool stop;
+    bool flush_requested;
+
+    std::thread sender_thread;
+    std::thread server_thread;
+
+    // used only by the sender thread
+    std::vector<uint8_t> status_buffer;
+
+    void senderLoop();
+
+    void serverLoop();
+
+    void sendMessage(uint16_t tree_id, TreeState& tree, bool keyframe);
 };
 
+PublisherHub::PublisherHub(int publisher_port, int server_port, bool multi_tree)
+  : _p(new Pimpl(multi_tree))
+{
+    _p->publisher.bind("tcp://*:" + std::to_string(publisher_port));
+    _p->server.bind("tcp://*:" + std::to_string(server_port));
 
-PublisherZMQ::PublisherZMQ(TreeNode* root_node, int max_msg_per_second)
-  : StatusChangeLogger(root_node)
-  , root_node_(root_node)
-  , min_time_between_msgs_(std::chrono::microseconds(1000 * 1000) / max_msg_per_second)
-  , send_pending_(false)
-  , zmq_(new Pimpl())
+    _p->server_thread = std::thread(&Pimpl::serverLoop, _p.get());
+    _p->sender_thread = std::thread(&Pimpl::senderLoop, _p.get());
+}
+
+PublisherHub::~PublisherHub()
 {
-    static bool first_instance = true;
-    if (first_instance)
     {
-        first_instance = false;
+        std::unique_lock<std::mutex> lock(_p->mutex);
+        _p->stop = true;
     }
-    else
+    _p->sender_cv.notify_one();
+    _p->sender_thread.join();   // the pending transitions are sent before returning
+
+    // unblock the recv() of the server thread
+    zmq_ctx_shutdown(static_cast<void*>(_p->context));
+    _p->server_thread.join();
+}
+
+std::shared_ptr<PublisherHub> PublisherHub::defaultHub()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<PublisherHub> default_hub;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    std::shared_ptr<PublisherHub> hub = default_hub.lock();
+    if (!hub)
     {
-        throw std::logic_error("Only one instance of PublisherZMQ shall be created");
+        hub = std::make_shared<PublisherHub>();
+        default_hub = hub;
     }
+    return hub;
+}
+
+uint16_t PublisherHub::addTree(TreeNode* root_node,
+                               std::chrono::microseconds min_time_between_msgs,
+                               std::chrono::microseconds keyframe_period,
+                               std::atomic<bool>* resync)
+{
+    std::unique_ptr<TreeState> tree(new TreeState);
+    tree->min_time_between_msgs = min_time_between_msgs;
+    tree->keyframe_period = keyframe_period;
+    tree->resync = resync;
 
     flatbuffers::FlatBufferBuilder builder(1024);
     CreateFlatbuffersBehaviorTree(builder, root_node);
+    tree->tree_buffer.assign(builder.GetBufferPointer(),
+                             builder.GetBufferPointer() + builder.GetSize());
+
+    // the tree is visited only here; later, statuses are updated from the transitions
+    applyRecursiveVisitor(root_node, [&tree](TreeNode* node) {
+        tree->nodes.push_back(node);
+        tree->status_index[node->UID()] = tree->statuses.size();
+        tree->statuses.push_back(
+            {node->UID(), static_cast<int8_t>(convertToFlatbuffers(node->status()))});
+    });
+    tree->changed.resize(tree->statuses.size(), false);
 
-    tree_buffer_.resize(builder.GetSize());
-    memcpy(tree_buffer_.data(), builder.GetBufferPointer(), builder.GetSize());
+    std::unique_lock<std::mutex> lock(_p->mutex);
+    if (!_p->multi_tree && !_p->trees.empty())
+    {
+        throw std::logic_error("Only one instance of PublisherZMQ shall be created, "
+                               "unless they share a multi-tree PublisherHub");
+    }
+    while (_p->trees.count(_p->next_tree_id))
+    {
+        _p->next_tree_id++;
+    }
+    const uint16_t tree_id = _p->next_tree_id++;
+    _p->trees[tree_id] = std::move(tree);
+    return tree_id;
+}
 
-    zmq_->publisher.bind("tcp://*:1666");
-    zmq_->server.bind("tcp://*:1667");
+void PublisherHub::removeTree(uint16_t tree_id)
+{
+    std::unique_lock<std::mutex> lock(_p->mutex);
+    auto it = _p->trees.find(tree_id);
+    if (it == _p->trees.end())
+    {
+        return;
+    }
+    it->second->removed = true;
+    _p->flush_requested = true;
+    _p->sender_cv.notify_one();
+    _p->removed_cv.wait(lock, [this, tree_id]() { return _p->trees.count(tree_id) == 0; });
+}
 
-    int timeout_ms = 100;
-    zmq_->server.setsockopt(ZMQ_RCVTIMEO, &timeout_ms, sizeof(int));
+bool PublisherHub::push(uint16_t tree_id, const SerializedTransition& transition)
+{
+    QueuedTransition queued = {tree_id, transition};
+    return _p->queue.push(queued);
+}
 
-    active_server_ = true;
+void PublisherHub::flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(_p->mutex);
+        _p->flush_requested = true;
+    }
+    _p->sender_cv.notify_one();
+}
 
-    thread_ = std::thread([this]() {
-        while (active_server_)
+void PublisherHub::Pimpl::serverLoop()
+{
+    while (true)
+    {
+        zmq::message_t req;
+        try
         {
-            zmq::message_t req;
-            try
+            // blocking: it returns when a request arrives or the context is shut down
+            if (!server.recv(&req))
             {
-                bool received = zmq_->server.recv(&req);
-                if (received)
+                continue;
+            }
+            zmq::message_t reply;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                auto it = trees.end();
+                const uint8_t* req_data = static_cast<const uint8_t*>(req.data());
+                if (!multi_tree || req.size() == 0)
+                {
+                    it = trees.begin();
+                }
+                else if (req.size() == 3 && req_data[0] == MULTI_TREE_PROTOCOL_VERSION)
                 {
-                    zmq::message_t reply(tree_buffer_.size());
-                    memcpy(reply.data(), tree_buffer_.data(), tree_buffer_.size());
-                    zmq_->server.send(reply);
+                    it = trees.find(flatbuffers::ReadScalar<uint16_t>(req_data + 1));
+                }
+                if (it != trees.end())
+                {
+                    const std::vector<uint8_t>& buffer = it->second->tree_buffer;
+                    reply.rebuild(buffer.size());
+                    memcpy(reply.data(), buffer.data(), buffer.size());
                 }
             }
-            catch (zmq::error_t& err)
+            server.send(reply);
+        }
+        catch (zmq::error_t& err)
+        {
+            if (err.num() != ETERM)
             {
                 std::cout << "[PublisherZMQ] just died. Exeption " << err.what() << std::endl;
-                active_server_ = false;
             }
+            return;
         }
-    });
+    }
+}
+
+void PublisherHub::Pimpl::senderLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        // wake up as often as the fastest tree
+        std::chrono::microseconds period(std::chrono::milliseconds(100));
+        for (const auto& it : trees)
+        {
+            period = std::min(period, it.second->min_time_between_msgs);
+        }
+        sender_cv.wait_for(lock, period, [this]() { return stop || flush_requested; });
+        const bool flush = stop || flush_requested;
+        flush_requested = false;
 
-    createStatusBuffer();
+        QueuedTransition queued;
+        while (queue.pop(queued))
+        {
+            auto tree_it = trees.find(queued.tree_id);
+            if (tree_it == trees.end())
+            {
+                continue;
+            }
+            TreeState& tree = *tree_it->second;
+            tree.transition_buffer.push_back(queued.transition);
+
+            const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&queued.transition[8]);
+            auto it = tree.status_index.find(uid);
+            if (it != tree.status_index.end())
+            {
+                tree.statuses[it->second].second =
+                    flatbuffers::ReadScalar<int8_t>(&queued.transition[11]);
+                tree.changed[it->second] = true;
+            }
+        }
+
+        const TimePoint now = std::chrono::high_resolution_clock::now();
+        bool removed = false;
+
+        for (auto it = trees.begin(); it != trees.end();)
+        {
+            TreeState& tree = *it->second;
+            if (tree.resync->exchange(false))
+            {
+                // the transitions still queued are newer, and applied later
+                for (size_t i = 0; i < tree.nodes.size(); i++)
+                {
+                    tree.statuses[i].second =
+                        static_cast<int8_t>(convertToFlatbuffers(tree.nodes[i]->status()));
+                }
+                tree.keyframe_requested = true;
+            }
+            const bool keyframe = tree.keyframe_requested ||
+                                  (now - tree.last_keyframe) >= tree.keyframe_period;
+            const bool due = flush || (now - tree.last_message) >= tree.min_time_between_msgs;
+
+            if (due && (keyframe || !tree.transition_buffer.empty()))
+            {
+                try
+                {
+                    sendMessage(it->first, tree, keyframe);
+                }
+                catch (zmq::error_t& err)
+                {
+                    std::cout << "[PublisherZMQ] send failed: " << err.what() << std::endl;
+                }
+                tree.last_message = now;
+                if (keyframe)
+                {
+                    tree.last_keyframe = now;
+                    tree.keyframe_requested = false;
+                }
+            }
+
+            if (tree.removed)
+            {
+                it = trees.erase(it);
+                removed = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        if (removed)
+        {
+            removed_cv.notify_all();
+        }
+        if (stop)
+        {
+            return;
+        }
+    }
 }
 
-PublisherZMQ::~PublisherZMQ()
+void PublisherHub::Pimpl::sendMessage(uint16_t tree_id, TreeState& tree, bool keyframe)
 {
-    active_server_ = false;
-    if (thread_.joinable())
+    status_buffer.clear();
+    for (size_t i = 0; i < tree.statuses.size(); i++)
     {
-        thread_.join();
+        if (keyframe || tree.changed[i])
+        {
+            size_t index = status_buffer.size();
+            status_buffer.resize(index + 3);
+            flatbuffers::WriteScalar<uint16_t>(&status_buffer[index], tree.statuses[i].first);
+            flatbuffers::WriteScalar<int8_t>(&status_buffer[index + 2], tree.statuses[i].second);
+            tree.changed[i] = false;
+        }
     }
-    flush();
-    delete zmq_;
-	ref_count = false;
+
+    const size_t msg_size = status_buffer.size() + 8 + (tree.transition_buffer.size() * 12);
+
+    zmq::message_t message(msg_size);
+    uint8_t* data_ptr = static_cast<uint8_t*>(message.data());
+
+    // first 4 bytes are the side of the header
+    flatbuffers::WriteScalar<uint32_t>(data_ptr, status_buffer.size());
+    data_ptr += sizeof(uint32_t);
+    // copy the header part
+    memcpy(data_ptr, status_buffer.data(), status_buffer.size());
+    data_ptr += status_buffer.size();
+
+    // first 4 bytes are the side of the transition buffer
+    flatbuffers::WriteScalar<uint32_t>(data_ptr, tree.transition_buffer.size());
+    data_ptr += sizeof(uint32_t);
+
+    for (auto& transition : tree.transition_buffer)
+    {
+        memcpy(data_ptr, transition.data(), transition.size());
+        data_ptr += transition.size();
+    }
+    tree.transition_buffer.clear();
+
+    if (multi_tree)
+    {
+        zmq::message_t id_frame(3);
+        uint8_t* id_ptr = static_cast<uint8_t*>(id_frame.data());
+        id_ptr[0] = MULTI_TREE_PROTOCOL_VERSION;
+        flatbuffers::WriteScalar<uint16_t>(id_ptr + 1, tree_id);
+        publisher.send(id_frame, ZMQ_SNDMORE);
+    }
+    publisher.send(message);
 }
 
+//--------------------------------------------
 
-void PublisherZMQ::createStatusBuffer()
+PublisherZMQ::PublisherZMQ(TreeNode* root_node, int max_msg_per_second,
+                           std::chrono::milliseconds keyframe_period,
+                           std::shared_ptr<PublisherHub> hub)
+  : StatusChangeLogger(root_node)
+  , hub_(hub ? std::move(hub) : PublisherHub::defaultHub())
+  , dropped_(0)
+  , resync_(false)
 {
-    status_buffer_.clear();
-    applyRecursiveVisitor(root_node_, [this](TreeNode* node) {
-        size_t index = status_buffer_.size();
-        status_buffer_.resize(index + 3);
-        flatbuffers::WriteScalar<uint16_t>(&status_buffer_[index], node->UID());
-        flatbuffers::WriteScalar<int8_t>(&status_buffer_[index + 2],
-                                         static_cast<int8_t>(convertToFlatbuffers(node->status())));
-    });
+    tree_id_ = hub_->addTree(root_node,
+                             std::chrono::microseconds(1000 * 1000) / max_msg_per_second,
+                             keyframe_period, &resync_);
+}
+
+PublisherZMQ::~PublisherZMQ()
+{
+    setEnabled(false);
+    hub_->removeTree(tree_id_);
 }
 
 void PublisherZMQ::callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
                             NodeStatus status)
 {
-    using namespace std::chrono;
-
     SerializedTransition transition =
         SerializeTransition(node.UID(), timestamp, prev_status, status);
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        transition_buffer_.push_back(transition);
-    }
 
-    if (!send_pending_)
+    if (!hub_->push(tree_id_, transition))
     {
-        send_pending_ = true;
-        send_future_ = std::async(std::launch::async, [this]() {
-            std::this_thread::sleep_for(min_time_between_msgs_);
-            flush();
-        });
+        // the statuses of the sender are stale from now on
+        dropped_++;
+        resync_ = true;
     }
 }
 
 void PublisherZMQ::flush()
 {
-    zmq::message_t message;
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-
-        const size_t msg_size = status_buffer_.size() + 8 + (transition_buffer_.size() * 12);
-
-        message.rebuild(msg_size);
-        uint8_t* data_ptr = static_cast<uint8_t*>(message.data());
-
-        // first 4 bytes are the side of the header
-        flatbuffers::WriteScalar<uint32_t>(data_ptr, status_buffer_.size());
-        data_ptr += sizeof(uint32_t);
-        // copy the header part
-        memcpy(data_ptr, status_buffer_.data(), status_buffer_.size());
-        data_ptr += status_buffer_.size();
-
-        // first 4 bytes are the side of the transition buffer
-        flatbuffers::WriteScalar<uint32_t>(data_ptr, transition_buffer_.size());
-        data_ptr += sizeof(uint32_t);
-
-        for (auto& transition : transition_buffer_)
-        {
-            memcpy(data_ptr, transition.data(), transition.size());
-            data_ptr += transition.size();
-        }
-        transition_buffer_.clear();
-        createStatusBuffer();
-    }
-
-    zmq_->publisher.send(message);
-    send_pending_ = false;
-    // printf("%.3f zmq send\n", std::chrono::duration<double>( std::chrono::high_resolution_clock::now().time_since_epoch() ).count());
+    hub_->flush();
 }
 }
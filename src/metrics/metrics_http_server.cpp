@@ -0,0 +1,151 @@
+#include "behaviortree_cpp/metrics/metrics_http_server.h"
+#include "behaviortree_cpp/exceptions.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace BT
+{
+namespace
+{
+// how often the server thread checks whether it must stop
+const int POLL_TIMEOUT_MS = 100;
+const size_t MAX_REQUEST_SIZE = 8192;
+
+void sendAll(int fd, const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        const ssize_t ret = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (ret <= 0)
+        {
+            return;
+        }
+        sent += static_cast<size_t>(ret);
+    }
+}
+
+std::string httpResponse(const char* status, const char* content_type, const std::string& body)
+{
+    return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + content_type +
+           "\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\nConnection: close\r\n\r\n" + body;
+}
+}
+
+MetricsHttpServer::MetricsHttpServer(const MetricsRegistry& registry, int port,
+                                     const std::string& address)
+  : registry_(registry), socket_fd_(-1), port_(port), stop_(false)
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1)
+    {
+        throw BehaviorTreeException("MetricsHttpServer: invalid address " + address);
+    }
+
+    socket_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (socket_fd_ < 0)
+    {
+        throw BehaviorTreeException("MetricsHttpServer: can't create the socket");
+    }
+    const int enable = 1;
+    setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    if (::bind(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(socket_fd_, 16) != 0)
+    {
+        const std::string error = strerror(errno);
+        ::close(socket_fd_);
+        throw BehaviorTreeException("MetricsHttpServer: can't listen on " + address + ":" +
+                                    std::to_string(port) + ": " + error);
+    }
+
+    socklen_t addr_len = sizeof(addr);
+    if (::getsockname(socket_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0)
+    {
+        port_ = ntohs(addr.sin_port);
+    }
+
+    thread_ = std::thread(&MetricsHttpServer::serverLoop, this);
+}
+
+MetricsHttpServer::~MetricsHttpServer()
+{
+    stop_ = true;
+    thread_.join();
+    ::close(socket_fd_);
+}
+
+void MetricsHttpServer::serverLoop()
+{
+    while (!stop_)
+    {
+        pollfd pfd = {socket_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0)
+        {
+            continue;
+        }
+        const int client_fd = ::accept(socket_fd_, nullptr, nullptr);
+        if (client_fd < 0)
+        {
+            continue;
+        }
+        serveClient(client_fd);
+        ::close(client_fd);
+    }
+}
+
+void MetricsHttpServer::serveClient(int client_fd)
+{
+    // a slow client must not block the server forever
+    timeval timeout = {1, 0};
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE)
+    {
+        const ssize_t ret = ::recv(client_fd, buffer, sizeof(buffer), 0);
+        if (ret <= 0)
+        {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(ret));
+    }
+
+    const size_t method_end = request.find(' ');
+    const size_t path_end = request.find_first_of(" ?", method_end + 1);
+    if (method_end == std::string::npos || path_end == std::string::npos)
+    {
+        sendAll(client_fd, httpResponse("400 Bad Request", "text/plain", "Bad Request\n"));
+        return;
+    }
+    const std::string method = request.substr(0, method_end);
+    const std::string path = request.substr(method_end + 1, path_end - method_end - 1);
+
+    if (method != "GET")
+    {
+        sendAll(client_fd,
+                httpResponse("405 Method Not Allowed", "text/plain", "Method Not Allowed\n"));
+    }
+    else if (path != "/metrics")
+    {
+        sendAll(client_fd, httpResponse("404 Not Found", "text/plain", "Not Found\n"));
+    }
+    else
+    {
+        sendAll(client_fd,
+                httpResponse("200 OK",
+                             "application/openmetrics-text; version=1.0.0; charset=utf-8",
+                             registry_.scrape()));
+    }
+}
+}
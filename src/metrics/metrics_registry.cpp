@@ -0,0 +1,373 @@
+#include "behaviortree_cpp/metrics/metrics_registry.h"
+#include "behaviortree_cpp/exceptions.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <unistd.h>
+
+namespace BT
+{
+namespace
+{
+void addDouble(std::atomic<double>& target, double value)
+{
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+    {
+    }
+}
+
+std::string formatDouble(double value)
+{
+    if (std::isinf(value))
+    {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    if (std::isnan(value))
+    {
+        return "NaN";
+    }
+    // shortest representation that can be parsed back to the same value
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.15g", value);
+    if (strtod(buffer, nullptr) != value)
+    {
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    return buffer;
+}
+
+std::string escapeLabelValue(const std::string& value)
+{
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value)
+    {
+        switch (c)
+        {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '"':
+                out += "\\\"";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            default:
+                out += c;
+        }
+    }
+    return out;
+}
+
+std::string formatLabels(const MetricLabels& labels)
+{
+    std::string out;
+    for (const auto& label : labels)
+    {
+        if (!out.empty())
+        {
+            out += ',';
+        }
+        out += label.first + "=\"" + escapeLabelValue(label.second) + "\"";
+    }
+    return out;
+}
+
+// "name{labels,extra} "
+void writeSampleName(std::ostream& os, const std::string& name, const std::string& labels,
+                     const std::string& extra = std::string())
+{
+    os << name;
+    if (!labels.empty() || !extra.empty())
+    {
+        os << '{' << labels;
+        if (!labels.empty() && !extra.empty())
+        {
+            os << ',';
+        }
+        os << extra << '}';
+    }
+    os << ' ';
+}
+
+const char* typeName(MetricType type)
+{
+    switch (type)
+    {
+        case MetricType::COUNTER:
+            return "counter";
+        case MetricType::GAUGE:
+            return "gauge";
+        case MetricType::HISTOGRAM:
+            return "histogram";
+    }
+    return "unknown";
+}
+}
+
+const size_t ShardedCounter::SHARDS;
+
+ShardedCounter::ShardedCounter()
+{
+    for (auto& cell : cells_)
+    {
+        cell.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ShardedCounter::sum() const
+{
+    uint64_t total = 0;
+    for (const auto& cell : cells_)
+    {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t ShardedCounter::shardIndex()
+{
+    // threads are assigned to the shards in round robin, the first time they write
+    static std::atomic<size_t> next_index(0);
+    static thread_local size_t index = next_index.fetch_add(1) % SHARDS;
+    return index;
+}
+
+void Counter::write(std::ostream& os, const std::string& name, const std::string& labels) const
+{
+    writeSampleName(os, name + "_total", labels);
+    os << value() << '\n';
+}
+
+void Gauge::add(double value)
+{
+    addDouble(value_, value);
+}
+
+void Gauge::write(std::ostream& os, const std::string& name, const std::string& labels) const
+{
+    writeSampleName(os, name, labels);
+    os << formatDouble(value()) << '\n';
+}
+
+Histogram::Histogram(const std::vector<double>& bounds)
+  : bounds_(bounds), buckets_(new ShardedCounter[bounds.size() + 1])
+{
+    if (!std::is_sorted(bounds_.begin(), bounds_.end()))
+    {
+        throw BehaviorTreeException("Histogram: the bounds must be sorted");
+    }
+    for (auto& sum : sums_)
+    {
+        sum.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double value)
+{
+    const size_t index =
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    buckets_[index].add(1);
+    addDouble(sums_[ShardedCounter::shardIndex()].value, value);
+}
+
+std::vector<uint64_t> Histogram::bucketCounts() const
+{
+    std::vector<uint64_t> counts(bounds_.size() + 1);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        cumulative += buckets_[i].sum();
+        counts[i] = cumulative;
+    }
+    return counts;
+}
+
+uint64_t Histogram::count() const
+{
+    return bucketCounts().back();
+}
+
+double Histogram::sum() const
+{
+    double total = 0;
+    for (const auto& sum : sums_)
+    {
+        total += sum.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Histogram::write(std::ostream& os, const std::string& name, const std::string& labels) const
+{
+    const std::vector<uint64_t> counts = bucketCounts();
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        const double bound =
+            i < bounds_.size() ? bounds_[i] : std::numeric_limits<double>::infinity();
+        writeSampleName(os, name + "_bucket", labels, "le=\"" + formatDouble(bound) + "\"");
+        os << counts[i] << '\n';
+    }
+    writeSampleName(os, name + "_count", labels);
+    os << counts.back() << '\n';
+    writeSampleName(os, name + "_sum", labels);
+    os << formatDouble(sum()) << '\n';
+}
+
+void CallbackMetric::write(std::ostream& os, const std::string& name,
+                           const std::string& labels) const
+{
+    writeSampleName(os, type_ == MetricType::COUNTER ? name + "_total" : name, labels);
+    os << formatDouble(callback_()) << '\n';
+}
+
+//--------------------------------------------
+
+MetricsRegistry& MetricsRegistry::global()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+Metric& MetricsRegistry::getOrCreate(const std::string& name, const std::string& help,
+                                     MetricType type, const MetricLabels& labels,
+                                     const std::function<Metric*()>& create)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto family_it = families_.find(name);
+    if (family_it == families_.end())
+    {
+        family_it = families_.insert({name, Family()}).first;
+        family_it->second.type = type;
+        family_it->second.help = help;
+    }
+    else if (family_it->second.type != type)
+    {
+        throw BehaviorTreeException("Metric [" + name + "] was registered with type " +
+                                    typeName(family_it->second.type));
+    }
+
+    std::unique_ptr<Metric>& metric = family_it->second.series[formatLabels(labels)];
+    if (!metric)
+    {
+        metric.reset(create());
+    }
+    return *metric;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                  const MetricLabels& labels)
+{
+    Metric& metric = getOrCreate(name, help, MetricType::COUNTER, labels,
+                                 []() { return new Counter(); });
+    Counter* counter = dynamic_cast<Counter*>(&metric);
+    if (!counter)
+    {
+        throw BehaviorTreeException("Metric [" + name + "] is a callback");
+    }
+    return *counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                              const MetricLabels& labels)
+{
+    Metric& metric =
+        getOrCreate(name, help, MetricType::GAUGE, labels, []() { return new Gauge(); });
+    Gauge* gauge = dynamic_cast<Gauge*>(&metric);
+    if (!gauge)
+    {
+        throw BehaviorTreeException("Metric [" + name + "] is a callback");
+    }
+    return *gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                      const std::vector<double>& bounds,
+                                      const MetricLabels& labels)
+{
+    Metric& metric = getOrCreate(name, help, MetricType::HISTOGRAM, labels,
+                                 [&bounds]() { return new Histogram(bounds); });
+    return static_cast<Histogram&>(metric);
+}
+
+void MetricsRegistry::addCallback(const std::string& name, const std::string& help,
+                                  MetricType type, const MetricLabels& labels,
+                                  std::function<double()> callback)
+{
+    if (type == MetricType::HISTOGRAM)
+    {
+        throw BehaviorTreeException("Metric [" + name + "]: histograms can't be callbacks");
+    }
+    remove(name, labels);
+    getOrCreate(name, help, type, labels,
+                [&]() { return new CallbackMetric(type, std::move(callback)); });
+}
+
+void MetricsRegistry::remove(const std::string& name, const MetricLabels& labels)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto family_it = families_.find(name);
+    if (family_it == families_.end())
+    {
+        return;
+    }
+    family_it->second.series.erase(formatLabels(labels));
+    if (family_it->second.series.empty())
+    {
+        families_.erase(family_it);
+    }
+}
+
+void MetricsRegistry::write(std::ostream& os) const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (const auto& family_it : families_)
+    {
+        const std::string& name = family_it.first;
+        const Family& family = family_it.second;
+        os << "# TYPE " << name << ' ' << typeName(family.type) << '\n';
+        if (!family.help.empty())
+        {
+            os << "# HELP " << name << ' ' << family.help << '\n';
+        }
+        for (const auto& series : family.series)
+        {
+            series.second->write(os, name, series.first);
+        }
+    }
+    os << "# EOF\n";
+}
+
+std::string MetricsRegistry::scrape() const
+{
+    std::ostringstream os;
+    write(os);
+    return os.str();
+}
+
+void MetricsRegistry::writeFile(const std::string& filename) const
+{
+    const std::string temp_filename = filename + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream file(temp_filename);
+        write(file);
+        file.close();
+        if (!file)
+        {
+            std::remove(temp_filename.c_str());
+            throw BehaviorTreeException("Can't write the metrics into " + temp_filename);
+        }
+    }
+    if (std::rename(temp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(temp_filename.c_str());
+        throw BehaviorTreeException("Can't write the metrics into " + filename);
+    }
+}
+}
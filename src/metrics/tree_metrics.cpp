@@ -0,0 +1,114 @@
+#include "behaviortree_cpp/metrics/tree_metrics.h"
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/behavior_tree.h"
+
+namespace BT
+{
+namespace
+{
+MetricLabels withStatus(const MetricLabels& labels, const char* status)
+{
+    MetricLabels out = labels;
+    out.push_back({"status", status});
+    return out;
+}
+
+const char* TICKS_HELP = "Ticks of the root node.";
+}
+
+TreeMetrics::TreeMetrics(MetricsRegistry& registry, TreeNode* root_node,
+                         const std::string& tree_name, std::chrono::microseconds tick_period)
+  : registry_(registry)
+  , root_node_(root_node)
+  , labels_({{"tree", tree_name}})
+  , tick_period_(tick_period)
+  , success_(registry.counter("bt_tree_ticks", TICKS_HELP, withStatus(labels_, "success")))
+  , failure_(registry.counter("bt_tree_ticks", TICKS_HELP, withStatus(labels_, "failure")))
+  , running_(registry.counter("bt_tree_ticks", TICKS_HELP, withStatus(labels_, "running")))
+  , overruns_(registry.counter("bt_tree_tick_overruns", "Ticks longer than the tick period.",
+                               labels_))
+  , duration_(registry.histogram("bt_tree_tick_duration_seconds",
+                                 "Duration of the ticks of the root node.", durationBuckets(),
+                                 labels_))
+{
+    applyRecursiveVisitor(root_node, [this](TreeNode* node) {
+        nodes_.push_back(node);
+        if (dynamic_cast<AsyncActionNode*>(node) || dynamic_cast<CoroActionNode*>(node))
+        {
+            async_nodes_.push_back(node);
+        }
+    });
+
+    registry_.addCallback("bt_tree_running_nodes", "Nodes in state RUNNING.",
+                          MetricType::GAUGE, labels_, [this]() {
+                              size_t count = 0;
+                              for (const TreeNode* node : nodes_)
+                              {
+                                  count += (node->status() == NodeStatus::RUNNING);
+                              }
+                              return double(count);
+                          });
+
+    registry_.addCallback("bt_tree_async_actions_running",
+                          "Asynchronous actions in state RUNNING.", MetricType::GAUGE, labels_,
+                          [this]() {
+                              size_t count = 0;
+                              for (const TreeNode* node : async_nodes_)
+                              {
+                                  count += (node->status() == NodeStatus::RUNNING);
+                              }
+                              return double(count);
+                          });
+}
+
+TreeMetrics::~TreeMetrics()
+{
+    // the callbacks refer to this object; the counters are kept
+    registry_.remove("bt_tree_running_nodes", labels_);
+    registry_.remove("bt_tree_async_actions_running", labels_);
+}
+
+NodeStatus TreeMetrics::tick()
+{
+    const auto start = std::chrono::steady_clock::now();
+    const NodeStatus status = root_node_->executeTick();
+    recordTick(std::chrono::steady_clock::now() - start, status);
+    return status;
+}
+
+void TreeMetrics::recordTick(std::chrono::nanoseconds elapsed, NodeStatus status)
+{
+    switch (status)
+    {
+        case NodeStatus::SUCCESS:
+            success_.inc();
+            break;
+        case NodeStatus::FAILURE:
+            failure_.inc();
+            break;
+        case NodeStatus::RUNNING:
+            running_.inc();
+            break;
+        default:
+            break;
+    }
+    duration_.observe(std::chrono::duration<double>(elapsed).count());
+    if (tick_period_.count() > 0 && elapsed > tick_period_)
+    {
+        overruns_.inc();
+    }
+}
+
+void TreeMetrics::recordOverrun()
+{
+    overruns_.inc();
+}
+
+const std::vector<double>& TreeMetrics::durationBuckets()
+{
+    static const std::vector<double> buckets = {
+        10e-6, 25e-6, 50e-6, 100e-6, 250e-6, 500e-6, 1e-3, 2.5e-3, 5e-3, 10e-3,
+        25e-3, 50e-3, 100e-3, 250e-3, 500e-3, 1.0,    2.5,  5.0,    10.0};
+    return buckets;
+}
+}
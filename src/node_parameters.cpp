@@ -0,0 +1,196 @@
+#include "behaviortree_cpp/node_parameters.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace BT
+{
+struct NodeParameters::Pool
+{
+    struct Hash
+    {
+        size_t operator()(const InternedEntry* entry) const
+        {
+            std::hash<std::string> hasher;
+            return hasher(entry->value.first) ^ (hasher(entry->value.second) * 31);
+        }
+    };
+
+    struct Equal
+    {
+        bool operator()(const InternedEntry* a, const InternedEntry* b) const
+        {
+            return a->value == b->value;
+        }
+    };
+
+    std::mutex mutex;
+    std::unordered_set<InternedEntry*, Hash, Equal> entries;
+
+    static Pool& instance()
+    {
+        // never destroyed: a static NodeParameters may be released after it
+        static Pool* pool = new Pool;
+        return *pool;
+    }
+};
+
+const NodeParameters::InternedEntry* NodeParameters::intern(StringView key, StringView value)
+{
+    InternedEntry probe;
+    probe.value.first.assign(key.data(), key.size());
+    probe.value.second.assign(value.data(), value.size());
+
+    Pool& pool = Pool::instance();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    auto it = pool.entries.find(&probe);
+    if (it != pool.entries.end())
+    {
+        (*it)->references.fetch_add(1, std::memory_order_relaxed);
+        return *it;
+    }
+    InternedEntry* entry = new InternedEntry;
+    entry->value = std::move(probe.value);
+    entry->references.store(1, std::memory_order_relaxed);
+    pool.entries.insert(entry);
+    return entry;
+}
+
+void NodeParameters::release(const InternedEntry* entry)
+{
+    // Only the last reference is released under the lock: intern() can't find
+    // an entry whose count already reached zero.
+    unsigned count = entry->references.load(std::memory_order_relaxed);
+    while (count > 1)
+    {
+        if (entry->references.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel))
+        {
+            return;
+        }
+    }
+    Pool& pool = Pool::instance();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if (entry->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        InternedEntry* erased = const_cast<InternedEntry*>(entry);
+        pool.entries.erase(erased);
+        delete erased;
+    }
+}
+
+size_t NodeParameters::internedCount()
+{
+    Pool& pool = Pool::instance();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.entries.size();
+}
+
+NodeParameters::NodeParameters(std::initializer_list<value_type> init)
+{
+    entries_.reserve(init.size());
+    for (const auto& it : init)
+    {
+        set(it.first, it.second);
+    }
+}
+
+NodeParameters::NodeParameters(const NodeParameters& other) : entries_(other.entries_)
+{
+    for (const InternedEntry* entry : entries_)
+    {
+        entry->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+NodeParameters::NodeParameters(NodeParameters&& other) noexcept
+  : entries_(std::move(other.entries_))
+{
+    other.entries_.clear();
+}
+
+NodeParameters& NodeParameters::operator=(const NodeParameters& other)
+{
+    NodeParameters copy(other);
+    entries_.swap(copy.entries_);
+    return *this;
+}
+
+NodeParameters& NodeParameters::operator=(NodeParameters&& other) noexcept
+{
+    entries_.swap(other.entries_);
+    return *this;
+}
+
+NodeParameters::~NodeParameters()
+{
+    clear();
+}
+
+void NodeParameters::clear()
+{
+    for (const InternedEntry* entry : entries_)
+    {
+        release(entry);
+    }
+    entries_.clear();
+}
+
+NodeParameters::Entries::const_iterator NodeParameters::lowerBound(StringView key) const
+{
+    return std::lower_bound(entries_.begin(), entries_.end(), key,
+                            [](const InternedEntry* entry, StringView k) {
+                                return StringView(entry->value.first) < k;
+                            });
+}
+
+void NodeParameters::set(StringView key, StringView value)
+{
+    auto it = entries_.begin() + (lowerBound(key) - entries_.cbegin());
+    if (it != entries_.end() && StringView((*it)->value.first) == key)
+    {
+        const InternedEntry* replaced = *it;
+        *it = intern(key, value);
+        release(replaced);
+    }
+    else
+    {
+        entries_.insert(it, intern(key, value));
+    }
+}
+
+bool NodeParameters::erase(StringView key)
+{
+    auto it = entries_.begin() + (lowerBound(key) - entries_.cbegin());
+    if (it != entries_.end() && StringView((*it)->value.first) == key)
+    {
+        const InternedEntry* erased = *it;
+        entries_.erase(it);
+        release(erased);
+        return true;
+    }
+    return false;
+}
+
+NodeParameters::const_iterator NodeParameters::find(StringView key) const
+{
+    auto it = lowerBound(key);
+    if (it != entries_.end() && StringView((*it)->value.first) == key)
+    {
+        return const_iterator(it);
+    }
+    return end();
+}
+
+const std::string& NodeParameters::at(StringView key) const
+{
+    auto it = find(key);
+    if (it == end())
+    {
+        throw std::out_of_range("NodeParameters: key [" + std::string(key.data(), key.size()) +
+                                "] not found");
+    }
+    return it->second;
+}
+}
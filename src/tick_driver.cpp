@@ -0,0 +1,557 @@
+#include "behaviortree_cpp/tick_driver.h"
+#include "behaviortree_cpp/behavior_tree.h"
+#include "behaviortree_cpp/tick_profiler.h"
+#include "behaviortree_cpp/decorators/timeout_node.h"
+#include "behaviortree_cpp/controls/parallel_node.h"
+#include "behaviortree_cpp/metrics/tree_metrics.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace BT
+{
+typedef std::chrono::steady_clock Clock;
+
+struct TickDriver::Statistics
+{
+    std::atomic<uint64_t> ticks;
+    std::atomic<uint64_t> overruns;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint32_t> histogram[TickProfiler::BUCKETS];
+};
+
+// A Signal may still be invoking a callback in another thread when its
+// subscriber is released: the callbacks hold the mutex while they run.
+struct TickDriver::CallbackGuard
+{
+    std::mutex mutex;
+    bool alive = true;
+};
+
+namespace
+{
+// Written only by the tick thread: see TickProfiler
+template <typename T>
+inline void increment(std::atomic<T>& counter, T value = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+#ifdef __linux__
+std::string errorString(int error)
+{
+    return std::strerror(error);
+}
+
+// Not inlined: the stack below the caller is written, and released on return.
+__attribute__((noinline)) void prefaultStack(size_t size)
+{
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(size));
+    for (size_t i = 0; i < size; i += 4096)
+    {
+        stack[i] = 0;
+    }
+}
+#endif
+}
+
+template <typename... Args>
+std::function<void(Args...)> TickDriver::guardedCallback(std::function<void(Args...)> callback)
+{
+    std::shared_ptr<CallbackGuard> guard = callback_guard_;
+    return [guard, callback](Args... args) {
+        std::lock_guard<std::mutex> lock(guard->mutex);
+        if (guard->alive)
+        {
+            callback(args...);
+        }
+    };
+}
+
+std::chrono::nanoseconds TickOverrun::lateness() const
+{
+    return end - deadline;
+}
+
+uint64_t TickJitterStatistics::percentileNs(double p) const
+{
+    return histogramPercentileNs(histogram, max_ns, p);
+}
+
+TickDriver::TickDriver(TreeNode* root_node, const TickDriverOptions& options)
+  : root_node_(root_node),
+    options_(options),
+    callback_guard_(std::make_shared<CallbackGuard>()),
+    tick_thread_(std::thread::id()),
+    pending_event_(false),
+    event_fd_(-1),
+    stop_requested_(false),
+    last_status_(NodeStatus::IDLE),
+    overruns_next_(0),
+    statistics_(new Statistics)
+{
+    overruns_.reserve(options_.overrun_history);
+    applyRecursiveVisitor(root_node_, [this](TreeNode* node) {
+        if (dynamic_cast<AsyncActionNode*>(node))
+        {
+            async_nodes_.push_back(node);
+        }
+    });
+    resetStatistics();
+
+    if (!options_.event_driven)
+    {
+        return;
+    }
+#ifdef __linux__
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0)
+    {
+        throw std::runtime_error("eventfd() failed: " + errorString(errno));
+    }
+#endif
+    // the changes made by the tick itself don't need another one
+    applyRecursiveVisitor(root_node_, [this](TreeNode* node) {
+        subscribers_.push_back(node->subscribeToStatusChange(guardedCallback(
+            TreeNode::StatusChangeCallback([this](TimePoint, const TreeNode&, NodeStatus,
+                                                  NodeStatus status) {
+                if (status != NodeStatus::RUNNING && !isTickThread())
+                {
+                    notify();
+                }
+            }))));
+        if (auto timeout = dynamic_cast<TimeoutNode*>(node))
+        {
+            subscribers_.push_back(timeout->subscribeToExpiry(guardedCallback(
+                TimeoutNode::ExpirySignal::CallableFunction([this](const TreeNode&) { notify(); }))));
+        }
+    });
+}
+
+TickDriver::~TickDriver()
+{
+    stop();
+    {
+        // wait for the callbacks running in other threads, and disable the next ones
+        std::lock_guard<std::mutex> lock(callback_guard_->mutex);
+        callback_guard_->alive = false;
+    }
+    subscribers_.clear();
+#ifdef __linux__
+    if (event_fd_ >= 0)
+    {
+        close(event_fd_);
+    }
+#endif
+}
+
+NodeStatus TickDriver::run()
+{
+    stop_requested_ = false;
+    return loop();
+}
+
+void TickDriver::start()
+{
+    stop();
+    stop_requested_ = false;
+    thread_ = std::thread([this]() { loop(); });
+}
+
+void TickDriver::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeup_mutex_);
+        stop_requested_ = true;
+    }
+    wakeup_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+NodeStatus TickDriver::loop()
+{
+    applyProfile();
+    tick_thread_ = std::this_thread::get_id();
+
+    const NodeStatus status = options_.event_driven ? eventLoop() : periodicLoop();
+
+    // interrupted by stop(): the halt runs here, never concurrently with a tick
+    if (status == NodeStatus::RUNNING && options_.halt_on_stop)
+    {
+        root_node_->halt();
+    }
+    tick_thread_ = std::thread::id();
+    return last_status_;
+}
+
+NodeStatus TickDriver::periodicLoop()
+{
+    const auto period = std::chrono::duration_cast<Clock::duration>(options_.period);
+    Clock::time_point deadline = Clock::now();
+    NodeStatus status = NodeStatus::IDLE;
+    while (!stop_requested_)
+    {
+        const Clock::time_point start = Clock::now();
+        status = root_node_->executeTick();
+        last_status_ = status;
+        const Clock::time_point end = Clock::now();
+
+        const Clock::time_point previous_deadline = deadline;
+        deadline += period;
+        // the last tick has no following one; with CATCH_UP, the ticks that started
+        // after the following deadline are late, but not overruns
+        const bool late = status == NodeStatus::RUNNING && period.count() > 0 && end > deadline;
+        const bool overrun = late && start < deadline;
+        if (overrun)
+        {
+            recordOverrun(deadline, start, end);
+        }
+        recordTick(start - previous_deadline, end - start, status, overrun);
+        if (status != NodeStatus::RUNNING)
+        {
+            break;
+        }
+
+        if (late)
+        {
+            const int64_t missed = (end - deadline) / period + 1;
+            const int64_t max_catch_up = options_.max_catch_up_ticks;
+            switch (options_.overrun_policy)
+            {
+                case OverrunPolicy::SKIP:
+                    deadline += missed * period;
+                    break;
+                case OverrunPolicy::CATCH_UP:
+                    if (missed > max_catch_up)
+                    {
+                        deadline += (missed - max_catch_up) * period;
+                    }
+                    break;
+                case OverrunPolicy::STRETCH:
+                    deadline = end;
+                    break;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(wakeup_mutex_);
+        wakeup_.wait_until(lock, deadline, [this]() { return stop_requested_.load(); });
+    }
+    return status;
+}
+
+NodeStatus TickDriver::eventLoop()
+{
+    const auto min_interval = std::chrono::duration_cast<Clock::duration>(options_.period);
+    NodeStatus status = NodeStatus::IDLE;
+    while (!stop_requested_)
+    {
+        const Clock::time_point start = Clock::now();
+        status = tickOnEvent();
+        if (status != NodeStatus::RUNNING)
+        {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeup_mutex_);
+        const auto woken = [this]() { return stop_requested_.load() || pending_event_; };
+        if (options_.idle_timeout.count() > 0)
+        {
+            wakeup_.wait_for(lock, options_.idle_timeout, woken);
+        }
+        else
+        {
+            wakeup_.wait(lock, woken);
+        }
+        wakeup_.wait_until(lock, start + min_interval, [this]() { return stop_requested_.load(); });
+    }
+    return status;
+}
+
+NodeStatus TickDriver::processEvents()
+{
+    tick_thread_ = std::this_thread::get_id();
+    return tickOnEvent();
+}
+
+NodeStatus TickDriver::tickOnEvent()
+{
+    const Clock::time_point start = Clock::now();
+    Clock::time_point event_time = start;
+    {
+        // an event notified from now on triggers another tick
+        std::lock_guard<std::mutex> lock(wakeup_mutex_);
+        if (pending_event_)
+        {
+            event_time = event_time_;
+            pending_event_ = false;
+        }
+    }
+#ifdef __linux__
+    uint64_t counter;
+    while (read(event_fd_, &counter, sizeof(counter)) > 0)
+    {
+    }
+#endif
+
+    const NodeStatus status = root_node_->executeTick();
+    last_status_ = status;
+    // the lateness is the latency of the event
+    recordTick(start - event_time, Clock::now() - start, status, false);
+    return status;
+}
+
+void TickDriver::notify()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeup_mutex_);
+        if (!pending_event_)
+        {
+            pending_event_ = true;
+            event_time_ = Clock::now();
+        }
+    }
+    wakeup_.notify_all();
+#ifdef __linux__
+    if (event_fd_ >= 0)
+    {
+        const uint64_t one = 1;
+        // fails only if the counter is saturated, that is already readable
+        ssize_t written = write(event_fd_, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+}
+
+void TickDriver::watchBlackboard(const Blackboard::Ptr& blackboard,
+                                 const std::vector<std::string>& keys)
+{
+    subscribers_.push_back(blackboard->subscribeToWrites(guardedCallback(
+        Blackboard::WriteSignal::CallableFunction(
+            [this, keys](const std::string& key, const SafeAny::Any&) {
+                if (!isTickThread() && std::find(keys.begin(), keys.end(), key) != keys.end())
+                {
+                    notify();
+                }
+            }))));
+}
+
+int TickDriver::eventFd() const
+{
+    return event_fd_;
+}
+
+bool TickDriver::isTickThread() const
+{
+    // the children of a concurrent ParallelNode change status in the threads of the pool
+    return tick_thread_.load() == ParallelNode::tickThreadId();
+}
+
+void TickDriver::applyProfile()
+{
+    {
+        std::lock_guard<std::mutex> lock(warnings_mutex_);
+        warnings_.clear();
+    }
+#ifdef __linux__
+    if (options_.lock_memory)
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            addWarning("mlockall() failed: " + errorString(errno));
+        }
+#ifdef __GLIBC__
+        // memory freed by the tick must stay mapped, and locked
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+#endif
+    }
+    if (options_.prefault_stack_size > 0)
+    {
+        prefaultStack(options_.prefault_stack_size);
+    }
+
+    auto pin = [this](pthread_t thread, int cpu, const std::string& thread_name) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        const int error = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (error != 0)
+        {
+            addWarning("the " + thread_name + " can't be pinned to the CPU " +
+                       std::to_string(cpu) + ": " + errorString(error));
+        }
+    };
+    auto schedule = [this](pthread_t thread, int priority, const std::string& thread_name) {
+        if (options_.policy == SchedulingPolicy::OTHER)
+        {
+            return;
+        }
+        sched_param param;
+        param.sched_priority = priority;
+        const int policy = options_.policy == SchedulingPolicy::FIFO ? SCHED_FIFO : SCHED_RR;
+        const int error = pthread_setschedparam(thread, policy, &param);
+        if (error != 0)
+        {
+            addWarning("the scheduling of the " + thread_name + " can't be changed: " +
+                       errorString(error));
+        }
+    };
+
+    if (options_.tick_cpu >= 0)
+    {
+        pin(pthread_self(), options_.tick_cpu, "tick thread");
+    }
+    schedule(pthread_self(), options_.tick_priority, "tick thread");
+
+    for (size_t i = 0; i < async_nodes_.size(); i++)
+    {
+        auto node = static_cast<AsyncActionNode*>(async_nodes_[i]);
+        const std::string thread_name = "thread of [" + node->name() + "]";
+        if (!options_.worker_cpus.empty())
+        {
+            pin(node->threadHandle(), options_.worker_cpus[i % options_.worker_cpus.size()],
+                thread_name);
+        }
+        schedule(node->threadHandle(), options_.worker_priority, thread_name);
+    }
+#else
+    if (options_.lock_memory || options_.policy != SchedulingPolicy::OTHER ||
+        options_.tick_cpu >= 0 || !options_.worker_cpus.empty())
+    {
+        addWarning("the real-time profile is supported only on Linux");
+    }
+#endif
+}
+
+void TickDriver::recordOverrun(Clock::time_point deadline, Clock::time_point start,
+                               Clock::time_point end)
+{
+    if (options_.metrics)
+    {
+        options_.metrics->recordOverrun();
+    }
+    if (options_.overrun_history == 0)
+    {
+        return;
+    }
+    TickOverrun overrun;
+    overrun.tick = statistics_->ticks.load(std::memory_order_relaxed);
+    overrun.deadline = deadline;
+    overrun.start = start;
+    overrun.end = end;
+
+    std::lock_guard<std::mutex> lock(overruns_mutex_);
+    if (overruns_.size() < options_.overrun_history)
+    {
+        overruns_.push_back(overrun);
+    }
+    else
+    {
+        overruns_[overruns_next_] = overrun;
+    }
+    overruns_next_ = (overruns_next_ + 1) % options_.overrun_history;
+}
+
+void TickDriver::recordTick(std::chrono::nanoseconds lateness, std::chrono::nanoseconds duration,
+                            NodeStatus status, bool overrun)
+{
+    if (options_.metrics)
+    {
+        options_.metrics->recordTick(duration, status);
+    }
+    const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, lateness.count()));
+    Statistics& stats = *statistics_;
+    increment(stats.ticks);
+    increment(stats.total_ns, ns);
+    if (overrun)
+    {
+        increment(stats.overruns);
+    }
+    if (ns > stats.max_ns.load(std::memory_order_relaxed))
+    {
+        stats.max_ns.store(ns, std::memory_order_relaxed);
+    }
+    increment(stats.histogram[TickProfiler::bucketIndex(ns)], 1u);
+}
+
+NodeStatus TickDriver::lastStatus() const
+{
+    return last_status_;
+}
+
+TickJitterStatistics TickDriver::statistics() const
+{
+    const Statistics& stats = *statistics_;
+    TickJitterStatistics out;
+    out.ticks = stats.ticks.load(std::memory_order_relaxed);
+    out.overruns = stats.overruns.load(std::memory_order_relaxed);
+    out.total_ns = stats.total_ns.load(std::memory_order_relaxed);
+    out.max_ns = stats.max_ns.load(std::memory_order_relaxed);
+    out.histogram.resize(TickProfiler::BUCKETS);
+    for (size_t i = 0; i < TickProfiler::BUCKETS; i++)
+    {
+        out.histogram[i] = stats.histogram[i].load(std::memory_order_relaxed);
+    }
+    return out;
+}
+
+void TickDriver::resetStatistics()
+{
+    Statistics& stats = *statistics_;
+    stats.ticks = 0;
+    stats.overruns = 0;
+    stats.total_ns = 0;
+    stats.max_ns = 0;
+    for (auto& bucket : stats.histogram)
+    {
+        bucket = 0;
+    }
+    std::lock_guard<std::mutex> lock(overruns_mutex_);
+    overruns_.clear();
+    overruns_next_ = 0;
+}
+
+std::vector<TickOverrun> TickDriver::overruns() const
+{
+    std::lock_guard<std::mutex> lock(overruns_mutex_);
+    if (overruns_.size() < options_.overrun_history)
+    {
+        return overruns_;
+    }
+    std::vector<TickOverrun> out(overruns_.begin() + overruns_next_, overruns_.end());
+    out.insert(out.end(), overruns_.begin(), overruns_.begin() + overruns_next_);
+    return out;
+}
+
+std::vector<std::string> TickDriver::warnings() const
+{
+    std::lock_guard<std::mutex> lock(warnings_mutex_);
+    return warnings_;
+}
+
+const TickDriverOptions& TickDriver::options() const
+{
+    return options_;
+}
+
+void TickDriver::addWarning(const std::string& warning)
+{
+    std::lock_guard<std::mutex> lock(warnings_mutex_);
+    warnings_.push_back(warning);
+}
+}
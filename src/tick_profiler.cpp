@@ -0,0 +1,243 @@
+#include "behaviortree_cpp/tick_profiler.h"
+#include "behaviortree_cpp/behavior_tree.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace BT
+{
+namespace
+{
+// Slots are written only by the thread that ticks the node: a relaxed load and store
+// is enough and avoids the cost of an atomic read-modify-write.
+template <typename T>
+inline void increment(std::atomic<T>& counter, T value = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+const uint64_t MAX_NS = (uint64_t(1) << 40) - 1;
+
+std::string escapeJSON(const std::string& str)
+{
+    std::string out;
+    out.reserve(str.size());
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+}
+
+const size_t TickProfiler::BUCKETS;
+
+size_t TickProfiler::bucketIndex(uint64_t ns)
+{
+    // 4 buckets for each power of 2
+    ns = std::min(ns, MAX_NS);
+    if (ns < 4)
+    {
+        return ns;
+    }
+    const int msb = 63 - __builtin_clzll(ns);
+    const size_t sub_bucket = (ns >> (msb - 2)) & 3;
+    return (msb - 1) * 4 + sub_bucket;
+}
+
+uint64_t TickProfiler::bucketLowerBound(size_t index)
+{
+    if (index < 4)
+    {
+        return index;
+    }
+    const int msb = static_cast<int>(index / 4) + 1;
+    return (4 + (index % 4)) << (msb - 2);
+}
+
+uint64_t histogramPercentileNs(const std::vector<uint32_t>& histogram, uint64_t max_ns, double p)
+{
+    uint64_t count = 0;
+    for (uint32_t bucket : histogram)
+    {
+        count += bucket;
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * count + 0.5));
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < histogram.size(); i++)
+    {
+        cumulative += histogram[i];
+        if (cumulative >= rank)
+        {
+            // middle of the bucket, never above the maximum
+            const uint64_t lower = TickProfiler::bucketLowerBound(i);
+            const uint64_t upper =
+                (i + 1 < histogram.size()) ? TickProfiler::bucketLowerBound(i + 1) : lower;
+            return std::min(max_ns, (lower + upper) / 2);
+        }
+    }
+    return max_ns;
+}
+
+uint64_t NodeTickStatistics::percentileNs(double p) const
+{
+    return histogramPercentileNs(histogram, max_ns, p);
+}
+
+TickProfiler::TickProfiler(TreeNode* root_node)
+{
+    applyRecursiveVisitor(root_node, [this](TreeNode* node) { nodes_.push_back(node); });
+    slots_.reset(new Slot[nodes_.size()]);
+    reset();
+
+    for (size_t i = 0; i < nodes_.size(); i++)
+    {
+        nodes_[i]->addTickMonitor(this, i);
+    }
+}
+
+TickProfiler::~TickProfiler()
+{
+    for (TreeNode* node : nodes_)
+    {
+        node->removeTickMonitor(this);
+    }
+}
+
+void TickProfiler::onTick(const TreeNode&, size_t slot_index, MonitorTime,
+                          std::chrono::nanoseconds elapsed, NodeStatus status)
+{
+    Slot& slot = slots_[slot_index];
+    const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
+
+    increment<uint64_t>(slot.ticks);
+    switch (status)
+    {
+        case NodeStatus::SUCCESS:
+            increment<uint64_t>(slot.success);
+            break;
+        case NodeStatus::FAILURE:
+            increment<uint64_t>(slot.failure);
+            break;
+        case NodeStatus::RUNNING:
+            increment<uint64_t>(slot.running);
+            break;
+        default:
+            break;
+    }
+    increment<uint64_t>(slot.total_ns, ns);
+    if (ns > slot.max_ns.load(std::memory_order_relaxed))
+    {
+        slot.max_ns.store(ns, std::memory_order_relaxed);
+    }
+    increment<uint32_t>(slot.histogram[bucketIndex(ns)]);
+}
+
+std::vector<NodeTickStatistics> TickProfiler::snapshot() const
+{
+    std::vector<NodeTickStatistics> statistics(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); i++)
+    {
+        const Slot& slot = slots_[i];
+        NodeTickStatistics& stats = statistics[i];
+        stats.uid = nodes_[i]->UID();
+        stats.name = nodes_[i]->name();
+        stats.registration_name = nodes_[i]->registrationName();
+        stats.ticks = slot.ticks.load(std::memory_order_relaxed);
+        stats.success = slot.success.load(std::memory_order_relaxed);
+        stats.failure = slot.failure.load(std::memory_order_relaxed);
+        stats.running = slot.running.load(std::memory_order_relaxed);
+        stats.total_ns = slot.total_ns.load(std::memory_order_relaxed);
+        stats.max_ns = slot.max_ns.load(std::memory_order_relaxed);
+        stats.histogram.resize(BUCKETS);
+        for (size_t b = 0; b < BUCKETS; b++)
+        {
+            stats.histogram[b] = slot.histogram[b].load(std::memory_order_relaxed);
+        }
+    }
+    return statistics;
+}
+
+void TickProfiler::reset()
+{
+    for (size_t i = 0; i < nodes_.size(); i++)
+    {
+        Slot& slot = slots_[i];
+        slot.ticks.store(0, std::memory_order_relaxed);
+        slot.success.store(0, std::memory_order_relaxed);
+        slot.failure.store(0, std::memory_order_relaxed);
+        slot.running.store(0, std::memory_order_relaxed);
+        slot.total_ns.store(0, std::memory_order_relaxed);
+        slot.max_ns.store(0, std::memory_order_relaxed);
+        for (size_t b = 0; b < BUCKETS; b++)
+        {
+            slot.histogram[b].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void TickProfiler::dumpTable(std::ostream& os) const
+{
+    std::vector<NodeTickStatistics> statistics = snapshot();
+    std::stable_sort(statistics.begin(), statistics.end(),
+                     [](const NodeTickStatistics& a, const NodeTickStatistics& b) {
+                         return a.total_ns > b.total_ns;
+                     });
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-25s %-20s %9s %9s %9s %9s %11s %9s %9s %9s\n", "name",
+             "type", "ticks", "success", "failure", "running", "total[ms]", "p50[us]",
+             "p99[us]", "max[us]");
+    os << line;
+
+    for (const NodeTickStatistics& stats : statistics)
+    {
+        snprintf(line, sizeof(line),
+                 "%-25s %-20s %9llu %9llu %9llu %9llu %11.3f %9.1f %9.1f %9.1f\n",
+                 stats.name.c_str(), stats.registration_name.c_str(),
+                 static_cast<unsigned long long>(stats.ticks),
+                 static_cast<unsigned long long>(stats.success),
+                 static_cast<unsigned long long>(stats.failure),
+                 static_cast<unsigned long long>(stats.running), stats.total_ns * 1e-6,
+                 stats.percentileNs(0.5) * 1e-3, stats.percentileNs(0.99) * 1e-3,
+                 stats.max_ns * 1e-3);
+        os << line;
+    }
+}
+
+void TickProfiler::dumpJSON(std::ostream& os) const
+{
+    const std::vector<NodeTickStatistics> statistics = snapshot();
+    os << "[";
+    for (size_t i = 0; i < statistics.size(); i++)
+    {
+        const NodeTickStatistics& stats = statistics[i];
+        os << (i == 0 ? "\n" : ",\n");
+        os << "  {\"uid\": " << stats.uid << ", \"name\": \"" << escapeJSON(stats.name)
+           << "\", \"type\": \"" << escapeJSON(stats.registration_name)
+           << "\", \"ticks\": " << stats.ticks << ", \"success\": " << stats.success
+           << ", \"failure\": " << stats.failure << ", \"running\": " << stats.running
+           << ", \"total_ns\": " << stats.total_ns << ", \"p50_ns\": " << stats.percentileNs(0.5)
+           << ", \"p99_ns\": " << stats.percentileNs(0.99) << ", \"max_ns\": " << stats.max_ns
+           << "}";
+    }
+    os << "\n]\n";
+}
+}
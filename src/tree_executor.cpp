@@ -0,0 +1,436 @@
+#include "behaviortree_cpp/tree_executor.h"
+#include "behaviortree_cpp/metrics/tree_metrics.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace BT
+{
+typedef std::chrono::steady_clock Clock;
+
+struct TreeExecutor::Entry
+{
+    TreeID id;
+    TreeNode* root_node;
+    TreeScheduleHints hints;
+    Clock::duration period;
+
+    // written by the worker that owns the entry: the one whose queue contains
+    // it, or the one ticking it
+    Clock::time_point deadline;
+
+    std::atomic<NodeStatus> status;
+    std::atomic<bool> in_flight;
+    std::atomic<bool> removed;
+    std::atomic<bool> finished;
+};
+
+struct TreeExecutor::Worker
+{
+    std::mutex mutex;
+    // heap, the earliest deadline first
+    std::vector<Entry*> waiting;
+    // heap, the highest priority first, then the earliest deadline
+    std::vector<Entry*> ready;
+
+    std::atomic<uint64_t> ticks;
+    // the other workers tick its trees that become due meanwhile
+    std::atomic<bool> ticking;
+    std::thread thread;
+};
+
+namespace
+{
+template <typename EntryT>
+bool laterDeadline(const EntryT* a, const EntryT* b)
+{
+    return a->deadline > b->deadline;
+}
+
+template <typename EntryT>
+bool lowerPriority(const EntryT* a, const EntryT* b)
+{
+    if (a->hints.priority != b->hints.priority)
+    {
+        return a->hints.priority < b->hints.priority;
+    }
+    return a->deadline > b->deadline;
+}
+
+template <typename EntryT, typename Compare>
+void eraseFromHeap(std::vector<EntryT*>& heap, EntryT* entry, Compare compare)
+{
+    auto it = std::find(heap.begin(), heap.end(), entry);
+    if (it != heap.end())
+    {
+        heap.erase(it);
+        std::make_heap(heap.begin(), heap.end(), compare);
+    }
+}
+}
+
+TreeExecutor::TreeExecutor(const TreeExecutorOptions& options)
+  : options_(options),
+    next_id_(1),
+    next_worker_(0),
+    wake_generation_(0),
+    idle_workers_(0),
+    sleep_until_(Clock::time_point::max()),
+    stop_(false)
+{
+    for (unsigned i = 0; i < options_.threads; i++)
+    {
+        workers_.emplace_back(new Worker);
+        workers_.back()->ticks = 0;
+        workers_.back()->ticking = false;
+    }
+    for (size_t i = 0; i < workers_.size(); i++)
+    {
+        workers_[i]->thread = std::thread(&TreeExecutor::workerLoop, this, i);
+    }
+}
+
+TreeExecutor::~TreeExecutor()
+{
+    stop_ = true;
+    wakeUpWorkers();
+    for (auto& worker : workers_)
+    {
+        worker->thread.join();
+    }
+}
+
+TreeExecutor::TreeID TreeExecutor::add(TreeNode* root_node, const TreeScheduleHints& hints)
+{
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->root_node = root_node;
+    entry->hints = hints;
+    entry->period = std::chrono::duration_cast<Clock::duration>(hints.period);
+    entry->status = NodeStatus::IDLE;
+    entry->in_flight = false;
+    entry->removed = false;
+    entry->finished = false;
+
+    size_t worker_index;
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(entries_mutex_);
+        entry->id = next_id_++;
+        entries_[entry->id] = entry;
+        worker_index = hints.worker >= 0 ? static_cast<size_t>(hints.worker) : next_worker_++;
+        worker_index %= workers_.size();
+        count = entries_.size();
+    }
+
+    // any tree can be stolen by any worker: the queues never allocate while ticking
+    for (auto& worker : workers_)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (worker->waiting.capacity() < count)
+        {
+            worker->waiting.reserve(count * 2);
+            worker->ready.reserve(count * 2);
+        }
+    }
+
+    entry->deadline = Clock::now();
+    push(worker_index, entry.get());
+    wakeUpWorkers();
+    return entry->id;
+}
+
+bool TreeExecutor::remove(TreeID id)
+{
+    std::shared_ptr<Entry> entry = find(id);
+    if (!entry)
+    {
+        return false;
+    }
+
+    entry->removed = true;
+    for (auto& worker : workers_)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        eraseFromHeap(worker->waiting, entry.get(), laterDeadline<Entry>);
+        eraseFromHeap(worker->ready, entry.get(), lowerPriority<Entry>);
+    }
+    {
+        // see push() and tickEntry()
+        std::unique_lock<std::mutex> lock(done_mutex_);
+        done_cv_.wait(lock, [&entry]() { return !entry->in_flight.load(); });
+    }
+
+    if (entry->status == NodeStatus::RUNNING)
+    {
+        entry->root_node->halt();
+    }
+    {
+        std::lock_guard<std::mutex> lock(entries_mutex_);
+        entries_.erase(id);
+    }
+    {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        done_cv_.notify_all();
+    }
+    return true;
+}
+
+NodeStatus TreeExecutor::status(TreeID id) const
+{
+    std::shared_ptr<Entry> entry = find(id);
+    return entry ? entry->status.load() : NodeStatus::IDLE;
+}
+
+NodeStatus TreeExecutor::wait(TreeID id)
+{
+    std::shared_ptr<Entry> entry = find(id);
+    if (!entry)
+    {
+        return NodeStatus::IDLE;
+    }
+    std::unique_lock<std::mutex> lock(done_mutex_);
+    done_cv_.wait(lock, [&entry]() { return entry->finished || entry->removed; });
+    return entry->status;
+}
+
+size_t TreeExecutor::size() const
+{
+    std::lock_guard<std::mutex> lock(entries_mutex_);
+    return entries_.size();
+}
+
+uint64_t TreeExecutor::ticks() const
+{
+    uint64_t total = 0;
+    for (const auto& worker : workers_)
+    {
+        total += worker->ticks.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+const TreeExecutorOptions& TreeExecutor::options() const
+{
+    return options_;
+}
+
+void TreeExecutor::workerLoop(size_t index)
+{
+#ifdef __linux__
+    if (!options_.worker_cpus.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(options_.worker_cpus[index % options_.worker_cpus.size()], &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+
+    Worker& self = *workers_[index];
+    while (!stop_)
+    {
+        const uint64_t generation = wake_generation_.load();
+        const Clock::time_point now = Clock::now();
+        Clock::time_point next_deadline;
+        bool backlog = false;
+        Entry* entry;
+        {
+            std::lock_guard<std::mutex> lock(self.mutex);
+            entry = popReady(self, now, &next_deadline, &backlog);
+        }
+        // the front of its own queue: it becomes due while this worker is busy
+        const Clock::time_point own_deadline = next_deadline;
+        if (!entry)
+        {
+            entry = steal(index, now, &next_deadline);
+        }
+
+        if (entry)
+        {
+            // more trees are due than this worker can tick
+            if (backlog && idle_workers_ > 0)
+            {
+                wakeUpWorkers();
+            }
+            // the idle workers sleep until the deadlines of the busy ones too
+            self.ticking = true;
+            if (own_deadline != Clock::time_point::max())
+            {
+                wakeUpWorkerBefore(own_deadline);
+            }
+            tickEntry(entry, index);
+            self.ticking = false;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        idle_workers_++;
+        sleep_until_ = next_deadline;
+        const auto woken = [this, generation]() {
+            return stop_.load() || wake_generation_.load() != generation;
+        };
+        if (next_deadline == Clock::time_point::max())
+        {
+            sleep_cv_.wait(lock, woken);
+        }
+        else
+        {
+            sleep_cv_.wait_until(lock, next_deadline, woken);
+        }
+        idle_workers_--;
+    }
+}
+
+TreeExecutor::Entry* TreeExecutor::popReady(Worker& worker, Clock::time_point now,
+                                            Clock::time_point* next_deadline, bool* backlog)
+{
+    auto& waiting = worker.waiting;
+    auto& ready = worker.ready;
+    while (!waiting.empty() && waiting.front()->deadline <= now)
+    {
+        std::pop_heap(waiting.begin(), waiting.end(), laterDeadline<Entry>);
+        ready.push_back(waiting.back());
+        waiting.pop_back();
+        std::push_heap(ready.begin(), ready.end(), lowerPriority<Entry>);
+    }
+    *next_deadline = waiting.empty() ? Clock::time_point::max() : waiting.front()->deadline;
+
+    if (ready.empty())
+    {
+        return nullptr;
+    }
+    std::pop_heap(ready.begin(), ready.end(), lowerPriority<Entry>);
+    Entry* entry = ready.back();
+    ready.pop_back();
+    entry->in_flight = true;
+    *backlog = !ready.empty();
+    return entry;
+}
+
+TreeExecutor::Entry* TreeExecutor::steal(size_t thief, Clock::time_point now,
+                                         Clock::time_point* next_deadline)
+{
+    for (size_t i = 1; i < workers_.size(); i++)
+    {
+        Worker& victim = *workers_[(thief + i) % workers_.size()];
+        Clock::time_point victim_deadline;
+        bool backlog;
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (Entry* entry = popReady(victim, now, &victim_deadline, &backlog))
+        {
+            return entry;
+        }
+        // an idle worker ticks its own trees in time
+        if (victim.ticking)
+        {
+            *next_deadline = std::min(*next_deadline, victim_deadline);
+        }
+    }
+    return nullptr;
+}
+
+void TreeExecutor::tickEntry(Entry* entry, size_t worker_index)
+{
+    TreeMetrics* metrics = entry->hints.metrics;
+    const Clock::time_point start = metrics ? Clock::now() : Clock::time_point();
+    const NodeStatus status = entry->root_node->executeTick();
+    entry->status = status;
+    Worker& self = *workers_[worker_index];
+    self.ticks.store(self.ticks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (metrics)
+    {
+        const Clock::time_point end = Clock::now();
+        metrics->recordTick(end - start, status);
+        // as in TickDriver: a tick that started late is not an overrun
+        const Clock::time_point next_deadline = entry->deadline + entry->period;
+        if (status == NodeStatus::RUNNING && entry->period.count() > 0 && end > next_deadline &&
+            start < next_deadline)
+        {
+            metrics->recordOverrun();
+        }
+    }
+
+    if (status == NodeStatus::RUNNING)
+    {
+        // the missed deadlines are skipped
+        const Clock::time_point now = Clock::now();
+        entry->deadline = std::max(entry->deadline + entry->period, now);
+
+        const size_t home = entry->hints.worker >= 0 ?
+                                static_cast<size_t>(entry->hints.worker) % workers_.size() :
+                                worker_index;
+        // the entry is released by push(): another worker may tick it, or
+        // remove() free it, as soon as it returns
+        push(home, entry);
+    }
+    else
+    {
+        entry->finished = true;
+        // remove() and wait() can't return before the lock is released
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        entry->in_flight = false;
+        done_cv_.notify_all();
+    }
+}
+
+void TreeExecutor::push(size_t worker_index, Entry* entry)
+{
+    Worker& worker = *workers_[worker_index];
+    {
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        // checked under the lock: remove() sets it, then looks for the entry
+        if (!entry->removed)
+        {
+            // cleared before the entry is visible to the other workers, that set it when
+            // they pop it
+            entry->in_flight = false;
+            const Clock::time_point deadline = entry->deadline;
+            worker.waiting.push_back(entry);
+            std::push_heap(worker.waiting.begin(), worker.waiting.end(), laterDeadline<Entry>);
+            lock.unlock();
+            wakeUpWorkerBefore(deadline);
+            return;
+        }
+    }
+    // remove() is waiting for the end of the tick
+    std::lock_guard<std::mutex> lock(done_mutex_);
+    entry->in_flight = false;
+    done_cv_.notify_all();
+}
+
+void TreeExecutor::wakeUpWorkerBefore(Clock::time_point deadline)
+{
+    // A worker that is going to sleep has read the generation before looking at
+    // the queues: it sees the new one, or it is counted in idle_workers_.
+    wake_generation_++;
+    if (idle_workers_ > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        if (deadline < sleep_until_)
+        {
+            // the home worker of the tree must wake up, if it is idle
+            sleep_cv_.notify_all();
+        }
+    }
+}
+
+void TreeExecutor::wakeUpWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        wake_generation_++;
+    }
+    sleep_cv_.notify_all();
+}
+
+std::shared_ptr<TreeExecutor::Entry> TreeExecutor::find(TreeID id) const
+{
+    std::lock_guard<std::mutex> lock(entries_mutex_);
+    auto it = entries_.find(id);
+    return it != entries_.end() ? it->second : std::shared_ptr<Entry>();
+}
+}
@@ -13,27 +13,84 @@
 
 #include "behaviortree_cpp/tree_node.h"
 #include <cstring>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <vector>
 
 namespace BT
 {
-static uint8_t getUID()
+namespace
 {
-    static uint8_t uid = 1;
-    return uid++;
+// UIDs of the nodes that don't belong to a Tree yet: one bit for each UID,
+// released when the node is destroyed or numbered by its tree.
+class UIDAllocator
+{
+  public:
+    UIDAllocator() : used_(WORDS, 0), next_word_(0)
+    {
+        used_[0] = 1;   // UID 0 is never assigned
+    }
+
+    static UIDAllocator& instance()
+    {
+        // never destroyed: static nodes may be released after it
+        static UIDAllocator* allocator = new UIDAllocator;
+        return *allocator;
+    }
+
+    uint16_t acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            const size_t word = (next_word_ + i) % WORDS;
+            if (used_[word] != ~uint64_t(0))
+            {
+                size_t bit = 0;
+                while (used_[word] & (uint64_t(1) << bit))
+                {
+                    bit++;
+                }
+                used_[word] |= uint64_t(1) << bit;
+                next_word_ = word;
+                return static_cast<uint16_t>(word * 64 + bit);
+            }
+        }
+        throw BehaviorTreeException("Can't assign a UID: 65535 nodes that don't belong to "
+                                    "a Tree already exist");
+    }
+
+    void release(uint16_t uid)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        used_[uid / 64] &= ~(uint64_t(1) << (uid % 64));
+    }
+
+  private:
+    static const size_t WORDS = (size_t(std::numeric_limits<uint16_t>::max()) + 1) / 64;
+
+    std::mutex mutex_;
+    std::vector<uint64_t> used_;
+    size_t next_word_;
+};
 }
 
 TreeNode::TreeNode(const std::string& name, const NodeParameters& parameters)
   : not_initialized_(true),
     name_(name),
     status_(NodeStatus::IDLE),
-    uid_(getUID()),
-    parameters_(parameters)
-
+    uid_(UIDAllocator::instance().acquire()),
+    owns_uid_(true),
+    parameters_(parameters),
+    builder_(nullptr),
+    tick_monitors_(nullptr)
 {
 }
 
 NodeStatus TreeNode::executeTick()
 {
+    MonitorScope monitor_scope(*this);
     initializeOnce();
     const NodeStatus status = tick();
     setStatus(status);
@@ -56,6 +113,54 @@ void TreeNode::setStatus(NodeStatus new_status)
     }
 }
 
+void TreeNode::addTickMonitor(TickMonitor* monitor, size_t slot)
+{
+    std::lock_guard<std::mutex> lock(tick_monitors_mutex_);
+    const TickMonitorList* current = tick_monitors_.load(std::memory_order_relaxed);
+    std::unique_ptr<TickMonitorList> list(current ? new TickMonitorList(*current) :
+                                                    new TickMonitorList);
+    for (const auto& attached : *list)
+    {
+        if (attached.monitor == monitor)
+        {
+            throw std::logic_error("TickMonitor already attached to the node [" + name_ + "]");
+        }
+    }
+    list->push_back({monitor, slot});
+    tick_monitors_.store(list.get(), std::memory_order_release);
+    tick_monitor_lists_.emplace_back(std::move(list));
+}
+
+bool TreeNode::removeTickMonitor(TickMonitor* monitor)
+{
+    std::lock_guard<std::mutex> lock(tick_monitors_mutex_);
+    const TickMonitorList* current = tick_monitors_.load(std::memory_order_relaxed);
+    if (!current)
+    {
+        return false;
+    }
+    std::unique_ptr<TickMonitorList> list(new TickMonitorList);
+    for (const auto& attached : *current)
+    {
+        if (attached.monitor != monitor)
+        {
+            list->push_back(attached);
+        }
+    }
+    if (list->size() == current->size())
+    {
+        return false;
+    }
+    if (list->empty())
+    {
+        tick_monitors_.store(nullptr, std::memory_order_release);
+        return true;
+    }
+    tick_monitors_.store(list.get(), std::memory_order_release);
+    tick_monitor_lists_.emplace_back(std::move(list));
+    return true;
+}
+
 void TreeNode::setBlackboard(const Blackboard::Ptr& bb)
 {
     bb_ = bb;
@@ -110,6 +215,49 @@ uint16_t TreeNode::UID() const
     return uid_;
 }
 
+TreeNode::~TreeNode()
+{
+    if (owns_uid_)
+    {
+        UIDAllocator::instance().release(uid_);
+    }
+}
+
+void TreeNode::setTreeUID(uint16_t uid)
+{
+    if (owns_uid_)
+    {
+        UIDAllocator::instance().release(uid_);
+        owns_uid_ = false;
+    }
+    uid_ = uid;
+}
+
+void TreeNode::assignTreeUIDs(const std::vector<Ptr>& nodes)
+{
+    if (nodes.size() > std::numeric_limits<uint16_t>::max())
+    {
+        throw BehaviorTreeException("A Tree can't have more than 65535 nodes");
+    }
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        nodes[i]->setTreeUID(static_cast<uint16_t>(i + 1));
+    }
+}
+
+std::unique_ptr<TreeNode> TreeNode::clone() const
+{
+    if (!builder_)
+    {
+        throw std::logic_error("TreeNode [" + name_ + "] was not created by a BehaviorTreeFactory: "
+                               "you must override the method clone()");
+    }
+    std::unique_ptr<TreeNode> node = (*builder_)(name_, parameters_);
+    node->setRegistrationName(registration_name_);
+    node->builder_ = builder_;
+    return node;
+}
+
 void TreeNode::setRegistrationName(const std::string& registration_name)
 {
     registration_name_ = registration_name;
@@ -0,0 +1,198 @@
+#include "behaviortree_cpp/tree_pool.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace BT
+{
+namespace
+{
+struct PooledTree
+{
+    Tree tree;
+    Blackboard::Ptr blackboard;
+    // nodes that may keep an internal state even when they are not RUNNING
+    std::vector<TreeNode*> stateful_nodes;
+};
+
+// ControlNodes and DecoratorNodes clear their memory in halt(), whatever their status:
+// the index of SequenceStar, the attempts of Retry, the completed children of
+// PolicyParallel, and the same for the user's nodes.
+bool hasMemory(TreeNode* node)
+{
+    return dynamic_cast<ControlNode*>(node) || dynamic_cast<DecoratorNode*>(node);
+}
+
+void resetTree(PooledTree& pooled)
+{
+    TreeNode* root = pooled.tree.root_node;
+
+    // halt() propagates only through the RUNNING nodes
+    if (root->status() == NodeStatus::RUNNING)
+    {
+        root->halt();
+    }
+    root->setStatus(NodeStatus::IDLE);
+
+    for (TreeNode* node : pooled.stateful_nodes)
+    {
+        node->halt();
+    }
+}
+}
+
+struct TreePool::Pimpl
+{
+    Pimpl(const BehaviorTreeFactory& fact, size_t max_idle) : factory(fact), max_idle_trees(max_idle)
+    {
+    }
+
+    struct Entry
+    {
+        std::unique_ptr<PooledTree> blueprint;
+        std::vector<std::unique_ptr<PooledTree>> idle_trees;
+    };
+
+    const BehaviorTreeFactory& factory;
+    const size_t max_idle_trees;
+
+    mutable std::mutex mutex;
+    // key is the XML text
+    std::unordered_map<std::string, Entry> entries;
+
+    void release(Entry* entry, PooledTree* tree);
+
+    // Executed when the last shared_ptr of an acquired tree is destroyed.
+    struct Releaser
+    {
+        std::weak_ptr<Pimpl> pool;
+        Entry* entry;
+
+        void operator()(PooledTree* tree) const
+        {
+            auto pool_impl = pool.lock();
+            if (pool_impl)
+            {
+                pool_impl->release(entry, tree);
+            }
+            else
+            {
+                delete tree;
+            }
+        }
+    };
+};
+
+void TreePool::Pimpl::release(Entry* entry, PooledTree* tree)
+{
+    std::unique_ptr<PooledTree> pooled(tree);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entry->idle_trees.size() >= max_idle_trees)
+        {
+            return;   // destroyed outside the lock
+        }
+    }
+    resetTree(*pooled);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entry->idle_trees.push_back(std::move(pooled));
+}
+
+TreePool::TreePool(const BehaviorTreeFactory& factory, size_t max_idle_trees)
+  : _p(new Pimpl(factory, max_idle_trees))
+{
+}
+
+TreePool::~TreePool()
+{
+    clear();
+}
+
+std::shared_ptr<Tree> TreePool::acquire(const std::string& xml_text,
+                                        const Blackboard::Ptr& blackboard)
+{
+    std::unique_ptr<PooledTree> pooled;
+    Pimpl::Entry* entry = nullptr;
+    const PooledTree* blueprint = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_p->mutex);
+        entry = &_p->entries[xml_text];
+        if (!entry->idle_trees.empty())
+        {
+            pooled = std::move(entry->idle_trees.back());
+            entry->idle_trees.pop_back();
+        }
+        blueprint = entry->blueprint.get();
+    }
+
+    if (!pooled && !blueprint)
+    {
+        // Parsed without holding the lock, not to block the other XMLs.
+        // If another thread parsed the same XML meanwhile, its blueprint is kept.
+        std::unique_ptr<PooledTree> parsed(new PooledTree);
+        parsed->tree = buildTreeFromText(_p->factory, xml_text, blackboard);
+        parsed->blackboard = blackboard;
+
+        std::lock_guard<std::mutex> lock(_p->mutex);
+        if (!entry->blueprint)
+        {
+            entry->blueprint = std::move(parsed);
+        }
+        blueprint = entry->blueprint.get();
+    }   // a discarded blueprint is destroyed after the lock is released
+
+    if (!pooled)
+    {
+        pooled.reset(new PooledTree);
+        pooled->tree = blueprint->tree.clone(blackboard);
+        pooled->blackboard = blackboard;
+        for (const auto& node : pooled->tree.nodes)
+        {
+            if (hasMemory(node.get()))
+            {
+                pooled->stateful_nodes.push_back(node.get());
+            }
+        }
+    }
+    else if (pooled->blackboard != blackboard)
+    {
+        for (const auto& node : pooled->tree.nodes)
+        {
+            node->setBlackboard(blackboard);
+        }
+        pooled->blackboard = blackboard;
+    }
+
+    Pimpl::Releaser releaser = {_p, entry};
+    std::shared_ptr<PooledTree> owner(pooled.release(), releaser);
+    return std::shared_ptr<Tree>(owner, &owner->tree);
+}
+
+size_t TreePool::idleCount() const
+{
+    std::lock_guard<std::mutex> lock(_p->mutex);
+    size_t count = 0;
+    for (const auto& it : _p->entries)
+    {
+        count += it.second.idle_trees.size();
+    }
+    return count;
+}
+
+void TreePool::clear()
+{
+    std::vector<std::unique_ptr<PooledTree>> trees;
+    {
+        std::lock_guard<std::mutex> lock(_p->mutex);
+        for (auto& it : _p->entries)
+        {
+            for (auto& tree : it.second.idle_trees)
+            {
+                trees.push_back(std::move(tree));
+            }
+            it.second.idle_trees.clear();
+        }
+    }
+    // trees are destroyed here, outside the lock
+}
+}
@@ -12,6 +12,7 @@
 
 #include <functional>
 #include <list>
+#include <unordered_map>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wattributes"
@@ -38,6 +39,8 @@ struct XMLParser::Pimpl
     TreeNode::Ptr buildNodeFromElement(const XMLElement* element,
                                        TreeNode::Ptr parent);
 
+    void collectUsedIDs(const XMLElement* element, std::set<std::string>& IDs);
+
     void loadDocImpl(XMLDocument *doc);
 
     void verifyXML(const XMLDocument* doc) const;
@@ -192,6 +195,9 @@ void XMLParser::Pimpl::verifyXML(const XMLDocument* doc) const
         }
         return count;
     };
+
+    // copied the first time it is needed
+    std::vector<TreeNodeManifest> manifests;
     //-----------------------------
 
     const XMLElement* xml_root = doc->RootElement();
@@ -295,7 +301,11 @@ void XMLParser::Pimpl::verifyXML(const XMLDocument* doc) const
         {
             // Last resort:  MAYBE used ID as element name?
             bool found = false;
-            for (const auto& model : factory.manifests())
+            if (manifests.empty())
+            {
+                manifests = factory.manifests();
+            }
+            for (const auto& model : manifests)
             {
                 if (model.registration_ID == name)
                 {
@@ -386,8 +396,17 @@ TreeNode::Ptr XMLParser::instantiateTree(std::vector<TreeNode::Ptr>& nodes,
 
     auto root_element = _p->tree_roots[main_tree_ID]->FirstChildElement();
 
+    if (_p->factory.hasDeferredPlugins())
+    {
+        std::set<std::string> used_IDs;
+        _p->collectUsedIDs(root_element, used_IDs);
+        _p->factory.loadPluginsFor(used_IDs);
+    }
+
     _p->blackboard = blackboard;
-    return _p->buildTreeRecursively(root_element, nodes, TreeNode::Ptr());
+    auto root = _p->buildTreeRecursively(root_element, nodes, TreeNode::Ptr());
+    TreeNode::assignTreeUIDs(nodes);
+    return root;
 }
 
 TreeNode::Ptr BT::XMLParser::Pimpl::buildTreeRecursively(const XMLElement* root_element,
@@ -425,6 +444,27 @@ TreeNode::Ptr BT::XMLParser::Pimpl::buildTreeRecursively(const XMLElement* root_
     return root;
 }
 
+void XMLParser::Pimpl::collectUsedIDs(const XMLElement* element, std::set<std::string>& IDs)
+{
+    const std::string element_name = element->Name();
+    std::string ID = element_name;
+    if (element_name == "Action" || element_name == "Decorator" ||
+        element_name == "Condition" || element_name == "SubTree")
+    {
+        ID = element->Attribute("ID");
+    }
+
+    if (IDs.insert(ID).second && tree_roots.count(ID) != 0)
+    {
+        collectUsedIDs(tree_roots[ID]->FirstChildElement(), IDs);
+    }
+
+    for (auto child = element->FirstChildElement(); child; child = child->NextSiblingElement())
+    {
+        collectUsedIDs(child, IDs);
+    }
+}
+
 TreeNode::Ptr XMLParser::Pimpl::buildNodeFromElement(const XMLElement *element,
                                                      TreeNode::Ptr parent)
 {
@@ -463,7 +503,7 @@ TreeNode::Ptr XMLParser::Pimpl::buildNodeFromElement(const XMLElement *element,
         const std::string attribute_name = att->Name();
         if (attribute_name != "ID" && attribute_name != "name")
         {
-            params[attribute_name] = att->Value();
+            params.set(attribute_name, att->Value());
         }
     }
 
@@ -521,6 +561,55 @@ Tree buildTreeFromFile(const BehaviorTreeFactory& factory, const std::string& fi
     return Tree(root.get(), nodes);
 }
 
+Tree Tree::clone(const Blackboard::Ptr& blackboard) const
+{
+    Tree tree;
+    if (!root_node)
+    {
+        return tree;
+    }
+
+    std::unordered_map<const TreeNode*, TreeNode*> cloned_nodes;
+    cloned_nodes.reserve(nodes.size());
+    tree.nodes.reserve(nodes.size());
+
+    for (const auto& node : nodes)
+    {
+        TreeNode::Ptr new_node = node->clone();
+        new_node->setTreeUID(node->UID());
+        new_node->setBlackboard(blackboard);
+        new_node->initializeOnce();
+        cloned_nodes[node.get()] = new_node.get();
+        tree.nodes.push_back(std::move(new_node));
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        const TreeNode* node = nodes[i].get();
+        TreeNode* new_node = tree.nodes[i].get();
+
+        if (auto control = dynamic_cast<const ControlNode*>(node))
+        {
+            auto new_control = static_cast<ControlNode*>(new_node);
+            for (const TreeNode* child : control->children())
+            {
+                new_control->addChild(cloned_nodes.at(child));
+            }
+        }
+        else if (auto decorator = dynamic_cast<const DecoratorNode*>(node))
+        {
+            if (decorator->child())
+            {
+                auto new_decorator = static_cast<DecoratorNode*>(new_node);
+                new_decorator->setChild(cloned_nodes.at(decorator->child()));
+            }
+        }
+    }
+
+    tree.root_node = cloned_nodes.at(root_node);
+    return tree;
+}
+
 std::string writeXML(const BehaviorTreeFactory& factory,
                      const TreeNode* root_node,
                      bool compact_representation)
@@ -528,6 +617,7 @@ std::string writeXML(const BehaviorTreeFactory& factory,
     using namespace tinyxml2;
 
     XMLDocument doc;
+    const std::vector<TreeNodeManifest> manifests = factory.manifests();
 
     XMLElement* rootXML = doc.NewElement("root");
     doc.InsertFirstChild(rootXML);
@@ -540,7 +630,7 @@ std::string writeXML(const BehaviorTreeFactory& factory,
         std::function<void(const TreeNode*, XMLElement* parent)> recursiveVisitor;
 
         recursiveVisitor = [&recursiveVisitor, &doc, compact_representation,
-                &factory](const TreeNode* node, XMLElement* parent) -> void {
+                &manifests](const TreeNode* node, XMLElement* parent) -> void {
             std::string node_type = toStr(node->type());
             std::string node_ID = node->registrationName();
             std::string node_name = node->name();
@@ -551,7 +641,7 @@ std::string writeXML(const BehaviorTreeFactory& factory,
             }
             else if (compact_representation)
             {
-                for (const auto& model : factory.manifests())
+                for (const auto& model : manifests)
                 {
                     if (model.registration_ID == node_ID)
                     {
@@ -598,7 +688,7 @@ std::string writeXML(const BehaviorTreeFactory& factory,
     XMLElement* model_root = doc.NewElement("TreeNodesModel");
     rootXML->InsertEndChild(model_root);
 
-    for (auto& model : factory.manifests())
+    for (auto& model : manifests)
     {
         if( factory.builtinNodes().count( model.registration_ID ) != 0)
         {
@@ -626,5 +716,101 @@ std::string writeXML(const BehaviorTreeFactory& factory,
     return std::string(printer.CStr(), printer.CStrSize() - 1);
 }
 
+std::string writePluginManifestCache(const std::vector<PluginManifest>& plugins)
+{
+    XMLDocument doc;
+
+    XMLElement* rootXML = doc.NewElement("root");
+    doc.InsertFirstChild(rootXML);
+
+    for (const auto& plugin : plugins)
+    {
+        XMLElement* plugin_element = doc.NewElement("Plugin");
+        plugin_element->SetAttribute("path", plugin.path.c_str());
+        rootXML->InsertEndChild(plugin_element);
+
+        for (const auto& model : plugin.manifests)
+        {
+            XMLElement* element = doc.NewElement(toStr(model.type));
+            element->SetAttribute("ID", model.registration_ID.c_str());
+
+            for (const auto& param : model.required_parameters)
+            {
+                element->SetAttribute(param.first.c_str(), param.second.c_str());
+            }
+            plugin_element->InsertEndChild(element);
+        }
+    }
+
+    XMLPrinter printer;
+    doc.Print(&printer);
+    return std::string(printer.CStr(), printer.CStrSize() - 1);
+}
+
+void registerFromManifestCache(BehaviorTreeFactory& factory, const std::string& filename)
+{
+    XMLDocument doc;
+    doc.LoadFile(filename.c_str());
+    if (doc.Error())
+    {
+        char buffer[200];
+        sprintf(buffer, "Error parsing the manifest cache: %s", doc.ErrorName());
+        throw std::runtime_error(buffer);
+    }
+
+    const XMLElement* xml_root = doc.RootElement();
+    if (!xml_root || strcmp(xml_root->Name(), "root") != 0)
+    {
+        throw std::runtime_error("The manifest cache must have a root node called <root>");
+    }
+
+    const filesystem::path cache_folder = filesystem::path(filename).parent_path();
+
+    for (auto plugin_element = xml_root->FirstChildElement("Plugin"); plugin_element != nullptr;
+         plugin_element = plugin_element->NextSiblingElement("Plugin"))
+    {
+        const char* path_attr = plugin_element->Attribute("path");
+        if (!path_attr)
+        {
+            throw std::runtime_error("The node <Plugin> must have the attribute [path]");
+        }
+
+        // Relative paths are relative to the folder of the cache, while plain
+        // library names are left to the search rules of the dynamic linker.
+        PluginManifest plugin;
+        plugin.path = path_attr;
+        filesystem::path plugin_path(plugin.path);
+        if (!plugin_path.is_absolute() && plugin.path.find('/') != std::string::npos &&
+            !cache_folder.empty())
+        {
+            plugin.path = (cache_folder / plugin_path).str();
+        }
+
+        for (auto element = plugin_element->FirstChildElement(); element != nullptr;
+             element = element->NextSiblingElement())
+        {
+            TreeNodeManifest manifest;
+            manifest.type = convertFromString<NodeType>(element->Name());
+            manifest.registration_ID = element->Attribute("ID") ? element->Attribute("ID") : "";
+            if (manifest.registration_ID.empty())
+            {
+                char buffer[200];
+                sprintf(buffer, "Error at line %d: -> The attribute [ID] is mandatory",
+                        element->GetLineNum());
+                throw std::runtime_error(buffer);
+            }
+            for (const XMLAttribute* att = element->FirstAttribute(); att; att = att->Next())
+            {
+                if (strcmp(att->Name(), "ID") != 0)
+                {
+                    manifest.required_parameters.set(att->Name(), att->Value());
+                }
+            }
+            plugin.manifests.push_back(std::move(manifest));
+        }
+        factory.registerDeferredPlugin(plugin);
+    }
+}
+
 
 }
@@ -1,107 +1,297 @@
 #include <stdio.h>
-#include <iostream>
-#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <queue>
 #include <unordered_map>
-#include "behaviortree_cpp/loggers/BT_logger_generated.h"
+#include "behaviortree_cpp/loggers/bt_log_reader.h"
 
-int main(int argc, char* argv[])
+static void printUsage(const char* program)
 {
-    if (argc != 2)
+    printf("Usage: %s [options] filename\n\n"
+           "Options:\n"
+           "  --from SEC      skip the transitions before this timestamp (seconds)\n"
+           "  --to SEC        skip the transitions after this timestamp (seconds)\n"
+           "  --uid UID       only the transitions of this node (repeatable)\n"
+           "  --name NAME     only the transitions of the nodes with this name (repeatable)\n"
+           "  --status STATUS only the transitions to IDLE, RUNNING, SUCCESS or FAILURE "
+           "(repeatable)\n"
+           "  --summary       print the time spent in RUNNING and the results of each node\n"
+           "  --longest N     print the N longest executions of the actions\n",
+           program);
+}
+
+static const char* printStatus(BT::NodeStatus status)
+{
+    switch (status)
     {
-        printf("Wrong number of arguments\nUsage: %s [filename]\n", argv[0]);
-        return 1;
+        case BT::NodeStatus::SUCCESS:
+            return ("\x1b[32m"
+                    "SUCCESS"
+                    "\x1b[0m");   // GREEN
+        case BT::NodeStatus::FAILURE:
+            return ("\x1b[31m"
+                    "FAILURE"
+                    "\x1b[0m");   // RED
+        case BT::NodeStatus::RUNNING:
+            return ("\x1b[33m"
+                    "RUNNING"
+                    "\x1b[0m");   // YELLOW
+        case BT::NodeStatus::IDLE:
+            return ("\x1b[36m"
+                    "IDLE   "
+                    "\x1b[0m");   // CYAN
     }
+    return "Undefined";
+}
 
-    FILE* file = fopen(argv[1], "rb");
+struct NodeStats
+{
+    NodeStats()
+      : running_since(0), is_running(false), running_usec(0), runs(0), success(0), failure(0)
+    {
+    }
+    uint64_t running_since;
+    bool is_running;
+    uint64_t running_usec;
+    size_t runs;
+    size_t success;
+    size_t failure;
+};
 
-    if (!file)
+struct Execution
+{
+    uint64_t duration_usec;
+    uint64_t start_usec;
+    uint16_t uid;
+
+    // std::priority_queue keeps the largest on top: we want the smallest
+    bool operator<(const Execution& other) const
     {
-        printf("Failed to open file: [%s]\n", argv[1]);
-        return 1;
+        return duration_usec > other.duration_usec;
     }
+};
 
-    fseek(file, 0L, SEEK_END);
-    const size_t length = ftell(file);
-    fseek(file, 0L, SEEK_SET);
-    std::vector<char> buffer(length);
-    fread(buffer.data(), sizeof(char), length, file);
-    fclose(file);
+int main(int argc, char* argv[])
+{
+    BT::LogFilter filter;
+    std::vector<std::string> names;
+    bool summary = false;
+    size_t longest = 0;
+    const char* filename = nullptr;
 
-    const int bt_header_size = flatbuffers::ReadScalar<uint32_t>(&buffer[0]);
+    for (int i = 1; i < argc; i++)
+    {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--from") == 0 && has_value)
+        {
+            filter.from_usec = static_cast<uint64_t>(atof(argv[++i]) * 1e6);
+        }
+        else if (strcmp(argv[i], "--to") == 0 && has_value)
+        {
+            filter.to_usec = static_cast<uint64_t>(atof(argv[++i]) * 1e6);
+        }
+        else if (strcmp(argv[i], "--uid") == 0 && has_value)
+        {
+            filter.uids.push_back(static_cast<uint16_t>(atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "--name") == 0 && has_value)
+        {
+            names.push_back(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--status") == 0 && has_value)
+        {
+            try
+            {
+                filter.onlyStatus(BT::convertFromString<BT::NodeStatus>(argv[++i]));
+            }
+            catch (std::exception& err)
+            {
+                printf("%s\n", err.what());
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--summary") == 0)
+        {
+            summary = true;
+        }
+        else if (strcmp(argv[i], "--longest") == 0 && has_value)
+        {
+            longest = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else if (argv[i][0] != '-' && !filename)
+        {
+            filename = argv[i];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
 
-    auto behavior_tree = BT_Serialization::GetBehaviorTree(&buffer[4]);
+    if (!filename)
+    {
+        printf("Wrong number of arguments\n");
+        printUsage(argv[0]);
+        return 1;
+    }
 
-    std::unordered_map<uint16_t, std::string> names_by_uid;
-    std::unordered_map<uint16_t, const BT_Serialization::TreeNode*> node_by_uid;
+    std::unique_ptr<BT::LogReader> reader;
+    try
+    {
+        reader.reset(new BT::LogReader(filename));
+    }
+    catch (std::exception& err)
+    {
+        printf("Failed to open file [%s]: %s\n", filename, err.what());
+        return 1;
+    }
 
-    for (const BT_Serialization::TreeNode* node : *(behavior_tree->nodes()))
+    for (const std::string& name : names)
     {
-        names_by_uid.insert({node->uid(), std::string(node->instance_name()->c_str())});
-        node_by_uid.insert({node->uid(), node});
+        const std::vector<uint16_t> uids = reader->findUIDs(name);
+        if (uids.empty())
+        {
+            printf("No node called [%s]\n", name.c_str());
+            return 1;
+        }
+        filter.uids.insert(filter.uids.end(), uids.begin(), uids.end());
     }
 
-    printf("----------------------------\n");
+    // labels are computed once: the name indented by depth and padded to a fixed width
+    constexpr const size_t label_width = 25;
+    std::unordered_map<uint16_t, std::string> labels;
+    std::vector<std::pair<uint16_t, int>> stack = {{reader->rootUID(), 0}};
 
-    std::function<void(uint16_t, int)> recursiveStep;
+    printf("----------------------------\n");
+    while (!stack.empty())
+    {
+        const uint16_t uid = stack.back().first;
+        const int depth = stack.back().second;
+        stack.pop_back();
 
-    recursiveStep = [&](uint16_t uid, int indent) {
-        for (int i = 0; i < indent; i++)
+        const BT::LogReader::Node* node = nullptr;
+        try
         {
-            printf("    ");
-            names_by_uid[uid] = std::string("   ") + names_by_uid[uid];
+            node = &reader->node(uid);
         }
-        printf("%s\n", names_by_uid[uid].c_str());
-        std::cout << std::flush;
+        catch (std::out_of_range&)
+        {
+            continue;
+        }
+        printf("%s%s\n", std::string(depth * 4, ' ').c_str(), node->instance_name.c_str());
 
-        const auto& node = node_by_uid[uid];
+        std::string label = std::string(depth * 3, ' ') + node->instance_name;
+        label.resize(std::max(label.size(), label_width), ' ');
+        labels[uid] = std::move(label);
 
-        for (size_t i = 0; i < node->children_uid()->size(); i++)
+        for (auto it = node->children_uid.rbegin(); it != node->children_uid.rend(); ++it)
         {
-            recursiveStep(node->children_uid()->Get(i), indent + 1);
+            stack.push_back({*it, depth + 1});
         }
+    }
+    printf("----------------------------\n");
+
+    const bool print_transitions = !summary && longest == 0;
+    std::unordered_map<uint16_t, NodeStats> stats;
+    std::priority_queue<Execution> longest_executions;
+    uint64_t last_timestamp = 0;
+
+    auto label = [&](uint16_t uid) -> const char* {
+        auto it = labels.find(uid);
+        return (it != labels.end()) ? it->second.c_str() : "?";
     };
 
-    recursiveStep(behavior_tree->root_uid(), 0);
+    // single pass on the file
+    reader->forEach(filter, [&](const BT::LogTransition& transition) {
+        if (print_transitions)
+        {
+            printf("[%d.%06d]: %s %s -> %s\n",
+                   static_cast<uint32_t>(transition.timestamp_usec / 1000000),
+                   static_cast<uint32_t>(transition.timestamp_usec % 1000000),
+                   label(transition.uid), printStatus(transition.prev_status),
+                   printStatus(transition.status));
+            return true;
+        }
+        last_timestamp = std::max(last_timestamp, transition.timestamp_usec);
+        NodeStats& node_stats = stats[transition.uid];
 
-    printf("----------------------------\n");
+        if (transition.status == BT::NodeStatus::SUCCESS)
+        {
+            node_stats.success++;
+        }
+        else if (transition.status == BT::NodeStatus::FAILURE)
+        {
+            node_stats.failure++;
+        }
 
-    constexpr const char* whitespaces = "                         ";
-    constexpr const size_t ws_count = 25;
-
-    auto printStatus = [](BT_Serialization::Status status) {
-        switch (status)
-        {
-            case BT_Serialization::Status::SUCCESS:
-                return ("\x1b[32m"
-                        "SUCCESS"
-                        "\x1b[0m");   // RED
-            case BT_Serialization::Status::FAILURE:
-                return ("\x1b[31m"
-                        "FAILURE"
-                        "\x1b[0m");   // GREEN
-            case BT_Serialization::Status::RUNNING:
-                return ("\x1b[33m"
-                        "RUNNING"
-                        "\x1b[0m");   // YELLOW
-            case BT_Serialization::Status::IDLE:
-                return ("\x1b[36m"
-                        "IDLE   "
-                        "\x1b[0m");   // CYAN
-        }
-        return "Undefined";
-    };
+        if (transition.status == BT::NodeStatus::RUNNING && !node_stats.is_running)
+        {
+            node_stats.is_running = true;
+            node_stats.running_since = transition.timestamp_usec;
+            node_stats.runs++;
+        }
+        else if (transition.status != BT::NodeStatus::RUNNING && node_stats.is_running)
+        {
+            node_stats.is_running = false;
+            const uint64_t duration = transition.timestamp_usec - node_stats.running_since;
+            node_stats.running_usec += duration;
 
-    for (size_t index = bt_header_size + 4; index < length; index += 12)
+            if (longest > 0 && reader->node(transition.uid).type == BT::NodeType::ACTION)
+            {
+                longest_executions.push({duration, node_stats.running_since, transition.uid});
+                if (longest_executions.size() > longest)
+                {
+                    longest_executions.pop();
+                }
+            }
+        }
+        return true;
+    });
+
+    if (summary)
     {
-        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[index + 8]);
-        const std::string& name = names_by_uid[uid];
-        const uint32_t t_sec = flatbuffers::ReadScalar<uint32_t>(&buffer[index]);
-        const uint32_t t_usec = flatbuffers::ReadScalar<uint32_t>(&buffer[index + 4]);
-
-        printf("[%d.%06d]: %s%s %s -> %s\n", t_sec, t_usec, name.c_str(),
-               &whitespaces[std::min(ws_count, name.size())],
-               printStatus(flatbuffers::ReadScalar<BT_Serialization::Status>(&buffer[index + 10])),
-               printStatus(flatbuffers::ReadScalar<BT_Serialization::Status>(&buffer[index + 11])));
+        printf("%-*s %-10s %12s %8s %8s %8s\n", static_cast<int>(label_width), "node", "type",
+               "running[s]", "runs", "success", "failure");
+
+        for (const BT::LogReader::Node& node : reader->nodes())
+        {
+            auto it = stats.find(node.uid);
+            if (it == stats.end())
+            {
+                continue;
+            }
+            NodeStats& node_stats = it->second;
+            if (node_stats.is_running)
+            {
+                node_stats.running_usec += last_timestamp - node_stats.running_since;
+            }
+            printf("%s %-10s %12.6f %8zu %8zu %8zu\n", label(node.uid), BT::toStr(node.type),
+                   node_stats.running_usec * 1e-6, node_stats.runs, node_stats.success,
+                   node_stats.failure);
+        }
+        printf("----------------------------\n");
+    }
+
+    if (longest > 0)
+    {
+        std::vector<Execution> executions;
+        while (!longest_executions.empty())
+        {
+            executions.push_back(longest_executions.top());
+            longest_executions.pop();
+        }
+        printf("%-*s %12s %20s\n", static_cast<int>(label_width), "action", "duration[s]",
+               "started at");
+        for (auto it = executions.rbegin(); it != executions.rend(); ++it)
+        {
+            printf("%-*s %12.6f %13d.%06d\n", static_cast<int>(label_width),
+                   reader->node(it->uid).instance_name.c_str(), it->duration_usec * 1e-6,
+                   static_cast<uint32_t>(it->start_usec / 1000000),
+                   static_cast<uint32_t>(it->start_usec % 1000000));
+        }
     }
 
     return 0;
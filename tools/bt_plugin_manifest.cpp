@@ -1,33 +1,74 @@
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
 #include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/xml_parsing.h"
 
-int main(int argc, char* argv[])
+// Manifests of the TreeNodes registered by a plugin, excluding the builtin ones.
+static BT::PluginManifest getPluginManifest(const char* plugin_path)
 {
-    if (argc != 2)
-    {
-        printf("Wrong number of arguments\nUsage: %s [filename]\n", argv[0]);
-        return 1;
-    }
-
     BT::BehaviorTreeFactory factory;
+    factory.registerFromPlugin(plugin_path);
+
+    BT::PluginManifest plugin;
+    plugin.path = plugin_path;
 
-    std::set<std::string> default_nodes;
     for (auto& manifest : factory.manifests())
     {
-        default_nodes.insert(manifest.registration_ID);
+        if (factory.builtinNodes().count(manifest.registration_ID) == 0)
+        {
+            plugin.manifests.push_back(manifest);
+        }
     }
+    return plugin;
+}
 
-    factory.registerFromPlugin(argv[1]);
+static void printUsage(const char* program)
+{
+    printf("Wrong number of arguments\n"
+           "Usage: %s [filename]\n"
+           "       %s --cache [output_file] [plugin_1] ... [plugin_N]\n",
+           program, program);
+}
 
-    for (auto& manifest : factory.manifests())
+int main(int argc, char* argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "--cache") == 0)
     {
-        if (default_nodes.count(manifest.registration_ID) > 0)
+        if (argc < 4)
         {
-            continue;
+            printUsage(argv[0]);
+            return 1;
         }
+
+        std::vector<BT::PluginManifest> plugins;
+        for (int i = 3; i < argc; i++)
+        {
+            plugins.push_back(getPluginManifest(argv[i]));
+        }
+
+        std::ofstream file_os(argv[2]);
+        if (!file_os)
+        {
+            printf("Failed to open file: [%s]\n", argv[2]);
+            return 1;
+        }
+        file_os << BT::writePluginManifestCache(plugins);
+        return 0;
+    }
+
+    if (argc != 2)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    BT::PluginManifest plugin = getPluginManifest(argv[1]);
+
+    for (auto& manifest : plugin.manifests)
+    {
         auto& params = manifest.required_parameters;
         std::cout << "---------------\n"
                   << manifest.registration_ID << " [" << manifest.type
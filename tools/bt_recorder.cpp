@@ -1,10 +1,13 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
 #include <signal.h>
 #include <zmq.hpp>
 #include <fstream>
 #include "behaviortree_cpp/loggers/BT_logger_generated.h"
+#include "behaviortree_cpp/loggers/bt_zmq_publisher.h"
 
 // http://zguide.zeromq.org/cpp:interrupt
 static bool s_interrupted = false;
@@ -26,11 +29,15 @@ static void CatchSignals(void)
 
 int main(int argc, char* argv[])
 {
-    if (argc != 2)
+    if (argc != 2 && argc != 3)
     {
-        printf("Wrong number of arguments\nUsage: %s [filename]\n", argv[0]);
+        printf("Wrong number of arguments\nUsage: %s [filename] [tree_id]\n"
+               "tree_id selects a tree of a multi-tree PublisherHub\n",
+               argv[0]);
         return 1;
     }
+    const bool multi_tree = (argc == 3);
+    const uint16_t tree_id = multi_tree ? static_cast<uint16_t>(atoi(argv[2])) : 0;
 
     // register CTRL+C signal handler
     CatchSignals();
@@ -43,20 +50,65 @@ int main(int argc, char* argv[])
     zmq::socket_t subscriber(context, ZMQ_SUB);
     subscriber.connect("tcp://localhost:1666");
 
-    //  Subscribe to everything
-    subscriber.setsockopt(ZMQ_SUBSCRIBE, "", 0);
+    // multi-tree hub: the first frame is [protocol version][tree ID]. Subscribe only to
+    // the messages of this tree. It is also the request of the tree to the server.
+    uint8_t id_frame[3];
+    id_frame[0] = BT::PublisherHub::MULTI_TREE_PROTOCOL_VERSION;
+    flatbuffers::WriteScalar<uint16_t>(id_frame + 1, tree_id);
+    if (multi_tree)
+    {
+        subscriber.setsockopt(ZMQ_SUBSCRIBE, id_frame, sizeof(id_frame));
+    }
+    else
+    {
+        subscriber.setsockopt(ZMQ_SUBSCRIBE, "", 0);
+    }
 
-    printf("----------- Started -----------------\n");
+    // the file starts with the serialized tree, as the one of FileLogger
+    zmq::socket_t requester(context, ZMQ_REQ);
+    requester.connect("tcp://localhost:1667");
+    zmq::message_t request(multi_tree ? sizeof(id_frame) : 0);
+    if (multi_tree)
+    {
+        memcpy(request.data(), id_frame, sizeof(id_frame));
+    }
+    zmq::message_t tree_msg;
+    try
+    {
+        requester.send(request);
+        requester.recv(&tree_msg);
+    }
+    catch (zmq::error_t& e)
+    {
+        std::cout << "request of the tree failed with exception: " << e.what() << std::endl;
+        return -1;
+    }
+    requester.close();
 
-    bool first_message = true;
-    std::ofstream file_os;
+    if (tree_msg.size() == 0)
+    {
+        printf("Tree [%d] not found\n", tree_id);
+        return 1;
+    }
+
+    std::ofstream file_os(argv[1], std::ofstream::binary | std::ofstream::out);
+    char tree_size[4];
+    flatbuffers::WriteScalar<uint32_t>(tree_size, tree_msg.size());
+    file_os.write(tree_size, sizeof(tree_size));
+    file_os.write(static_cast<char*>(tree_msg.data()), tree_msg.size());
+
+    printf("----------- Started -----------------\n");
 
     while (!s_interrupted)
     {
+        zmq::message_t id;
         zmq::message_t update;
-        zmq::message_t msg;
         try
         {
+            if (multi_tree)
+            {
+                subscriber.recv(&id);
+            }
             subscriber.recv(&update);
         }
         catch (zmq::error_t& e)
@@ -72,15 +124,6 @@ int main(int argc, char* argv[])
         {
             char* data_ptr = static_cast<char*>(update.data());
             const uint32_t header_size = flatbuffers::ReadScalar<uint32_t>(data_ptr);
-
-            if (first_message)
-            {
-                printf("First message received\n");
-                first_message = false;
-
-                file_os.open(argv[1], std::ofstream::binary | std::ofstream::out);
-                file_os.write(data_ptr, 4 + header_size);
-            }
             data_ptr += 4 + header_size;
 
             const uint32_t transition_count = flatbuffers::ReadScalar<uint32_t>(data_ptr);